@@ -60,6 +60,7 @@ cImage::~cImage()
 		delete[] pixels;
 }
 
+#ifdef _WIN32
 int cImage::CopyToDC(HDC dc, int x, int y, int w, int h)
 {
 	if( pixels == 0 )
@@ -87,6 +88,7 @@ void cImage::GetBitmapInfoHeader(BITMAPINFOHEADER *bmih)
 	bmih->biXPelsPerMeter = 0;
 	bmih->biYPelsPerMeter = 0;
 }
+#endif
 
 int cImage::Create(int w, int h)
 {
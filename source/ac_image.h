@@ -32,9 +32,9 @@
 #define EIMG_OUT_OF_MEMORY       -2
 #define EIMG_UNSUPPORTED_FORMAT  -3
 
-#include <windows.h>	// HDC
+#include "platform.h"
 
-typedef unsigned long PIXEL;
+typedef DWORD PIXEL;
 
 class cImage
 {
@@ -43,10 +43,12 @@ public:
 	cImage(int width, int height);
 	virtual ~cImage();
 
+#ifdef _WIN32
 	int CopyToDC(HDC dc, int x, int y, int w, int h);
+	void GetBitmapInfoHeader(BITMAPINFOHEADER *bmih);
+#endif
 
 	int Create(int w, int h);
-	void GetBitmapInfoHeader(BITMAPINFOHEADER *bmih);
 	void Clear(PIXEL color);
 
 	PIXEL *pixels;
@@ -31,6 +31,15 @@
 #include <stdio.h>      // _vsnprintf()
 #include "ac_string_util.h"
 
+#ifndef _WIN32
+#define _vsnprintf vsnprintf
+#endif
+
+// MSVC before 2013 doesn't have va_copy, but there va_list is a plain pointer
+#ifndef va_copy
+#define va_copy(dst, src) ((dst) = (src))
+#endif
+
 string acStringFormat(const char *format, ...)
 {
 	string ret;
@@ -38,10 +47,18 @@ string acStringFormat(const char *format, ...)
 	va_list args;
 	va_start(args, format);
 
+	// The argument list is copied for each attempt, as it 
+	// can't be reused after it has been consumed on all platforms
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+
 	char tmp[256];
-	int r = _vsnprintf(tmp, 255, format, args);
+	int r = _vsnprintf(tmp, 255, format, argsCopy);
+	va_end(argsCopy);
 
-	if( r > 0 )
+	// _vsnprintf returns -1 when the buffer is too small, 
+	// while vsnprintf returns the length needed
+	if( r >= 0 && r < 255 )
 	{
 		ret = tmp;
 	}
@@ -51,8 +68,15 @@ string acStringFormat(const char *format, ...)
 		string str; 
 		str.resize(n);
 
-		while( (r = _vsnprintf(&str[0], n, format, args)) < 0 )
+		for(;;)
 		{
+			va_copy(argsCopy, args);
+			r = _vsnprintf(&str[0], n, format, argsCopy);
+			va_end(argsCopy);
+
+			if( r >= 0 && r < n )
+				break;
+
 			n *= 2;
 			str.resize(n);
 		}
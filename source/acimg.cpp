@@ -25,12 +25,18 @@
    andreas@angelcode.com
 */
 
+// 2026-10-18 Fixed compile errors on GCC
 // 2009-04-12 Fixed compile errors on VC2008
 
 #include <stdio.h>
 #include <string.h>
 #include "acimg.h"
 
+#ifndef _WIN32
+#include <strings.h>
+#define _stricmp strcasecmp
+#endif
+
 namespace acImage
 {
 
@@ -27,7 +27,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#ifndef ACIMG_NO_SQUISH
 #include <squish.h>
+#endif
 #include "acimg.h"
 
 namespace acImage
@@ -116,6 +118,12 @@ int SaveDds(const char *filename, Image &image, DWORD flags)
 		return E_FORMAT_NOT_SUPPORTED;
 	}
 
+#ifdef ACIMG_NO_SQUISH
+	// The compressed formats need the squish library
+	if( flags != 0 )
+		return E_FORMAT_NOT_SUPPORTED;
+#endif
+
 	FILE *f = fopen(filename, "wb");
 	if( f == 0 )
 		return E_FILE_ERROR;
@@ -186,6 +194,7 @@ int SaveDds(const char *filename, Image &image, DWORD flags)
 		for( UINT y = 0; y < image.height; y++ )
 			fwrite(&image.data[y*image.pitch], image.width*pixelSize, 1, f);
 	}
+#ifndef ACIMG_NO_SQUISH
 	else
 	{
 		dds.dwFlags |= DDSD_LINEARSIZE;
@@ -269,6 +278,7 @@ int SaveDds(const char *filename, Image &image, DWORD flags)
 			}
 		}
 	}
+#endif
 
 	fclose(f);
 
@@ -336,6 +346,11 @@ int LoadDds(const char *filename, Image &image)
 	}
 	else if( dds.ddpfPixelFormat.dwFlags & DDPF_FOURCC )
 	{
+#ifdef ACIMG_NO_SQUISH
+		// The compressed formats need the squish library
+		fclose(f);
+		return E_FORMAT_NOT_SUPPORTED;
+#else
 		// Verify compression format
 		UINT blockSize;
 		UINT method;
@@ -403,6 +418,7 @@ int LoadDds(const char *filename, Image &image)
 				}
 			}
 		}
+#endif
 	}
 	else
 	{
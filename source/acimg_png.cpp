@@ -28,6 +28,7 @@
 #include <png.h>
 #include <vector>
 #include <stdio.h>
+#include <string.h>
 
 #include "acimg.h"
 
@@ -65,7 +66,7 @@ int SavePng(const char *filename, Image &image)
 	if( info == 0 )
 	{
 		fclose(f);
-		png_destroy_write_struct(&png, png_infopp_NULL);
+		png_destroy_write_struct(&png, (png_infopp)NULL);
 		return E_ERROR;
 	}
 
@@ -33,6 +33,7 @@
 // 2008-12-07 Added GetAttrAsBool
 // 2008-11-13 Added support for multiple attributes of the same name
 
+#include <string.h>
 #include "acutil_config.h"
 #include "acutil_log.h"
 
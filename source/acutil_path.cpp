@@ -25,13 +25,19 @@
    andreas@angelcode.com
 */
 
+// 2026-10-18  GetApplicationPath() and GetFullPath() also work on Linux
 // 2014-06-16  Updated to support build both for unicode and multibyte applications
 // 2013-06-15  Fixed GetFullPath() to handle relative base paths
 // 2013-06-15  Fixed crash in GetRelativePath() when both paths refer to same directory
 
 #include "acutil_path.h"
-#include <windows.h>
+#include "platform.h"
+
+#ifdef _WIN32
 #include "acwin_window.h"
+#else
+#include <limits.h>
+#endif
 
 using namespace std;
 
@@ -53,10 +59,18 @@ string ReplacePathSlashes(const string &path)
 string GetApplicationPath()
 {
 	// Get the full path of the application
+	string path;
+#ifdef _WIN32
 	TCHAR buffer[300];
 	GetModuleFileName(0, buffer, 300);
-	string path;
 	acWindow::ConvertTCharToUtf8(buffer, path);
+#else
+	char buffer[PATH_MAX];
+	ssize_t len = readlink("/proc/self/exe", buffer, PATH_MAX-1);
+	if( len < 0 ) len = 0;
+	buffer[len] = 0;
+	path = buffer;
+#endif
 
 	// Replace all backslashes with forward slashes
 	path = ReplacePathSlashes(path);
@@ -80,6 +94,7 @@ string GetFullPath(const string &base, const string &relative)
 		b = b.substr(0, pos+1);
 	}
 
+#ifdef _WIN32
 	// Get the drive letter from the base path
 	string drive, path;
 	int pos = b.find(":");
@@ -126,6 +141,28 @@ string GetFullPath(const string &base, const string &relative)
 		// Add the relative path to the base path
 		path += r;
 	}
+#else
+	// There are no drive letters, so paths starting with / are absolute
+	string path;
+	int pos;
+	if( r.length() > 0 && r[0] == '/' )
+		path = r;
+	else
+	{
+		if( b.length() > 0 && b[0] == '/' )
+			path = b;
+		else
+		{
+			// The base itself is a relative path so get the current working directory
+			char buf[PATH_MAX];
+			if( getcwd(buf, PATH_MAX) == 0 )
+				buf[0] = 0;
+			path = string(buf) + '/' + b;
+		}
+
+		path += r;
+	}
+#endif
 
 	// Remove any ../ in the path
 	for(;;)
@@ -150,7 +187,11 @@ string GetFullPath(const string &base, const string &relative)
 			break;
 	}
 
+#ifdef _WIN32
 	return drive + ":" + path;
+#else
+	return path;
+#endif
 }
 
 string GetRelativePath(const string &base, const string &relative)
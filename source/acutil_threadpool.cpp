@@ -0,0 +1,201 @@
+/*
+   AngelCode Tool Box Library
+   Copyright (c) 2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include "acutil_threadpool.h"
+
+using namespace std;
+
+namespace acUtility
+{
+
+CThreadPool::CThreadPool()
+{
+	numQueued  = 0;
+	nextWorker = 0;
+	stopping   = false;
+}
+
+CThreadPool::~CThreadPool()
+{
+	Stop();
+}
+
+int CThreadPool::Start(int numThreads)
+{
+	if( workers.size() )
+		return -1;
+
+	if( numThreads <= 0 )
+		numThreads = thread::hardware_concurrency();
+	if( numThreads <= 0 )
+		numThreads = 1;
+
+	stopping = false;
+
+	// All queues must exist before the first thread starts looking for work
+	for( int n = 0; n < numThreads; n++ )
+		workers.push_back(new SWorker);
+	for( int n = 0; n < numThreads; n++ )
+		workers[n]->thread = new thread(WorkerThread, this, n);
+
+	return 0;
+}
+
+void CThreadPool::Stop()
+{
+	{
+		unique_lock<mutex> guard(sleepLock);
+		stopping = true;
+		taskAvailable.notify_all();
+	}
+
+	for( unsigned int n = 0; n < workers.size(); n++ )
+	{
+		workers[n]->thread->join();
+		delete workers[n]->thread;
+	}
+	for( unsigned int n = 0; n < workers.size(); n++ )
+		delete workers[n];
+	workers.clear();
+}
+
+int CThreadPool::GetNumThreads() const
+{
+	return workers.size();
+}
+
+int CThreadPool::AddTask(CTaskGroup &group, TaskFunc_t func, void *arg, int worker)
+{
+	// Without any workers the task would never be executed
+	if( workers.size() == 0 )
+		return -1;
+
+	STask task;
+	task.func  = func;
+	task.arg   = arg;
+	task.group = &group;
+
+	if( worker < 0 || worker >= (int)workers.size() )
+	{
+		// The task comes from outside the pool
+		unique_lock<mutex> guard(sleepLock);
+		worker = nextWorker++ % workers.size();
+	}
+
+	group.numPending++;
+
+	{
+		unique_lock<mutex> guard(workers[worker]->lock);
+		workers[worker]->tasks.push_back(task);
+	}
+
+	numQueued++;
+
+	// Wake up a sleeping worker. The lock makes sure the worker  
+	// can't miss the notification between checking the number 
+	// of queued tasks and going to sleep
+	unique_lock<mutex> guard(sleepLock);
+	taskAvailable.notify_one();
+
+	return 0;
+}
+
+void CThreadPool::Wait(CTaskGroup &group)
+{
+	unique_lock<mutex> guard(sleepLock);
+	while( group.numPending > 0 )
+		allDone.wait(guard);
+}
+
+bool CThreadPool::PopTask(int worker, STask &task)
+{
+	SWorker *w = workers[worker];
+	unique_lock<mutex> guard(w->lock);
+	if( w->tasks.empty() )
+		return false;
+
+	// Take the newest task, as it is likely to use data that is still in the cache
+	task = w->tasks.back();
+	w->tasks.pop_back();
+	numQueued--;
+
+	return true;
+}
+
+bool CThreadPool::StealTask(int worker, STask &task)
+{
+	for( unsigned int n = 1; n < workers.size(); n++ )
+	{
+		SWorker *w = workers[(worker + n) % workers.size()];
+		unique_lock<mutex> guard(w->lock);
+		if( w->tasks.empty() )
+			continue;
+
+		// Steal the oldest task, as it is likely to be the largest piece of work
+		task = w->tasks.front();
+		w->tasks.pop_front();
+		numQueued--;
+
+		return true;
+	}
+
+	return false;
+}
+
+void CThreadPool::WorkerThread(CThreadPool *pool, int worker)
+{
+	for(;;)
+	{
+		STask task;
+		if( pool->PopTask(worker, task) || pool->StealTask(worker, task) )
+		{
+			task.func(task.arg, worker);
+
+			// The group may be destroyed as soon as the count reaches 0
+			if( --task.group->numPending == 0 )
+			{
+				unique_lock<mutex> guard(pool->sleepLock);
+				pool->allDone.notify_all();
+			}
+
+			continue;
+		}
+
+		// Sleep until there is more work. The queued tasks are 
+		// finished before the thread stops
+		unique_lock<mutex> guard(pool->sleepLock);
+		if( pool->numQueued == 0 )
+		{
+			if( pool->stopping )
+				return;
+
+			pool->taskAvailable.wait(guard);
+		}
+	}
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+   AngelCode Tool Box Library
+   Copyright (c) 2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef ACUTIL_THREADPOOL_H
+#define ACUTIL_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace acUtility
+{
+
+// The task function receives the index of the worker thread that 
+// executes it, so the caller can keep per-thread resources
+typedef void (*TaskFunc_t)(void *arg, int worker);
+
+// Counts the tasks that a caller has queued, including the tasks added by 
+// those tasks, so the caller can wait for its own work while other callers 
+// keep using the same pool. The group must outlive its tasks.
+class CTaskGroup
+{
+public:
+	CTaskGroup() { numPending = 0; }
+
+protected:
+	friend class CThreadPool;
+	std::atomic<int> numPending;
+};
+
+// Each worker thread has its own task queue. A worker takes the most 
+// recently added task from its own queue, and when the queue is empty 
+// it steals the oldest task from one of the other workers' queues. This 
+// keeps all threads busy even when the cost of the tasks varies a lot.
+class CThreadPool
+{
+public:
+	CThreadPool();
+	~CThreadPool();
+
+	// Starts the worker threads. If numThreads is 0 one 
+	// thread will be started for each hardware thread
+	int  Start(int numThreads = 0);
+	void Stop();
+	int  GetNumThreads() const;
+
+	// Queues a task for execution. Tasks that add new tasks should pass their 
+	// own worker index so the new task is placed in that worker's queue. Tasks 
+	// added from other threads are distributed evenly over the workers. The 
+	// pool must be started first, as Start isn't safe to call while other 
+	// threads are adding tasks. Returns -1 if the pool hasn't been started.
+	int  AddTask(CTaskGroup &group, TaskFunc_t func, void *arg, int worker = -1);
+
+	// Blocks until all the tasks in the group have been completed
+	void Wait(CTaskGroup &group);
+
+protected:
+	struct STask
+	{
+		TaskFunc_t  func;
+		void       *arg;
+		CTaskGroup *group;
+	};
+
+	struct SWorker
+	{
+		std::thread       *thread;
+		std::mutex         lock;
+		std::deque<STask>  tasks;
+	};
+
+	static void WorkerThread(CThreadPool *pool, int worker);
+	bool PopTask(int worker, STask &task);
+	bool StealTask(int worker, STask &task);
+
+	std::vector<SWorker *>  workers;
+	std::atomic<int>        numQueued;
+	unsigned int            nextWorker;
+	bool                    stopping;
+
+	std::mutex              sleepLock;
+	std::condition_variable taskAvailable;
+	std::condition_variable allDone;
+};
+
+}
+
+#endif
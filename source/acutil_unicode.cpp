@@ -25,6 +25,7 @@
    andreas@angelcode.com
 */
 
+// 2026-10-18 - Renamed LITTLE_ENDIAN and BIG_ENDIAN as they clash with the macros in glibc
 // 2009-07-25 - Changed all buffers from char* to unsigned char*
 
 #include "acutil_unicode.h"
@@ -136,7 +137,7 @@ int DecodeUTF16(const unsigned char *encodedBuffer, unsigned int *outLength, EUn
 {
 	const unsigned char *buf = (const unsigned char *)encodedBuffer;
 	int value = 0;
-	if( byteOrder == LITTLE_ENDIAN )
+	if( byteOrder == UTF16_LITTLE_ENDIAN )
 	{
 		value += buf[0];
 		value += (unsigned int)(buf[1]) << 8; 
@@ -159,7 +160,7 @@ int DecodeUTF16(const unsigned char *encodedBuffer, unsigned int *outLength, EUn
 
 		// Read the second surrogate word
 		int value2 = 0;
-		if( byteOrder == LITTLE_ENDIAN )
+		if( byteOrder == UTF16_LITTLE_ENDIAN )
 		{
 			value2 += buf[2];
 			value2 += (unsigned int)(buf[3]) << 8; 
@@ -187,7 +188,7 @@ int EncodeUTF16(unsigned int value, unsigned char *outEncodedBuffer, unsigned in
 {
 	if( value < 0x10000 )
 	{
-		if( byteOrder == LITTLE_ENDIAN )
+		if( byteOrder == UTF16_LITTLE_ENDIAN )
 		{
 			outEncodedBuffer[0] = (value & 0xFF);
 			outEncodedBuffer[1] = ((value >> 8) & 0xFF);
@@ -207,7 +208,7 @@ int EncodeUTF16(unsigned int value, unsigned char *outEncodedBuffer, unsigned in
 		int surrogate1 = ((value >> 10) & 0x3FF) + 0xD800;
 		int surrogate2 = (value & 0x3FF) + 0xDC00;
 
-		if( byteOrder == LITTLE_ENDIAN )
+		if( byteOrder == UTF16_LITTLE_ENDIAN )
 		{
 			outEncodedBuffer[0] = (surrogate1 & 0xFF);
 			outEncodedBuffer[1] = ((surrogate1 >> 8) & 0xFF);
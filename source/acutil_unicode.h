@@ -25,6 +25,7 @@
    andreas@angelcode.com
 */
 
+// 2026-10-18 - Renamed LITTLE_ENDIAN and BIG_ENDIAN as they clash with the macros in glibc
 // 2009-07-25 - Changed all buffers from char* to unsigned char*
 
 #ifndef ACUTIL_UNICODE_H
@@ -35,8 +36,8 @@ namespace acUtility
 
 enum EUnicodeByteOrder
 {
-	LITTLE_ENDIAN,
-	BIG_ENDIAN,
+	UTF16_LITTLE_ENDIAN,
+	UTF16_BIG_ENDIAN,
 };
 
 // This function will attempt to decode a UTF-8 encoded character in the buffer.
@@ -49,11 +50,11 @@ int EncodeUTF8(unsigned int value, unsigned char *outEncodedBuffer, unsigned int
 
 // This function will attempt to decode a UTF-16 encoded character in the buffer.
 // If the encoding is invalid, the function returns -1.
-int DecodeUTF16(const unsigned char *encodedBuffer, unsigned int *outCharLength, EUnicodeByteOrder byteOrder = LITTLE_ENDIAN);
+int DecodeUTF16(const unsigned char *encodedBuffer, unsigned int *outCharLength, EUnicodeByteOrder byteOrder = UTF16_LITTLE_ENDIAN);
 
 // This function will encode the value into the buffer.
 // If the value is invalid, the function returns -1, else the encoded length.
-int EncodeUTF16(unsigned int value, unsigned char *outEncodedBuffer, unsigned int *outCharLength, EUnicodeByteOrder byteOrder = LITTLE_ENDIAN);
+int EncodeUTF16(unsigned int value, unsigned char *outEncodedBuffer, unsigned int *outCharLength, EUnicodeByteOrder byteOrder = UTF16_LITTLE_ENDIAN);
 
 }
 
@@ -0,0 +1,285 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <string.h>
+#include "chartable.h"
+#include "fontchar.h"
+
+CCharSet::CCharSet()
+{
+	memset(blocks, 0, sizeof(blocks));
+	memset(fill, 0, sizeof(fill));
+	count = 0;
+}
+
+CCharSet::~CCharSet()
+{
+	SetAll(false);
+}
+
+bool CCharSet::Get(int ch) const
+{
+	if( ch < 0 || ch >= charTableSize )
+		return false;
+
+	const unsigned int *block = blocks[ch>>blockBits];
+	if( block == 0 )
+		return fill[ch>>blockBits];
+
+	int bit = ch & (blockSize-1);
+	return (block[bit>>5] & (1u<<(bit&31))) ? true : false;
+}
+
+void CCharSet::Set(int ch, bool value)
+{
+	if( ch < 0 || ch >= charTableSize )
+		return;
+
+	unsigned int *block = blocks[ch>>blockBits];
+	if( block == 0 )
+	{
+		// Nothing changes if the whole block already has this value
+		if( fill[ch>>blockBits] == value )
+			return;
+
+		block = new unsigned int[blockWords];
+		memset(block, fill[ch>>blockBits] ? 0xFF : 0, blockWords*sizeof(unsigned int));
+		blocks[ch>>blockBits] = block;
+	}
+
+	int bit = ch & (blockSize-1);
+	unsigned int mask = 1u<<(bit&31);
+	if( ((block[bit>>5] & mask) ? true : false) != value )
+	{
+		if( value )
+		{
+			block[bit>>5] |= mask;
+			count++;
+		}
+		else
+		{
+			block[bit>>5] &= ~mask;
+			count--;
+		}
+	}
+}
+
+void CCharSet::SetAll(bool value)
+{
+	for( int n = 0; n < numBlocks; n++ )
+	{
+		if( blocks[n] )
+		{
+			delete[] blocks[n];
+			blocks[n] = 0;
+		}
+		fill[n] = value;
+	}
+
+	count = value ? charTableSize : 0;
+}
+
+int CCharSet::GetCount() const
+{
+	return count;
+}
+
+int CCharSet::Next(int ch) const
+{
+	if( ch < 0 ) ch = 0;
+
+	while( ch < charTableSize )
+	{
+		const unsigned int *block = blocks[ch>>blockBits];
+		if( block == 0 )
+		{
+			if( fill[ch>>blockBits] )
+				return ch;
+
+			// Skip to the next block
+			ch = ((ch>>blockBits)+1)<<blockBits;
+			continue;
+		}
+
+		// Skip the words that have no bits set
+		int bit = ch & (blockSize-1);
+		unsigned int word = block[bit>>5] >> (bit&31);
+		if( word == 0 )
+		{
+			ch = (ch & ~31) + 32;
+			continue;
+		}
+
+		while( !(word & 1) )
+		{
+			word >>= 1;
+			ch++;
+		}
+		return ch;
+	}
+
+	return -1;
+}
+
+CCharTable::CCharTable()
+{
+	memset(planes, 0, sizeof(planes));
+}
+
+CCharTable::~CCharTable()
+{
+	DeleteAll();
+}
+
+CFontChar **CCharTable::GetBlock(int ch, bool allocate)
+{
+	if( ch < 0 || ch >= charTableSize )
+		return 0;
+
+	CFontChar ***plane = planes[ch>>16];
+	if( plane == 0 )
+	{
+		if( !allocate ) 
+			return 0;
+
+		plane = new CFontChar**[planeSize];
+		memset(plane, 0, planeSize*sizeof(CFontChar**));
+		planes[ch>>16] = plane;
+	}
+
+	CFontChar **block = plane[(ch & 0xFFFF)>>blockBits];
+	if( block == 0 )
+	{
+		if( !allocate )
+			return 0;
+
+		block = new CFontChar*[blockSize];
+		memset(block, 0, blockSize*sizeof(CFontChar*));
+		plane[(ch & 0xFFFF)>>blockBits] = block;
+	}
+
+	return block;
+}
+
+CFontChar *CCharTable::Get(int ch) const
+{
+	CFontChar **block = const_cast<CCharTable*>(this)->GetBlock(ch, false);
+	if( block == 0 )
+		return 0;
+
+	return block[ch & (blockSize-1)];
+}
+
+void CCharTable::Set(int ch, CFontChar *fontChar)
+{
+	// Don't allocate memory just to clear the entry
+	CFontChar **block = GetBlock(ch, fontChar != 0);
+	if( block == 0 )
+		return;
+
+	block[ch & (blockSize-1)] = fontChar;
+}
+
+int CCharTable::Reserve(int ch)
+{
+	if( GetBlock(ch, true) == 0 )
+		return -1;
+
+	return 0;
+}
+
+int CCharTable::Next(int ch) const
+{
+	if( ch < 0 ) ch = 0;
+
+	while( ch < charTableSize )
+	{
+		CFontChar ***plane = planes[ch>>16];
+		if( plane == 0 )
+		{
+			// Skip to the next plane
+			ch = ((ch>>16)+1)<<16;
+			continue;
+		}
+
+		CFontChar **block = plane[(ch & 0xFFFF)>>blockBits];
+		if( block == 0 )
+		{
+			// Skip to the next block
+			ch = ((ch>>blockBits)+1)<<blockBits;
+			continue;
+		}
+
+		for( int end = ((ch>>blockBits)+1)<<blockBits; ch < end; ch++ )
+		{
+			if( block[ch & (blockSize-1)] )
+				return ch;
+		}
+	}
+
+	return -1;
+}
+
+void CCharTable::DeleteAll()
+{
+	Free(true);
+}
+
+void CCharTable::RemoveAll()
+{
+	Free(false);
+}
+
+void CCharTable::Free(bool deleteChars)
+{
+	for( int p = 0; p < numPlanes; p++ )
+	{
+		if( planes[p] == 0 )
+			continue;
+
+		for( int b = 0; b < planeSize; b++ )
+		{
+			CFontChar **block = planes[p][b];
+			if( block == 0 )
+				continue;
+
+			if( deleteChars )
+			{
+				for( int n = 0; n < blockSize; n++ )
+				{
+					if( block[n] ) 
+						delete block[n];
+				}
+			}
+
+			delete[] block;
+		}
+
+		delete[] planes[p];
+		planes[p] = 0;
+	}
+}
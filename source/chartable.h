@@ -0,0 +1,120 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef CHARTABLE_H
+#define CHARTABLE_H
+
+class CFontChar;
+
+// The character tables cover the full Unicode range, but the
+// memory is only allocated for the blocks that are actually used
+
+static const int charTableSize = 0x110000;
+
+// Set of characters, stored as a bitset split in blocks of 4096 
+// characters. A block where all characters have the same state 
+// doesn't allocate any memory.
+class CCharSet
+{
+public:
+	CCharSet();
+	~CCharSet();
+
+	bool Get(int ch) const;
+	void Set(int ch, bool value);
+	void SetAll(bool value);
+	int  GetCount() const;
+
+	// Returns the first character in the set that is equal to or 
+	// greater than ch, or -1 if there are no more characters
+	int  Next(int ch) const;
+
+protected:
+	enum
+	{
+		blockBits  = 12,
+		blockSize  = 1<<blockBits,
+		blockWords = blockSize/32,
+		numBlocks  = charTableSize/blockSize
+	};
+
+	unsigned int *blocks[numBlocks];
+	bool          fill[numBlocks];
+	int           count;
+
+private:
+	CCharSet(const CCharSet &);
+	CCharSet &operator=(const CCharSet &);
+};
+
+// Map from character to the CFontChar objects, stored in a two level 
+// table with one entry per Unicode plane, and then blocks of 256 
+// characters within each plane. 
+class CCharTable
+{
+public:
+	CCharTable();
+	~CCharTable();
+
+	CFontChar *Get(int ch) const;
+	void       Set(int ch, CFontChar *fontChar);
+
+	// Allocates the storage for the character so it can later be set from 
+	// any thread without locking, as long as each thread sets different characters
+	int        Reserve(int ch);
+
+	// Returns the first character with a CFontChar that is equal to 
+	// or greater than ch, or -1 if there are no more characters
+	int        Next(int ch) const;
+
+	// Deletes all CFontChar objects and frees the memory
+	void       DeleteAll();
+
+	// Removes all characters and frees the memory, without deleting 
+	// the CFontChar objects, for when they are owned by someone else
+	void       RemoveAll();
+
+protected:
+	enum
+	{
+		blockBits = 8,
+		blockSize = 1<<blockBits,
+		numPlanes = charTableSize>>16,
+		planeSize = 0x10000>>blockBits
+	};
+
+	CFontChar **GetBlock(int ch, bool allocate);
+	void        Free(bool deleteChars);
+
+	CFontChar ***planes[numPlanes];
+
+private:
+	CCharTable(const CCharTable &);
+	CCharTable &operator=(const CCharTable &);
+};
+
+#endif
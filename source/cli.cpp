@@ -0,0 +1,219 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+// The command line tool generates fonts from a configuration file without 
+// the GUI. It only uses the generator core, so it has no window system 
+// startup cost and can be built on other platforms than Windows.
+
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <iostream>
+
+#include "fontbatch.h"
+
+#ifdef _WIN32
+#include "dynamic_funcs.h"
+#endif
+
+using namespace std;
+
+enum EExitCode
+{
+	e_exitSuccess       = 0,
+	e_exitInvalidArgs   = 1,
+	e_exitInputError    = 2,
+	e_exitGenerateError = 3,
+	e_exitSaveError     = 4
+};
+
+static void PrintUsage(ostream &out)
+{
+	out << "Usage: bmfont-cli -c <config.bmfc> -o <output.fnt> [options]" << endl
+	    << "       bmfont-cli -b <manifest.txt> [options]" << endl
+	    << endl
+	    << "Options:" << endl
+	    << "  -c, --config <file>  The font configuration file" << endl
+	    << "  -o, --output <file>  The font descriptor file to write. The textures are" << endl
+	    << "                       written next to it" << endl
+	    << "  -t, --text <file>    Also select all the characters used in the text file" << endl
+	    << "  -b, --batch <file>   Generate all the fonts listed in the manifest file, one" << endl
+	    << "                       job per line with the -c, -o, and -t options" << endl
+	    << "  -j, --threads <n>    The number of worker threads, instead of the threads" << endl
+	    << "                       option in the configuration. 0 is one per CPU" << endl
+	    << "  -q, --quiet          Only report errors" << endl
+	    << "  -h, --help           Show this help" << endl
+	    << endl
+	    << "Exit codes:" << endl
+	    << "  0  The font was generated" << endl
+	    << "  1  Invalid arguments, or the manifest couldn't be read" << endl
+	    << "  2  The configuration, font, or text file couldn't be read" << endl
+	    << "  3  The characters couldn't be generated" << endl
+	    << "  4  The font couldn't be saved" << endl
+	    << "In batch mode the exit code is that of the first job that failed." << endl;
+}
+
+// Matches the argument against the short and long name of an option that 
+// takes a value. The value can be given in the same argument, as in -ofile 
+// or --output=file, or in the next argument. Returns 1 if the option was 
+// matched, 0 if not, and -1 if the value is missing.
+static int GetOptionValue(int argc, char **argv, int &n, const char *shortName, const char *longName, string &value)
+{
+	const char *arg = argv[n];
+	const char *rest = 0;
+
+	size_t shortLen = strlen(shortName);
+	size_t longLen  = strlen(longName);
+	if( strncmp(arg, longName, longLen) == 0 && (arg[longLen] == 0 || arg[longLen] == '=') )
+		rest = arg[longLen] == '=' ? arg + longLen + 1 : arg + longLen;
+	else if( strncmp(arg, shortName, shortLen) == 0 )
+		rest = arg + shortLen;
+	else
+		return 0;
+
+	if( *rest )
+	{
+		value = rest;
+		return 1;
+	}
+
+	if( n + 1 >= argc )
+		return -1;
+
+	value = argv[++n];
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	string configFile;
+	string outputFile;
+	string textFile;
+	string batchFile;
+	string threads;
+	bool   quiet = false;
+
+	for( int n = 1; n < argc; n++ )
+	{
+		const char *arg = argv[n];
+		if( strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0 )
+		{
+			PrintUsage(cout);
+			return e_exitSuccess;
+		}
+
+		if( strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0 )
+		{
+			quiet = true;
+			continue;
+		}
+
+		int r;
+		if( (r = GetOptionValue(argc, argv, n, "-c", "--config", configFile)) == 0 &&
+			(r = GetOptionValue(argc, argv, n, "-o", "--output", outputFile)) == 0 &&
+			(r = GetOptionValue(argc, argv, n, "-t", "--text", textFile)) == 0 &&
+			(r = GetOptionValue(argc, argv, n, "-b", "--batch", batchFile)) == 0 &&
+			(r = GetOptionValue(argc, argv, n, "-j", "--threads", threads)) == 0 )
+		{
+			cerr << "Unknown argument '" << arg << "'." << endl << endl;
+			PrintUsage(cerr);
+			return e_exitInvalidArgs;
+		}
+
+		if( r < 0 )
+		{
+			cerr << "Missing value for '" << arg << "'." << endl;
+			return e_exitInvalidArgs;
+		}
+	}
+
+	CFontBatch batch;
+
+	if( threads != "" )
+	{
+		char *end;
+		long value = strtol(threads.c_str(), &end, 10);
+		if( *end != 0 || value < 0 )
+		{
+			cerr << "Invalid number of threads '" << threads << "'." << endl;
+			return e_exitInvalidArgs;
+		}
+		batch.SetNumThreads(int(value));
+	}
+
+	if( batchFile != "" )
+	{
+		if( configFile != "" || outputFile != "" || textFile != "" )
+		{
+			cerr << "The jobs in batch mode are given in the manifest file." << endl << endl;
+			PrintUsage(cerr);
+			return e_exitInvalidArgs;
+		}
+
+		string error;
+		if( batch.LoadManifest(batchFile, error) < 0 )
+		{
+			cerr << error << endl;
+			return e_exitInvalidArgs;
+		}
+	}
+	else
+	{
+		if( configFile == "" || outputFile == "" )
+		{
+			cerr << "Both the configuration file and the output file must be given." << endl << endl;
+			PrintUsage(cerr);
+			return e_exitInvalidArgs;
+		}
+
+		batch.AddJob(configFile, outputFile, textFile);
+	}
+
+#ifdef _WIN32
+	// The GDI backend uses functions that are loaded dynamically
+	Init();
+#endif
+
+	batch.Run(quiet);
+
+#ifdef _WIN32
+	Uninit();
+#endif
+
+	// Report the first job that failed
+	for( int n = 0; n < batch.GetNumJobs(); n++ )
+	{
+		switch( batch.GetJob(n).result )
+		{
+		case e_jobInputError:    return e_exitInputError;
+		case e_jobGenerateError: return e_exitGenerateError;
+		case e_jobSaveError:     return e_exitSaveError;
+		}
+	}
+
+	return e_exitSuccess;
+}
@@ -0,0 +1,163 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <math.h>
+#include <vector>
+#include "distfield.h"
+
+using namespace std;
+
+// Computes the lower envelope of the parabolas rooted at each sample 
+// in f, and then samples the envelope into d. v and z must hold n and 
+// n+1 elements.
+static void Transform1D(const float *f, int n, float *d, int *v, float *z)
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -DT_INF;
+	z[1] = DT_INF;
+
+	// The intersections are always above -DT_INF, so k never goes below 0
+	for( int q = 1; q < n; q++ )
+	{
+		float s = ((f[q] + float(q*q)) - (f[v[k]] + float(v[k]*v[k]))) / float(2*q - 2*v[k]);
+		while( s <= z[k] )
+		{
+			k--;
+			s = ((f[q] + float(q*q)) - (f[v[k]] + float(v[k]*v[k]))) / float(2*q - 2*v[k]);
+		}
+
+		k++;
+		v[k]   = q;
+		z[k]   = s;
+		z[k+1] = DT_INF;
+	}
+
+	k = 0;
+	for( int q = 0; q < n; q++ )
+	{
+		while( z[k+1] < float(q) )
+			k++;
+		int dx = q - v[k];
+		d[q] = float(dx*dx) + f[v[k]];
+	}
+}
+
+void SquaredDistanceTransform(float *grid, int width, int height)
+{
+	int size = width > height ? width : height;
+	vector<float> f(size), d(size), z(size+1);
+	vector<int>   v(size);
+
+	// Transform the columns. The columns without any shape 
+	// pixels are left as they are, since they stay at DT_INF
+	for( int x = 0; x < width; x++ )
+	{
+		bool empty = true;
+		for( int y = 0; y < height; y++ )
+		{
+			f[y] = grid[y*width+x];
+			if( f[y] < DT_INF ) empty = false;
+		}
+		if( empty )
+			continue;
+
+		Transform1D(&f[0], height, &d[0], &v[0], &z[0]);
+
+		for( int y = 0; y < height; y++ )
+			grid[y*width+x] = d[y];
+	}
+
+	// Then the rows
+	for( int y = 0; y < height; y++ )
+	{
+		float *row = grid + y*width;
+		for( int x = 0; x < width; x++ )
+			f[x] = row[x];
+
+		Transform1D(&f[0], width, row, &v[0], &z[0]);
+	}
+}
+
+void CreateSignedDistanceField(const unsigned char *src, int width, int height, int factor, int spread, unsigned char *dst)
+{
+	// Add room for the spread around the shape
+	int pad = spread*factor;
+	int w = width + 2*pad;
+	int h = height + 2*pad;
+
+	vector<float> toShape(w*h), toBackground(w*h);
+	for( int y = 0; y < h; y++ )
+	{
+		for( int x = 0; x < w; x++ )
+		{
+			int sx = x - pad, sy = y - pad;
+			bool inside = sx >= 0 && sx < width && sy >= 0 && sy < height && src[sy*width+sx] >= 128;
+			toShape[y*w+x]      = inside ? 0 : DT_INF;
+			toBackground[y*w+x] = inside ? DT_INF : 0;
+		}
+	}
+
+	SquaredDistanceTransform(&toShape[0], w, h);
+	SquaredDistanceTransform(&toBackground[0], w, h);
+
+	// The distances are measured between pixel centers, and the 
+	// edge is half way between the inside and outside pixels
+	for( int n = 0; n < w*h; n++ )
+	{
+		if( toShape[n] == 0 )
+			toShape[n] = sqrtf(toBackground[n]) - 0.5f;
+		else
+			toShape[n] = 0.5f - sqrtf(toShape[n]);
+	}
+
+	// Average the distances in each block and scale them to the destination pixels
+	int dstWidth  = (w + factor - 1) / factor;
+	int dstHeight = (h + factor - 1) / factor;
+	for( int y = 0; y < dstHeight; y++ )
+	{
+		for( int x = 0; x < dstWidth; x++ )
+		{
+			float sum = 0;
+			int count = 0;
+			for( int by = y*factor; by < (y+1)*factor && by < h; by++ )
+			{
+				for( int bx = x*factor; bx < (x+1)*factor && bx < w; bx++ )
+				{
+					sum += toShape[by*w+bx];
+					count++;
+				}
+			}
+
+			float dist = sum / count / factor;
+			int val = int(floorf(128 + dist*128/spread + 0.5f));
+			if( val < 0 ) val = 0;
+			else if( val > 255 ) val = 255;
+			dst[y*dstWidth+x] = (unsigned char)val;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef DISTFIELD_H
+#define DISTFIELD_H
+
+// Value used for the pixels that are not part of the shape
+const float DT_INF = 1e20f;
+
+// Computes the exact squared Euclidean distance from each pixel to the 
+// nearest pixel of the shape, in linear time (Felzenszwalb & Huttenlocher). 
+// On input the pixels in the shape must be 0 and all others DT_INF. 
+// Pixels that are not near any shape pixel stay close to DT_INF.
+void SquaredDistanceTransform(float *grid, int width, int height);
+
+// Computes the signed distance field of an image with 8 bit coverage, where 
+// the pixels with at least half coverage are inside the shape. The field is 
+// reduced by factor and has spread extra pixels on each side, so the 
+// destination must hold ceil(width/factor)+2*spread x ceil(height/factor)+2*spread 
+// pixels. The edge of the shape gets the value 128, and the values reach 255 
+// at spread pixels inside the shape and 0 at spread pixels outside.
+void CreateSignedDistanceField(const unsigned char *src, int width, int height, int factor, int spread, unsigned char *dst);
+
+#endif
@@ -0,0 +1,303 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <string.h>
+#include <vector>
+#include "downscale.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define DOWNSCALE_SIMD
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define AVX2_FUNC
+	#else
+		#include <cpuid.h>
+		#define AVX2_FUNC __attribute__((target("avx2")))
+	#endif
+#endif
+
+using namespace std;
+
+// The image is reduced one row at a time. First the source rows that make 
+// up the destination row are summed into a row of 16 bit values, which is 
+// padded so the SIMD kernels never have to check for the edges. Then each 
+// group of factor columns is summed and divided by the number of pixels.
+//
+// The sums never exceed 8*8*255, so they fit in signed 16 bit integers.
+
+typedef void (*ACCUMULATE_FUNC)(WORD *acc, const BYTE *src, int width);
+typedef void (*REDUCE_FUNC)(const WORD *acc, BYTE *dst, int width, int factor);
+
+enum EInstructionSet
+{
+	e_scalar,
+	e_sse2,
+	e_avx2
+};
+
+static void AccumulateRow(WORD *acc, const BYTE *src, int width)
+{
+	for( int x = 0; x < width; x++ )
+		acc[x] += src[x];
+}
+
+static void ReduceRow(const WORD *acc, BYTE *dst, int width, int factor)
+{
+	int area = factor*factor;
+	for( int x = 0; x < width; x++ )
+	{
+		int c = 0;
+		for( int i = 0; i < factor; i++ )
+			c += acc[x*factor+i];
+		dst[x] = BYTE(c / area);
+	}
+}
+
+#ifdef DOWNSCALE_SIMD
+
+static int DetectInstructionSet()
+{
+	unsigned int info[4] = {0};
+
+#ifdef _MSC_VER
+	__cpuid((int*)info, 0);
+#else
+	__cpuid(0, info[0], info[1], info[2], info[3]);
+#endif
+	unsigned int maxLevel = info[0];
+	if( maxLevel < 1 )
+		return e_scalar;
+
+#ifdef _MSC_VER
+	__cpuid((int*)info, 1);
+#else
+	__cpuid(1, info[0], info[1], info[2], info[3]);
+#endif
+	if( !(info[3] & (1<<26)) )
+		return e_scalar;
+
+	// AVX2 also requires the OS to save the YMM registers
+	bool osSavesYmm = false;
+	if( (info[2] & (1<<27)) && (info[2] & (1<<28)) )
+	{
+#ifdef _MSC_VER
+		unsigned long long xcr0 = _xgetbv(0);
+#else
+		unsigned int lo, hi;
+		__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		unsigned long long xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+		osSavesYmm = (xcr0 & 6) == 6;
+	}
+
+	if( osSavesYmm && maxLevel >= 7 )
+	{
+#ifdef _MSC_VER
+		__cpuidex((int*)info, 7, 0);
+#else
+		__cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+		if( info[1] & (1<<5) )
+			return e_avx2;
+	}
+
+	return e_sse2;
+}
+
+static const int instructionSet = DetectInstructionSet();
+
+static void AccumulateRowSSE2(WORD *acc, const BYTE *src, int width)
+{
+	__m128i zero = _mm_setzero_si128();
+	int x = 0;
+	for( ; x + 16 <= width; x += 16 )
+	{
+		__m128i s  = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i a0 = _mm_loadu_si128((const __m128i*)(acc + x));
+		__m128i a1 = _mm_loadu_si128((const __m128i*)(acc + x + 8));
+		_mm_storeu_si128((__m128i*)(acc + x),     _mm_add_epi16(a0, _mm_unpacklo_epi8(s, zero)));
+		_mm_storeu_si128((__m128i*)(acc + x + 8), _mm_add_epi16(a1, _mm_unpackhi_epi8(s, zero)));
+	}
+
+	// The source rows are not padded
+	AccumulateRow(acc + x, src + x, width - x);
+}
+
+// Sums the adjacent pairs in the 16 values of a and b
+static inline __m128i SumPairsSSE2(__m128i a, __m128i b)
+{
+	__m128i ones = _mm_set1_epi16(1);
+	return _mm_packs_epi32(_mm_madd_epi16(a, ones), _mm_madd_epi16(b, ones));
+}
+
+static void ReduceRowSSE2(const WORD *acc, BYTE *dst, int width, int factor)
+{
+	if( factor != 2 && factor != 4 && factor != 8 )
+	{
+		ReduceRow(acc, dst, width, factor);
+		return;
+	}
+
+	// Divide by the number of pixels in the block
+	__m128i shift = _mm_cvtsi32_si128(factor == 2 ? 2 : factor == 4 ? 4 : 6);
+
+	// Each iteration produces 8 pixels
+	for( int x = 0; x < width; x += 8 )
+	{
+		const __m128i *a = (const __m128i*)(acc + x*factor);
+		__m128i s;
+		if( factor == 2 )
+			s = SumPairsSSE2(_mm_loadu_si128(a), _mm_loadu_si128(a+1));
+		else if( factor == 4 )
+			s = SumPairsSSE2(SumPairsSSE2(_mm_loadu_si128(a),   _mm_loadu_si128(a+1)), 
+			                 SumPairsSSE2(_mm_loadu_si128(a+2), _mm_loadu_si128(a+3)));
+		else
+			s = SumPairsSSE2(SumPairsSSE2(SumPairsSSE2(_mm_loadu_si128(a),   _mm_loadu_si128(a+1)), 
+			                              SumPairsSSE2(_mm_loadu_si128(a+2), _mm_loadu_si128(a+3))),
+			                 SumPairsSSE2(SumPairsSSE2(_mm_loadu_si128(a+4), _mm_loadu_si128(a+5)), 
+			                              SumPairsSSE2(_mm_loadu_si128(a+6), _mm_loadu_si128(a+7))));
+
+		s = _mm_srl_epi16(s, shift);
+		_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(s, s));
+	}
+}
+
+AVX2_FUNC static void AccumulateRowAVX2(WORD *acc, const BYTE *src, int width)
+{
+	int x = 0;
+	for( ; x + 16 <= width; x += 16 )
+	{
+		__m256i s = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + x)));
+		__m256i a = _mm256_loadu_si256((const __m256i*)(acc + x));
+		_mm256_storeu_si256((__m256i*)(acc + x), _mm256_add_epi16(a, s));
+	}
+
+	// The source rows are not padded
+	AccumulateRow(acc + x, src + x, width - x);
+}
+
+// Sums the adjacent pairs in the 32 values of a and b. The 
+// pack works within each 128 bit lane, so the result is 
+// permuted to put the 64 bit parts back in order
+AVX2_FUNC static inline __m256i SumPairsAVX2(__m256i a, __m256i b)
+{
+	__m256i ones = _mm256_set1_epi16(1);
+	__m256i s = _mm256_packs_epi32(_mm256_madd_epi16(a, ones), _mm256_madd_epi16(b, ones));
+	return _mm256_permute4x64_epi64(s, 0xD8);
+}
+
+AVX2_FUNC static void ReduceRowAVX2(const WORD *acc, BYTE *dst, int width, int factor)
+{
+	if( factor != 2 && factor != 4 && factor != 8 )
+	{
+		ReduceRow(acc, dst, width, factor);
+		return;
+	}
+
+	// Divide by the number of pixels in the block
+	__m128i shift = _mm_cvtsi32_si128(factor == 2 ? 2 : factor == 4 ? 4 : 6);
+
+	// Each iteration produces 16 pixels
+	for( int x = 0; x < width; x += 16 )
+	{
+		const __m256i *a = (const __m256i*)(acc + x*factor);
+		__m256i s;
+		if( factor == 2 )
+			s = SumPairsAVX2(_mm256_loadu_si256(a), _mm256_loadu_si256(a+1));
+		else if( factor == 4 )
+			s = SumPairsAVX2(SumPairsAVX2(_mm256_loadu_si256(a),   _mm256_loadu_si256(a+1)), 
+			                 SumPairsAVX2(_mm256_loadu_si256(a+2), _mm256_loadu_si256(a+3)));
+		else
+			s = SumPairsAVX2(SumPairsAVX2(SumPairsAVX2(_mm256_loadu_si256(a),   _mm256_loadu_si256(a+1)), 
+			                              SumPairsAVX2(_mm256_loadu_si256(a+2), _mm256_loadu_si256(a+3))),
+			                 SumPairsAVX2(SumPairsAVX2(_mm256_loadu_si256(a+4), _mm256_loadu_si256(a+5)), 
+			                              SumPairsAVX2(_mm256_loadu_si256(a+6), _mm256_loadu_si256(a+7))));
+
+		s = _mm256_srl_epi16(s, shift);
+
+		// The 16 bytes end up in the first and third 64 bit parts
+		s = _mm256_permute4x64_epi64(_mm256_packus_epi16(s, s), 0x08);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(s));
+	}
+}
+
+#else
+
+static const int instructionSet = e_scalar;
+
+#endif
+
+void DownscaleCoverage(const BYTE *src, int width, int height, int factor, BYTE *dst)
+{
+	if( factor < 1 || width <= 0 || height <= 0 )
+		return;
+
+	int dstWidth  = (width + factor - 1) / factor;
+	int dstHeight = (height + factor - 1) / factor;
+
+	ACCUMULATE_FUNC accumulate = AccumulateRow;
+	REDUCE_FUNC     reduce     = ReduceRow;
+#ifdef DOWNSCALE_SIMD
+	if( instructionSet == e_avx2 )
+	{
+		accumulate = AccumulateRowAVX2;
+		reduce     = ReduceRowAVX2;
+	}
+	else if( instructionSet == e_sse2 )
+	{
+		accumulate = AccumulateRowSSE2;
+		reduce     = ReduceRowSSE2;
+	}
+#endif
+
+	// Pad the rows to a multiple of 16 destination pixels, which is 
+	// what the widest kernel produces in each iteration
+	int paddedWidth = (dstWidth + 15) & ~15;
+	vector<WORD> acc(paddedWidth*factor);
+	vector<BYTE> row(paddedWidth);
+
+	for( int y = 0; y < dstHeight; y++ )
+	{
+		memset(&acc[0], 0, acc.size()*sizeof(WORD));
+
+		int sy = y*factor;
+		for( int i = 0; i < factor && sy + i < height; i++ )
+			accumulate(&acc[0], src + (sy + i)*width, width);
+
+		reduce(&acc[0], &row[0], paddedWidth, factor);
+		memcpy(dst + y*dstWidth, &row[0], dstWidth);
+	}
+}
+
+const char *GetDownscaleInstructionSet()
+{
+	if( instructionSet == e_avx2 ) return "AVX2";
+	if( instructionSet == e_sse2 ) return "SSE2";
+	return "none";
+}
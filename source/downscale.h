@@ -0,0 +1,43 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef DOWNSCALE_H
+#define DOWNSCALE_H
+
+#include "platform.h"
+
+// Reduces an image with 8 bit coverage by averaging each block of 
+// factor x factor pixels. The destination must hold ceil(width/factor) x 
+// ceil(height/factor) pixels. Pixels outside the source image count as empty.
+//
+// The SSE2 or AVX2 instructions are used when the CPU supports them.
+void DownscaleCoverage(const BYTE *src, int width, int height, int factor, BYTE *dst);
+
+// Returns the name of the instruction set used by DownscaleCoverage
+const char *GetDownscaleInstructionSet();
+
+#endif
@@ -0,0 +1,172 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <new>
+#include "fontbackend.h"
+
+static const char *fontBackendNames[e_numFontBackends] = 
+{
+	"gdi",
+	"freetype"
+};
+
+const char *GetFontBackendName(int backend)
+{
+	if( backend < 0 || backend >= e_numFontBackends )
+		return fontBackendNames[GetDefaultFontBackend()];
+
+	return fontBackendNames[backend];
+}
+
+int GetFontBackendFromName(const char *name)
+{
+	for( int n = 0; n < e_numFontBackends; n++ )
+	{
+		if( _stricmp(name, fontBackendNames[n]) == 0 )
+			return n;
+	}
+
+	return -1;
+}
+
+bool IsFontBackendAvailable(int backend)
+{
+#ifdef _WIN32
+	if( backend == e_fontBackendGdi )
+		return true;
+#endif
+#ifdef USE_FREETYPE
+	if( backend == e_fontBackendFreeType )
+		return true;
+#endif
+
+	return false;
+}
+
+int GetDefaultFontBackend()
+{
+#ifdef _WIN32
+	return e_fontBackendGdi;
+#else
+	return e_fontBackendFreeType;
+#endif
+}
+
+CFontBackend *CFontBackend::Create(int backend)
+{
+	if( !IsFontBackendAvailable(backend) )
+		backend = GetDefaultFontBackend();
+
+#ifdef USE_FREETYPE
+	if( backend == e_fontBackendFreeType )
+		return new (std::nothrow) CFreeTypeFontBackend();
+#endif
+#ifdef _WIN32
+	if( backend == e_fontBackendGdi )
+		return new (std::nothrow) CGdiFontBackend();
+#endif
+
+	return 0;
+}
+
+CFontBackend::CFontBackend()
+{
+	glyphMap = 0;
+}
+
+CFontBackend::~CFontBackend()
+{
+}
+
+void CFontBackend::SetGlyphMap(const CGlyphMap *map)
+{
+	glyphMap = map;
+}
+
+CGlyphMap::CGlyphMap()
+{
+	defaultGlyph = -1;
+}
+
+void CGlyphMap::Build(CFontBackend *backend, const std::vector<int> &chars)
+{
+	Clear();
+
+	defaultGlyph = backend->GetDefaultGlyph();
+	for( size_t n = 0; n < chars.size(); n++ )
+	{
+		SGlyph glyph;
+		glyph.glyph  = backend->GetGlyphIndex(chars[n]);
+		glyph.hasABC = backend->GetABCWidths(chars[n], glyph.abc) >= 0;
+		glyphs[chars[n]] = glyph;
+	}
+}
+
+void CGlyphMap::BuildGlyphs(CFontBackend *backend, const std::vector<int> &chars)
+{
+	Clear();
+
+	defaultGlyph = backend->GetDefaultGlyph();
+	for( size_t n = 0; n < chars.size(); n++ )
+	{
+		SGlyph glyph;
+		glyph.glyph  = backend->GetGlyphIndex(chars[n]);
+		glyph.hasABC = false;
+		glyphs[chars[n]] = glyph;
+	}
+}
+
+void CGlyphMap::Clear()
+{
+	glyphs.clear();
+	defaultGlyph = -1;
+}
+
+bool CGlyphMap::GetGlyphIndex(UINT ch, int &glyph) const
+{
+	std::map<UINT, SGlyph>::const_iterator it = glyphs.find(ch);
+	if( it == glyphs.end() )
+		return false;
+
+	glyph = it->second.glyph;
+	return true;
+}
+
+bool CGlyphMap::GetABCWidths(UINT ch, ABC &abc) const
+{
+	std::map<UINT, SGlyph>::const_iterator it = glyphs.find(ch);
+	if( it == glyphs.end() || !it->second.hasABC )
+		return false;
+
+	abc = it->second.abc;
+	return true;
+}
+
+int CGlyphMap::GetDefaultGlyph() const
+{
+	return defaultGlyph;
+}
@@ -0,0 +1,287 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef FONTBACKEND_H
+#define FONTBACKEND_H
+
+#include "platform.h"
+#include <vector>
+#include <string>
+#include <map>
+
+#ifdef _WIN32
+#include <Usp10.h>
+#endif
+
+class CFontGen;
+class CGlyphImage;
+class CGlyphMap;
+
+// The font systems that can be used for loading and drawing the glyphs
+enum EFontBackend
+{
+	e_fontBackendGdi,
+	e_fontBackendFreeType,
+	e_numFontBackends
+};
+
+// Names used for the font backends in the font configuration file
+const char *GetFontBackendName(int backend);
+int         GetFontBackendFromName(const char *name);
+
+// Returns true if the backend is included in this build
+bool        IsFontBackendAvailable(int backend);
+int         GetDefaultFontBackend();
+
+enum EOutlineCommand
+{
+	e_moveTo,
+	e_lineTo,
+	e_quadTo
+};
+
+// The outline of a glyph in 16.16 fixed point pixels with y pointing up, as 
+// in TrueType. Each contour starts with e_moveTo and is implicitly closed. 
+// The e_moveTo and e_lineTo take one point, and e_quadTo takes two points, 
+// the control point followed by the end point.
+struct SGlyphOutline
+{
+	std::vector<int>   commands;
+	std::vector<POINT> points;
+	int                advance;
+};
+
+// A glyph drawn by the font system itself. The image is 8 bit coverage, 
+// and is null for glyphs without any pixels. The offsets place the image 
+// relative to the pen position and the top of the cell.
+struct SGlyphBitmap
+{
+	CGlyphImage *image;
+	int          xoffset;
+	int          yoffset;
+	int          advance;
+};
+
+// A font backend loads the font with the settings of the generator, and gives 
+// access to the glyphs and the font tables. A backend is not thread safe, so 
+// each thread that draws characters must have its own.
+class CFontBackend
+{
+public:
+	static CFontBackend *Create(int backend);
+	virtual ~CFontBackend();
+
+	// Loads the font. The size is given as for CFontGen::CreateFont, i.e. 
+	// 0 gives the font size multiplied with the antialiasing level
+	virtual int   Open(const CFontGen *gen, int fontSize) = 0;
+
+	// Height and ascent of the font in pixels, without the height scale
+	virtual void  GetMetrics(int &height, int &ascent) = 0;
+
+	// Returns the glyph index of the character, or -1 if the font doesn't have it
+	virtual int   GetGlyphIndex(UINT ch) = 0;
+	virtual bool  DoesCharExist(UINT ch) = 0;
+
+	// The glyph that is drawn for characters that the font doesn't have
+	virtual int   GetDefaultGlyph() = 0;
+
+	// Horizontal metrics of the character as the font system draws it. Returns 
+	// -1 if the font system gives the metrics with the glyph image instead
+	virtual int   GetABCWidths(UINT ch, ABC &abc) = 0;
+
+	// Returns the outline of the character with the height scale applied. 
+	// Characters that the font doesn't have get the default glyph. Returns 
+	// -1 if the font has no outlines, and -2 if out of memory
+	virtual int   GetGlyphOutline(UINT ch, SGlyphOutline &outline) = 0;
+
+	// Draws the character with the font system's own rasterizer, with the 
+	// height scale applied. Returns -1 on failure, and -2 if out of memory
+	virtual int   DrawGlyph(UINT ch, SGlyphBitmap &bitmap) = 0;
+
+	// Kerning pairs given by the font system, in pixels. The list 
+	// of characters is the ones that the pairs are needed for
+	virtual void  GetKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars) = 0;
+
+	// Kerning pairs in design units, for font systems where the pairs are read 
+	// from the font tables so they can be scaled to any size. Returns -1 if the 
+	// font system adjusts the kerning for the size itself
+	virtual int   GetDesignKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars) = 0;
+
+	// Factor for converting the font's design units to pixels
+	virtual float GetDesignUnitScale() = 0;
+
+	// Loads a table from the font file. The tag has the first character in 
+	// the lowest byte as for GetFontData, and 0 loads the whole font file
+	virtual int   GetFontTable(DWORD tag, std::vector<BYTE> &data) = 0;
+
+	// Uses the glyphs that were looked up beforehand instead of asking the 
+	// font system again. The map must have been built for the same font, 
+	// and it must not be changed or deleted while the backend uses it.
+	void          SetGlyphMap(const CGlyphMap *map);
+
+protected:
+	CFontBackend();
+
+	const CGlyphMap *glyphMap;
+
+private:
+	CFontBackend(const CFontBackend &);
+	CFontBackend &operator=(const CFontBackend &);
+};
+
+#ifdef _WIN32
+// The GDI backend uses the fonts installed in Windows, or loaded with 
+// AddFontResourceEx, and draws the glyphs with TextOut
+class CGdiFontBackend : public CFontBackend
+{
+public:
+	CGdiFontBackend();
+	~CGdiFontBackend();
+
+	int   Open(const CFontGen *gen, int fontSize);
+	void  GetMetrics(int &height, int &ascent);
+	int   GetGlyphIndex(UINT ch);
+	bool  DoesCharExist(UINT ch);
+	int   GetDefaultGlyph();
+	int   GetABCWidths(UINT ch, ABC &abc);
+	int   GetGlyphOutline(UINT ch, SGlyphOutline &outline);
+	int   DrawGlyph(UINT ch, SGlyphBitmap &bitmap);
+	void  GetKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars);
+	int   GetDesignKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars);
+	float GetDesignUnitScale();
+	int   GetFontTable(DWORD tag, std::vector<BYTE> &data);
+
+protected:
+	void  Close();
+	void  SetScaleTransform();
+
+	HDC          dc;
+	HFONT        font;
+	HFONT        oldFont;
+	SCRIPT_CACHE sc;
+
+	// Looked up the first time they are needed
+	int   defaultGlyph;
+	int   scriptDefaultGlyph;
+
+	int   height;
+	int   ascent;
+	int   scaledHeight;
+	int   scaleH;
+	bool  isTransformed;
+	bool  useUnicode;
+	bool  useHinting;
+	bool  useClearType;
+};
+#endif
+
+#ifdef USE_FREETYPE
+typedef struct FT_LibraryRec_ *FT_Library;
+typedef struct FT_FaceRec_    *FT_Face;
+
+// The FreeType backend loads the font from the file given by fontFile, 
+// so it doesn't depend on the fonts installed in the system
+class CFreeTypeFontBackend : public CFontBackend
+{
+public:
+	CFreeTypeFontBackend();
+	~CFreeTypeFontBackend();
+
+	int   Open(const CFontGen *gen, int fontSize);
+	void  GetMetrics(int &height, int &ascent);
+	int   GetGlyphIndex(UINT ch);
+	bool  DoesCharExist(UINT ch);
+	int   GetDefaultGlyph();
+	int   GetABCWidths(UINT ch, ABC &abc);
+	int   GetGlyphOutline(UINT ch, SGlyphOutline &outline);
+	int   DrawGlyph(UINT ch, SGlyphBitmap &bitmap);
+	void  GetKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars);
+	int   GetDesignKerningPairs(std::vector<KERNINGPAIR> &pairs, std::vector<UINT> &chars);
+	float GetDesignUnitScale();
+	int   GetFontTable(DWORD tag, std::vector<BYTE> &data);
+
+protected:
+	void  Close();
+	int   NewFace(long index, FT_Face *newFace);
+	int   LoadGlyph(UINT ch, int flags);
+
+	FT_Library library;
+	FT_Face    face;
+
+	// The face is created from the shared file data when there is a font cache
+	std::string               file;
+	const std::vector<BYTE>  *fileData;
+
+	int   height;
+	int   ascent;
+	int   scaledAscent;
+	int   emboldenStrength;
+	bool  useUnicode;
+	bool  useHinting;
+	bool  useSmoothing;
+	bool  isSymbolFont;
+};
+#endif
+
+// Maps the characters to the glyphs of the font. The map is built once per 
+// generation, and then shared read-only by the backends of all the worker 
+// threads, so the font system is only asked once about each character. The 
+// glyph indices don't depend on the size, so a map with only the indices 
+// can also be shared by the generators of all sizes of the same font.
+class CGlyphMap
+{
+public:
+	CGlyphMap();
+
+	// Looks up the glyphs for the characters with the backend, which 
+	// must have the font opened with the size that is drawn
+	void Build(CFontBackend *backend, const std::vector<int> &chars);
+
+	// Looks up only the glyph indices, which are the same for all sizes
+	void BuildGlyphs(CFontBackend *backend, const std::vector<int> &chars);
+	void Clear();
+
+	// These return false if the character isn't in the map
+	bool GetGlyphIndex(UINT ch, int &glyph) const;
+	bool GetABCWidths(UINT ch, ABC &abc) const;
+
+	// Returns -1 if the map hasn't been built
+	int  GetDefaultGlyph() const;
+
+protected:
+	struct SGlyph
+	{
+		int  glyph;
+		bool hasABC;
+		ABC  abc;
+	};
+
+	std::map<UINT, SGlyph> glyphs;
+	int                    defaultGlyph;
+};
+
+#endif
@@ -0,0 +1,529 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifdef USE_FREETYPE
+
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+#include FT_TRUETYPE_TABLES_H
+#include "fontbackend.h"
+#include "fontgen.h"
+#include "fontcache.h"
+#include "fontchar.h"
+#include "unicode.h"
+
+using namespace std;
+
+// The characters 0x80-0x9F of the Windows ANSI code page, which is 
+// otherwise the same as the first 256 characters of Unicode
+static const WORD cp1252[32] = 
+{
+	0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F, 
+	0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+CFreeTypeFontBackend::CFreeTypeFontBackend()
+{
+	library  = 0;
+	face     = 0;
+	fileData = 0;
+
+	height           = 0;
+	ascent           = 0;
+	scaledAscent     = 0;
+	emboldenStrength = 0;
+	useUnicode       = false;
+	useHinting       = false;
+	useSmoothing     = false;
+	isSymbolFont     = false;
+}
+
+CFreeTypeFontBackend::~CFreeTypeFontBackend()
+{
+	Close();
+}
+
+void CFreeTypeFontBackend::Close()
+{
+	if( face )
+		FT_Done_Face(face);
+	if( library )
+		FT_Done_FreeType(library);
+
+	face    = 0;
+	library = 0;
+}
+
+int CFreeTypeFontBackend::NewFace(long index, FT_Face *newFace)
+{
+	if( fileData )
+		return FT_New_Memory_Face(library, &(*fileData)[0], (FT_Long)fileData->size(), index, newFace);
+
+	return FT_New_Face(library, file.c_str(), index, newFace);
+}
+
+int CFreeTypeFontBackend::Open(const CFontGen *gen, int fontSize)
+{
+	Close();
+
+	useUnicode   = gen->IsUsingUnicode();
+	useHinting   = gen->GetUseHinting();
+	useSmoothing = gen->IsUsingSmoothing();
+	if( fontSize == 0 )
+		fontSize = gen->GetFontSize()*gen->GetAntiAliasingLevel();
+
+	// The font can only be loaded from a file, as there is 
+	// no portable way of finding the installed fonts by name
+	file = gen->GetFontFile();
+	if( file == "" )
+		return -1;
+
+	// Generators that share the font data load the file only once
+	fileData = 0;
+	if( gen->GetFontCache() )
+	{
+		fileData = gen->GetFontCache()->GetFontFileData(file);
+		if( fileData == 0 )
+			return -1;
+	}
+
+	if( FT_Init_FreeType(&library) != 0 )
+	{
+		library = 0;
+		return -1;
+	}
+
+	if( NewFace(0, &face) != 0 )
+	{
+		face = 0;
+		Close();
+		return -1;
+	}
+
+	// Font collections hold several faces, so pick the 
+	// one with the best matching family name and style
+	if( face->num_faces > 1 )
+	{
+		FT_Long numFaces = face->num_faces;
+		FT_Long bestFace = 0;
+		int bestScore = -1;
+		for( FT_Long n = 0; n < numFaces; n++ )
+		{
+			FT_Face f;
+			if( NewFace(n, &f) != 0 )
+				continue;
+
+			int score = 0;
+			if( f->family_name && _stricmp(f->family_name, gen->GetFontName().c_str()) == 0 )
+				score += 4;
+			if( ((f->style_flags & FT_STYLE_FLAG_BOLD) != 0) == gen->IsBold() )
+				score += 2;
+			if( ((f->style_flags & FT_STYLE_FLAG_ITALIC) != 0) == gen->IsItalic() )
+				score += 1;
+			if( score > bestScore )
+			{
+				bestScore = score;
+				bestFace  = n;
+			}
+
+			FT_Done_Face(f);
+		}
+
+		if( bestFace != 0 )
+		{
+			FT_Done_Face(face);
+			if( NewFace(bestFace, &face) != 0 )
+			{
+				face = 0;
+				Close();
+				return -1;
+			}
+		}
+	}
+
+	// Only fonts with outlines can be scaled to any size
+	if( !FT_IS_SCALABLE(face) || face->units_per_EM == 0 )
+	{
+		Close();
+		return -1;
+	}
+
+	// Symbol fonts map the characters to the range 0xF000-0xF0FF
+	isSymbolFont = false;
+	if( FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0 )
+	{
+		if( FT_Select_Charmap(face, FT_ENCODING_MS_SYMBOL) == 0 )
+			isSymbolFont = true;
+	}
+
+	// As with GDI, a positive size is the cell height, i.e. the ascent 
+	// plus the descent from the OS/2 table, and a negative size is the em size
+	int winAscent  = face->ascender;
+	int winDescent = -face->descender;
+	TT_OS2 *os2 = (TT_OS2*)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
+	if( os2 && os2->version != 0xFFFF && os2->usWinAscent + os2->usWinDescent > 0 )
+	{
+		winAscent  = os2->usWinAscent;
+		winDescent = os2->usWinDescent;
+	}
+	if( winAscent + winDescent <= 0 )
+	{
+		winAscent  = face->units_per_EM;
+		winDescent = 0;
+	}
+
+	double ppem;
+	if( fontSize < 0 )
+		ppem = -fontSize;
+	else
+		ppem = double(fontSize)*face->units_per_EM/(winAscent + winDescent);
+
+	if( FT_Set_Char_Size(face, 0, FT_F26Dot6(ppem*64 + 0.5), 72, 72) != 0 )
+	{
+		Close();
+		return -1;
+	}
+
+	double scale = ppem/face->units_per_EM;
+	ascent = int(floor(winAscent*scale + 0.5));
+	height = ascent + int(floor(winDescent*scale + 0.5));
+	scaledAscent = int(ceilf(ascent*float(gen->GetScaleHeight())/100.0f));
+
+	// Bold and italic are synthesized when the face doesn't have the style, as GDI does
+	emboldenStrength = 0;
+	if( gen->IsBold() && !(face->style_flags & FT_STYLE_FLAG_BOLD) )
+		emboldenStrength = int(FT_MulFix(face->units_per_EM, face->size->metrics.y_scale)/24);
+
+	FT_Matrix mtx;
+	mtx.xx = 0x10000;
+	mtx.xy = 0;
+	mtx.yx = 0;
+	mtx.yy = FT_Fixed(gen->GetScaleHeight())*0x10000/100;
+	if( gen->IsItalic() && !(face->style_flags & FT_STYLE_FLAG_ITALIC) )
+		mtx.xy = 0x0366A;
+	FT_Set_Transform(face, &mtx, 0);
+
+	return 0;
+}
+
+void CFreeTypeFontBackend::GetMetrics(int &h, int &a)
+{
+	h = height;
+	a = ascent;
+}
+
+int CFreeTypeFontBackend::GetGlyphIndex(UINT ch)
+{
+	int glyph;
+	if( glyphMap && glyphMap->GetGlyphIndex(ch, glyph) )
+		return glyph;
+
+	if( !useUnicode && ch >= 0x80 && ch < 0xA0 )
+		ch = cp1252[ch - 0x80];
+	if( isSymbolFont && ch < 0x100 )
+		ch |= 0xF000;
+
+	FT_UInt idx = FT_Get_Char_Index(face, ch);
+	if( idx == 0 )
+		return -1;
+
+	return int(idx);
+}
+
+bool CFreeTypeFontBackend::DoesCharExist(UINT ch)
+{
+	return GetGlyphIndex(ch) >= 0;
+}
+
+int CFreeTypeFontBackend::GetDefaultGlyph()
+{
+	// The .notdef glyph
+	return 0;
+}
+
+int CFreeTypeFontBackend::GetABCWidths(UINT, ABC &)
+{
+	// The metrics are given with the glyph when it is loaded
+	return -1;
+}
+
+int CFreeTypeFontBackend::LoadGlyph(UINT ch, int flags)
+{
+	// Characters that the font doesn't have get the .notdef glyph
+	int idx = GetGlyphIndex(ch);
+	if( idx < 0 )
+		idx = 0;
+
+	if( FT_Load_Glyph(face, idx, flags) != 0 )
+		return -1;
+
+	if( emboldenStrength && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+	{
+		FT_Outline_Embolden(&face->glyph->outline, emboldenStrength);
+		face->glyph->advance.x += emboldenStrength;
+	}
+
+	return 0;
+}
+
+static void AddPoint(SGlyphOutline *outline, int command, long x, long y)
+{
+	POINT pt = {LONG(x), LONG(y)};
+	outline->commands.push_back(command);
+	outline->points.push_back(pt);
+}
+
+static int OutlineMoveTo(const FT_Vector *to, void *user)
+{
+	AddPoint((SGlyphOutline*)user, e_moveTo, to->x, to->y);
+	return 0;
+}
+
+static int OutlineLineTo(const FT_Vector *to, void *user)
+{
+	AddPoint((SGlyphOutline*)user, e_lineTo, to->x, to->y);
+	return 0;
+}
+
+static int OutlineConicTo(const FT_Vector *control, const FT_Vector *to, void *user)
+{
+	SGlyphOutline *outline = (SGlyphOutline*)user;
+	AddPoint(outline, e_quadTo, control->x, control->y);
+	POINT pt = {LONG(to->x), LONG(to->y)};
+	outline->points.push_back(pt);
+	return 0;
+}
+
+static void EvalCubic(const double *p, double t, double &pos, double &deriv)
+{
+	double u = 1-t;
+	pos   = u*u*u*p[0] + 3*u*u*t*p[1] + 3*u*t*t*p[2] + t*t*t*p[3];
+	deriv = 3*(u*u*(p[1]-p[0]) + 2*u*t*(p[2]-p[1]) + t*t*(p[3]-p[2]));
+}
+
+// The cubic curves of PostScript outlines are approximated with quadratic 
+// curves. The cubic is split in four parts, and each part is replaced with 
+// the quadratic curve that has the same end points and mid point.
+static int OutlineCubicTo(const FT_Vector *control1, const FT_Vector *control2, const FT_Vector *to, void *user)
+{
+	SGlyphOutline *outline = (SGlyphOutline*)user;
+	const POINT &from = outline->points.back();
+
+	double px[4] = {double(from.x), double(control1->x), double(control2->x), double(to->x)};
+	double py[4] = {double(from.y), double(control1->y), double(control2->y), double(to->y)};
+
+	const int parts = 4;
+	double x0, y0, dx0, dy0;
+	EvalCubic(px, 0, x0, dx0);
+	EvalCubic(py, 0, y0, dy0);
+	for( int n = 1; n <= parts; n++ )
+	{
+		double x1, y1, dx1, dy1;
+		EvalCubic(px, double(n)/parts, x1, dx1);
+		EvalCubic(py, double(n)/parts, y1, dy1);
+
+		// Control points of this part of the cubic
+		double len = 1.0/parts/3;
+		double c1x = x0 + dx0*len, c1y = y0 + dy0*len;
+		double c2x = x1 - dx1*len, c2y = y1 - dy1*len;
+
+		double qx = (3*(c1x + c2x) - x0 - x1)/4;
+		double qy = (3*(c1y + c2y) - y0 - y1)/4;
+
+		AddPoint(outline, e_quadTo, long(floor(qx + 0.5)), long(floor(qy + 0.5)));
+		POINT pt = {LONG(floor(x1 + 0.5)), LONG(floor(y1 + 0.5))};
+		if( n == parts )
+		{
+			pt.x = to->x;
+			pt.y = to->y;
+		}
+		outline->points.push_back(pt);
+
+		x0 = x1; y0 = y1; dx0 = dx1; dy0 = dy1;
+	}
+
+	return 0;
+}
+
+int CFreeTypeFontBackend::GetGlyphOutline(UINT ch, SGlyphOutline &outline)
+{
+	outline.commands.clear();
+	outline.points.clear();
+	outline.advance = 0;
+
+	int flags = FT_LOAD_NO_BITMAP;
+	if( !useHinting )
+		flags |= FT_LOAD_NO_HINTING;
+	else if( !useSmoothing )
+		flags |= FT_LOAD_TARGET_MONO;
+
+	if( LoadGlyph(ch, flags) < 0 || face->glyph->format != FT_GLYPH_FORMAT_OUTLINE )
+		return -1;
+
+	outline.advance = int((face->glyph->advance.x + 32) >> 6);
+
+	// The shift converts the 26.6 fixed point coordinates to 16.16
+	FT_Outline_Funcs funcs;
+	funcs.move_to  = OutlineMoveTo;
+	funcs.line_to  = OutlineLineTo;
+	funcs.conic_to = OutlineConicTo;
+	funcs.cubic_to = OutlineCubicTo;
+	funcs.shift    = 10;
+	funcs.delta    = 0;
+
+	try
+	{
+		if( FT_Outline_Decompose(&face->glyph->outline, &funcs, &outline) != 0 )
+			return -1;
+	}
+	catch( std::bad_alloc & )
+	{
+		return -2;
+	}
+
+	return 0;
+}
+
+int CFreeTypeFontBackend::DrawGlyph(UINT ch, SGlyphBitmap &bitmap)
+{
+	bitmap.image   = 0;
+	bitmap.xoffset = 0;
+	bitmap.yoffset = 0;
+	bitmap.advance = 0;
+
+	int flags = useSmoothing ? FT_LOAD_TARGET_NORMAL : FT_LOAD_TARGET_MONO;
+	if( !useHinting )
+		flags |= FT_LOAD_NO_HINTING;
+	if( LoadGlyph(ch, flags) < 0 )
+		return -1;
+
+	FT_GlyphSlot slot = face->glyph;
+	if( slot->format != FT_GLYPH_FORMAT_BITMAP &&
+		FT_Render_Glyph(slot, useSmoothing ? FT_RENDER_MODE_NORMAL : FT_RENDER_MODE_MONO) != 0 )
+		return -1;
+
+	bitmap.advance = int((slot->advance.x + 32) >> 6);
+	bitmap.xoffset = slot->bitmap_left;
+	bitmap.yoffset = scaledAscent - slot->bitmap_top;
+
+	const FT_Bitmap &bm = slot->bitmap;
+	if( bm.width == 0 || bm.rows == 0 )
+		return 0;
+
+	CGlyphImage *img = new (std::nothrow) CGlyphImage(bm.width, bm.rows, e_glyph8);
+	if( img == 0 || img->pixels8 == 0 )
+	{
+		delete img;
+		return -2;
+	}
+
+	for( int y = 0; y < int(bm.rows); y++ )
+	{
+		const BYTE *src = bm.buffer + y*bm.pitch;
+		BYTE *dst = &img->pixels8[y*img->width];
+		for( int x = 0; x < int(bm.width); x++ )
+		{
+			BYTE c;
+			switch( bm.pixel_mode )
+			{
+			case FT_PIXEL_MODE_MONO:
+				c = (src[x>>3] & (0x80>>(x&7))) ? 255 : 0;
+				break;
+			case FT_PIXEL_MODE_GRAY:
+				c = bm.num_grays == 256 ? src[x] : BYTE(src[x]*255/(bm.num_grays-1));
+				break;
+			case FT_PIXEL_MODE_BGRA:
+				c = src[x*4+3];
+				break;
+			default:
+				c = 0;
+			}
+			dst[x] = c;
+		}
+	}
+
+	bitmap.image = img;
+	return 0;
+}
+
+void CFreeTypeFontBackend::GetKerningPairs(vector<KERNINGPAIR> &pairs, vector<UINT> &chars)
+{
+	// Read the kern table directly, as GDI does for the fonts it loads
+	GetKerningPairsFromKERN(this, pairs, chars, GetDesignUnitScale());
+}
+
+int CFreeTypeFontBackend::GetDesignKerningPairs(vector<KERNINGPAIR> &pairs, vector<UINT> &chars)
+{
+	GetKerningPairsFromKERN(this, pairs, chars, 1);
+	return 0;
+}
+
+float CFreeTypeFontBackend::GetDesignUnitScale()
+{
+	// x_scale converts from font units to 26.6 pixels
+	return float(face->size->metrics.x_scale/65536.0/64.0);
+}
+
+int CFreeTypeFontBackend::GetFontTable(DWORD tag, vector<BYTE> &data)
+{
+	data.clear();
+
+	// The tags are given in the byte order used by GetFontData, 
+	// but FreeType wants them in the big endian order
+	FT_ULong ftTag = 0;
+	if( tag )
+		ftTag = FT_MAKE_TAG(tag & 0xFF, (tag >> 8) & 0xFF, (tag >> 16) & 0xFF, (tag >> 24) & 0xFF);
+
+	FT_ULong length = 0;
+	if( FT_Load_Sfnt_Table(face, ftTag, 0, 0, &length) != 0 || length == 0 )
+		return -1;
+
+	try
+	{
+		data.resize(length);
+	}
+	catch( std::bad_alloc & )
+	{
+		return -2;
+	}
+
+	if( FT_Load_Sfnt_Table(face, ftTag, 0, &data[0], &length) != 0 )
+	{
+		data.clear();
+		return -1;
+	}
+
+	return 0;
+}
+
+#endif
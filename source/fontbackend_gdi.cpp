@@ -0,0 +1,616 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "fontbackend.h"
+#include "fontgen.h"
+#include "fontchar.h"
+#include "unicode.h"
+#include "acutil_unicode.h"
+#include "dynamic_funcs.h"
+
+using namespace std;
+
+CGdiFontBackend::CGdiFontBackend()
+{
+	dc      = 0;
+	font    = 0;
+	oldFont = 0;
+	sc      = 0;
+
+	defaultGlyph       = -1;
+	scriptDefaultGlyph = -1;
+
+	height        = 0;
+	ascent        = 0;
+	scaledHeight  = 0;
+	scaleH        = 100;
+	isTransformed = false;
+	useUnicode    = false;
+	useHinting    = false;
+	useClearType  = false;
+}
+
+CGdiFontBackend::~CGdiFontBackend()
+{
+	Close();
+}
+
+void CGdiFontBackend::Close()
+{
+	if( dc )
+	{
+		if( oldFont )
+			SelectObject(dc, oldFont);
+		DeleteDC(dc);
+	}
+	if( font )
+		DeleteObject(font);
+
+	// Clean up the cache created by Uniscribe
+	if( sc != 0 )
+		ScriptFreeCache(&sc);
+
+	dc      = 0;
+	font    = 0;
+	oldFont = 0;
+	sc      = 0;
+	isTransformed = false;
+
+	defaultGlyph       = -1;
+	scriptDefaultGlyph = -1;
+}
+
+int CGdiFontBackend::Open(const CFontGen *gen, int fontSize)
+{
+	Close();
+
+	// The functions for getting the glyph indices are loaded dynamically
+	if( fGetGlyphIndicesA == 0 || fGetGlyphIndicesW == 0 )
+		return -1;
+
+	useUnicode   = gen->IsUsingUnicode();
+	useHinting   = gen->GetUseHinting();
+	useClearType = gen->IsUsingSmoothing() && gen->GetUseClearType();
+	scaleH       = gen->GetScaleHeight();
+
+	dc = CreateCompatibleDC(0);
+	font = gen->CreateFont(fontSize);
+	if( dc == 0 || font == 0 )
+	{
+		Close();
+		return -1;
+	}
+
+	oldFont = (HFONT)SelectObject(dc, font);
+
+	// We need to determine text metrics before applying the world transform, because 
+	// the returned text metrics with transform is not consistent. The tmHeight for example
+	// is always the same, independently of the scale, but the tmAscent varies slightly,
+	// though not proportionally with the scale.
+	TEXTMETRIC tm;
+	GetTextMetrics(dc, &tm);
+	height = tm.tmHeight;
+	ascent = tm.tmAscent;
+	scaledHeight = int(ceilf(tm.tmHeight*float(scaleH)/100.0f));
+
+	return 0;
+}
+
+// Scales the coordinate system so that the font is stretched. This is only 
+// done before drawing the glyphs, as it may affect the other queries
+void CGdiFontBackend::SetScaleTransform()
+{
+	if( isTransformed )
+		return;
+	isTransformed = true;
+
+	if( SetGraphicsMode(dc, GM_ADVANCED) )
+	{
+		XFORM mtx;
+		mtx.eM11 = 1.0f;
+		mtx.eM12 = 0;
+		mtx.eM21 = 0;
+		mtx.eM22 = float(scaleH)/100.0f;
+		mtx.eDx = 0;
+		mtx.eDy = 0;
+		SetWorldTransform(dc, &mtx);
+	}
+}
+
+void CGdiFontBackend::GetMetrics(int &h, int &a)
+{
+	h = height;
+	a = ascent;
+}
+
+int CGdiFontBackend::GetGlyphIndex(UINT ch)
+{
+	int glyph;
+	if( glyphMap && glyphMap->GetGlyphIndex(ch, glyph) )
+		return glyph;
+
+	if( useUnicode )
+		return GetUnicodeGlyphIndex(dc, &sc, ch);
+
+	char buf[2];
+	buf[0] = char(ch);
+	buf[1] = '\0';
+
+	WORD idx;
+	int r = fGetGlyphIndicesA(dc, buf, 1, &idx, GGI_MARK_NONEXISTING_GLYPHS);
+	if( r == GDI_ERROR || idx == 0xFFFF )
+		return -1;
+
+	return idx;
+}
+
+bool CGdiFontBackend::DoesCharExist(UINT ch)
+{
+	int idx = GetGlyphIndex(ch);
+	if( idx < 0 )
+		return false;
+
+	// Uniscribe may give the default glyph rather than report the character as missing
+	if( useUnicode )
+	{
+		if( scriptDefaultGlyph < 0 )
+		{
+			SCRIPT_FONTPROPERTIES props;
+			props.cBytes = sizeof(props);
+			if( FAILED(ScriptGetFontProperties(dc, &sc, &props)) )
+				return true;
+			scriptDefaultGlyph = props.wgDefault;
+		}
+
+		return idx != scriptDefaultGlyph;
+	}
+
+	return true;
+}
+
+int CGdiFontBackend::GetDefaultGlyph()
+{
+	if( glyphMap && glyphMap->GetDefaultGlyph() >= 0 )
+		return glyphMap->GetDefaultGlyph();
+
+	if( defaultGlyph < 0 )
+	{
+		TEXTMETRICW tm;
+		GetTextMetricsW(dc, &tm);
+		WORD glyph;
+		fGetGlyphIndicesW(dc, &tm.tmDefaultChar, 1, &glyph, 0);
+		defaultGlyph = glyph;
+	}
+
+	return defaultGlyph;
+}
+
+int CGdiFontBackend::GetABCWidths(UINT ch, ABC &abc)
+{
+	SetScaleTransform();
+
+	if( glyphMap && glyphMap->GetABCWidths(ch, abc) )
+		return 0;
+
+	if( useUnicode )
+	{
+		int idx = GetGlyphIndex(ch);
+		if( idx < 0 || FAILED(ScriptGetGlyphABCWidth(dc, &sc, WORD(idx), &abc)) )
+			memset(&abc, 0, sizeof(abc));
+	}
+	else if( !::GetCharABCWidths(dc, ch, ch, &abc) )
+	{
+		// Use GetCharWidth32() instead
+		int width;
+		GetCharWidth32(dc, ch, ch, &width);
+		abc.abcA = abc.abcC = 0;
+		abc.abcB = (unsigned)width;
+	}
+
+	return 0;
+}
+
+int CGdiFontBackend::GetGlyphOutline(UINT ch, SGlyphOutline &outline)
+{
+	SetScaleTransform();
+
+	// Get the glyph info
+	int idx;
+	if( useUnicode )
+	{
+		idx = GetGlyphIndex(ch);
+		if( idx < 0 )
+		{
+			// Get the default character instead
+			idx = GetDefaultGlyph();
+		}
+	}
+	else
+	{
+		idx = ch;
+	}
+
+	GLYPHMETRICS gm;
+
+	// The DC is already initialized with a transformation matrix, so here we need to use the identity matrix
+	MAT2 mat = {{0,1},{0,0},{0,0},{0,1}};
+
+	// The code for converting true type outlines to polygons is described in the following article
+	// ref: http://support.microsoft.com/kb/87115
+
+	UINT format = GGO_NATIVE|(useHinting?0:GGO_UNHINTED);
+	DWORD memSize;
+	if( useUnicode )
+		memSize = ::GetGlyphOutlineW(dc, idx, GGO_GLYPH_INDEX|format, &gm, 0, 0, &mat);
+	else
+		memSize = ::GetGlyphOutlineA(dc, idx, format, &gm, 0, 0, &mat);
+	if( memSize == GDI_ERROR )
+		return -1;
+
+	outline.advance = gm.gmCellIncX;
+	outline.commands.clear();
+	outline.points.clear();
+
+	BYTE *buf = new (std::nothrow) BYTE[memSize];
+	if( buf == 0 )
+	{
+		// Oops, I'm out of memory
+		return -2;
+	}
+
+	DWORD d;
+	if( useUnicode )
+		d = ::GetGlyphOutlineW(dc, idx, GGO_GLYPH_INDEX|format, &gm, memSize, buf, &mat);
+	else 
+		d = ::GetGlyphOutlineA(dc, idx, format, &gm, memSize, buf, &mat);
+	if( d == GDI_ERROR )
+	{
+		delete[] buf;	
+		return -1;
+	}
+
+	for( DWORD off = 0; off < memSize; )
+	{
+		TTPOLYGONHEADER *head = (TTPOLYGONHEADER*)(buf + off);
+		head->cb;       // Number of bytes that describe the polygon
+		head->pfxStart; // Starting point for the polygon
+
+		POINT start = {*(int*)&head->pfxStart.x, *(int*)&head->pfxStart.y};
+		outline.commands.push_back(e_moveTo);
+		outline.points.push_back(start);
+
+		// The header is followed by N polygon curves (edges)
+		DWORD off2 = sizeof(TTPOLYGONHEADER);
+		while( off2 < head->cb )
+		{
+			TTPOLYCURVE *curve = (TTPOLYCURVE*)(buf + off + off2);
+			curve->wType; // TT_PRIM_LINE, TT_PRIM_QSPLINE, TT_PRIM_CSPLINE
+			curve->cpfx; // number of POINTFX 
+
+			if( curve->wType != TT_PRIM_QSPLINE )
+			{
+				// True type doesn't use cubic bsplines, only quadratic bsplines
+				assert( curve->wType == TT_PRIM_LINE );
+
+				for( DWORD n = 0; n < curve->cpfx; n++ )
+				{
+					POINT pt = {*(int*)&curve->apfx[n].x, *(int*)&curve->apfx[n].y};
+					outline.commands.push_back(e_lineTo);
+					outline.points.push_back(pt);
+				}
+			}
+			else
+			{
+				// The on-curve points between two control points are implicit
+				for( int n = 0; n < curve->cpfx - 1; n++ )
+				{
+					POINT b = {*(int*)&curve->apfx[n].x, *(int*)&curve->apfx[n].y};
+					POINT c = {*(int*)&curve->apfx[n+1].x, *(int*)&curve->apfx[n+1].y};
+					if( n < curve->cpfx - 2 )
+					{
+						c.x = (b.x + c.x)/2;
+						c.y = (b.y + c.y)/2;
+					}
+
+					outline.commands.push_back(e_quadTo);
+					outline.points.push_back(b);
+					outline.points.push_back(c);
+				}
+			}
+
+			// Move to next polygon curve
+			off2 += sizeof(TTPOLYCURVE) + sizeof(POINTFX)*(curve->cpfx-1);
+		}
+
+		// Move to next polygon
+		off += off2;
+	}
+
+	delete[] buf;
+
+	return 0;
+}
+
+int CGdiFontBackend::DrawGlyph(UINT ch, SGlyphBitmap &bitmap)
+{
+	SetScaleTransform();
+
+	bitmap.image   = 0;
+	bitmap.xoffset = 0;
+	bitmap.yoffset = 0;
+	bitmap.advance = 0;
+
+/*
+	Do not use GetGlyphOutline to retrieve the glyph bitmap. 
+	- It doesn't prevent clipping of glyphs that go above or below cell height
+	- When glyph go outside the cell height the black box doesn't reflect the true size
+	- It has less grayscale levels for antialiasing than the TextOut function has
+	- ClearType isn't available
+
+	I'm leaving the code here in case I ever want to use it again
+
+
+	MAT2 mat = {{0,1},{0,0},{0,0},{0,1}};
+	GLYPHMETRICS gm;
+	DWORD d;
+	if( useUnicode )
+	{
+		d = GetGlyphOutlineW(dc,idx,GGO_GLYPH_INDEX|(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,0,0,&mat);
+	}
+	else
+	{
+		d = GetGlyphOutlineA(dc,idx,(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,0,0,&mat);
+	}
+	if( d != GDI_ERROR )
+	{
+		// Create the image that will receive the pixels
+		m_width = gm.gmBlackBoxX;
+		m_height = gm.gmBlackBoxY;
+		m_xoffset = gm.gmptGlyphOrigin.x;
+		m_advance = gm.gmCellIncX;
+		m_yoffset = fontAscent - gm.gmptGlyphOrigin.y;
+
+		// GetGlyphOutline sometimes returns the incorrect height, usually when the
+		// glyph have accentual marks very high up. We can calculate the true height 
+		// from the buffer size. 
+
+		// Actually, it is not possible to calculate the true height. If the glyph is too far
+		// outside the cell height, then the blackbox may not reflect the true width or height
+		// thus we do not have anything that can be trusted for recalculating the height. This
+		// is why I decided to abandon this way of rendering.
+
+		UINT pitch = m_width;
+		if( pitch & 0x3 ) pitch += 4 - (pitch & 0x3);
+		if( d / pitch > (unsigned)m_height ) 
+		{
+			m_yoffset -= d / pitch - m_height;
+			m_height = d / pitch;
+		}
+
+        // Create the image
+		m_charImg = new CGlyphImage(m_width, m_height, e_glyph8);
+		m_charImg->Clear();
+
+		// Get the actual bitmap
+		if( d > 0 )
+		{
+			BYTE *tmpPixels = new BYTE[d];
+			if( useUnicode )
+				d = GetGlyphOutlineW(dc,idx,GGO_GLYPH_INDEX|(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,d,tmpPixels,&mat);
+			else
+				d = GetGlyphOutlineA(dc,idx,(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,d,tmpPixels,&mat);
+
+			if( useSmoothing )
+			{
+				// The above outputs the glyph with 65 levels of gray, so we need to convert this to 256 levels of gray
+				for( int y = 0; y < m_charImg->height; y++ )
+				{
+					for( int x = 0; x < m_charImg->width; x++ )
+					{
+						BYTE v = 255 * tmpPixels[x+y*pitch] / 64;
+						m_charImg->pixels8[x+y*m_charImg->width] = v;
+					}
+				}
+			}
+			else
+			{
+				UINT pitch = m_charImg->width / 8 + ((m_charImg->width & 0x7) ? 1 : 0);
+				if( pitch & 0x3 ) pitch += 4 - (pitch & 0x3);
+
+				// The above outputs a glyph in a monochrome bitmap
+				for( int y = 0; y < m_charImg->height; y++ )
+				{
+					for( int x = 0; x < m_charImg->width; )
+					{
+						// Transform each byte into 8 pixels
+						for( int bit = 7; bit >= 0 && x < m_charImg->width; bit--, x++ )
+						{
+							m_charImg->pixels8[x+y*m_charImg->width] = ((tmpPixels[x/8+y*pitch] >> bit) & 1) ? 0xFF : 0; 
+						}
+					}
+				}
+			}
+
+			delete[] tmpPixels;
+		}
+	}
+*/
+
+	// GetGlyphOutline only works for true type fonts, so we need a fallback for other fonts
+
+	// Determine the size needed for the char
+	ABC abc;
+	GetABCWidths(ch, abc);
+	int width = int(abc.abcB);
+
+	// If the requested font size is too large, the Windows API has a  
+	// bug that causes negative width to be returned in some cases
+	if( width < 0 )
+		width = 0;
+
+	bitmap.xoffset = abc.abcA;
+	bitmap.advance = (abc.abcA + width + abc.abcC);
+
+	if( width == 0 )
+		return 0;
+
+	// We need to add extra width, because width received from GDI 
+	// doesn't always account for overhang, e.g. due to italic style
+	UINT extraWidth = width;
+	width += extraWidth*2;
+	bitmap.xoffset -= extraWidth;
+
+	// Create the image that will receive the pixels
+	CGlyphImage *img = new (std::nothrow) CGlyphImage(width, scaledHeight, e_glyph8);
+	if( img == 0 || img->pixels8 == 0 )
+	{
+		// Oops, I'm out of memory
+		delete img;
+		return -2;
+	}
+
+	// Draw the character
+	DWORD *pixels;
+	BITMAPINFO bmi;
+	ZeroMemory(&bmi, sizeof(BITMAPINFO));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = img->width;
+	bmi.bmiHeader.biHeight = -img->height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;         
+	bmi.bmiHeader.biCompression = BI_RGB;
+	bmi.bmiHeader.biSizeImage = img->width * img->height * 4;
+
+	HBITMAP bm = CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, (void**)&pixels, 0, 0);
+	if( bm == 0 )
+	{
+		// Oops, I'm out of memory
+		delete img;
+		return -2;
+	}
+
+	HBITMAP oldBM = (HBITMAP)SelectObject(dc, bm);
+
+	memset(pixels, 0, bmi.bmiHeader.biSizeImage);
+
+	SetTextColor(dc, RGB(255,255,255));
+	SetBkColor(dc, RGB(0,0,0));
+	SetBkMode(dc, TRANSPARENT);
+	if( useUnicode )
+	{
+		WCHAR buf[2];
+		int length = acUtility::EncodeUTF16(ch, (unsigned char*)buf, 0);
+		TextOutW(dc, extraWidth-abc.abcA, 0, buf, length/2);
+	}
+	else
+		TextOutA(dc, extraWidth-abc.abcA, 0, (char*)&ch, 1);
+
+	GdiFlush();
+
+	// Retrieve the pixels to the image
+	if( useClearType )
+	{
+		// Need to convert the red and blue levels to grayscale
+		for( int n = 0; n < img->width*img->height; n++ )
+		{
+			UINT c = pixels[n];
+			c = (c&0xFF) + ((c>>8)&0xFF) + ((c>>16)&0xFF);
+			img->pixels8[n] = BYTE(c / 3);
+		}
+	}
+	else
+	{
+		// The text is drawn in white so all color channels hold the same value
+		for( int n = 0; n < img->width*img->height; n++ )
+			img->pixels8[n] = BYTE(pixels[n]);
+	}
+
+	// Clean up
+	SelectObject(dc, oldBM);
+	DeleteObject(bm);
+
+	bitmap.image = img;
+
+	return 0;
+}
+
+void CGdiFontBackend::GetKerningPairs(vector<KERNINGPAIR> &pairs, vector<UINT> &/*chars*/)
+{
+	if( useUnicode )
+	{
+		// TODO: How do I obtain the kerning pairs for 
+		// the characters in the higher planes?
+
+		int num = GetKerningPairsW(dc, 0, 0);
+		if( num > 0 )
+		{
+			pairs.resize(num);
+			GetKerningPairsW(dc, num, &pairs[0]);
+		}
+	}
+	else
+	{
+		int num = GetKerningPairsA(dc, 0, 0);
+		if( num > 0 )
+		{
+			pairs.resize(num);
+			GetKerningPairsA(dc, num, &pairs[0]);
+		}
+	}
+}
+
+int CGdiFontBackend::GetDesignKerningPairs(vector<KERNINGPAIR> &/*pairs*/, vector<UINT> &/*chars*/)
+{
+	// GDI adjusts the kerning pairs for the font size itself
+	return -1;
+}
+
+float CGdiFontBackend::GetDesignUnitScale()
+{
+	return DetermineDesignUnitToFontUnitFactor(dc);
+}
+
+int CGdiFontBackend::GetFontTable(DWORD tag, vector<BYTE> &data)
+{
+	data.clear();
+
+	DWORD size = GetFontData(dc, tag, 0, 0, 0);
+	if( size == GDI_ERROR || size == 0 )
+		return -1;
+
+	data.resize(size);
+	if( GetFontData(dc, tag, 0, &data[0], size) != size )
+	{
+		data.clear();
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,398 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "fontbatch.h"
+#include "fontgen.h"
+#include "fontbackend.h"
+#include "acutil_path.h"
+#include "ac_string_util.h"
+
+using namespace std;
+
+// Reads the next argument on the line, which may be within quotes
+static const char *GetArgValue(const char *line, string &value)
+{
+	line += strspn(line, " \t");
+	int end;
+	if( *line == '"' )
+	{
+		end = (int)strcspn(++line, "\"");
+		value.assign(line, end);
+		if( line[end] == '"' )
+			end++;
+	}
+	else
+	{
+		end = (int)strcspn(line, " \t");
+		value.assign(line, end);
+	}
+	return line + end;
+}
+
+CFontBatch::CFontBatch()
+{
+	numThreads = -1;
+}
+
+CFontBatch::~CFontBatch()
+{
+	threadPool.Stop();
+}
+
+int CFontBatch::LoadManifest(const string &file, string &error)
+{
+	ifstream f(file.c_str());
+	if( !f.is_open() )
+	{
+		error = acStringFormat("Failed to read the manifest '%s'.", file.c_str());
+		return -1;
+	}
+
+	string buffer;
+	for( int lineNum = 1; getline(f, buffer); lineNum++ )
+	{
+		if( buffer.length() && buffer[buffer.length()-1] == '\r' )
+			buffer.resize(buffer.length()-1);
+
+		const char *line = buffer.c_str();
+		line += strspn(line, " \t");
+		if( *line == 0 || *line == '#' )
+			continue;
+
+		string configFile, outputFile, textFile;
+		while( *line == '-' )
+		{
+			line++;
+			if( *line == 'c' )
+				line = GetArgValue(++line, configFile);
+			else if( *line == 'o' )
+				line = GetArgValue(++line, outputFile);
+			else if( *line == 't' )
+				line = GetArgValue(++line, textFile);
+			else
+				break;
+
+			line += strspn(line, " \t");
+		}
+
+		if( *line != 0 || configFile == "" || outputFile == "" )
+		{
+			error = acStringFormat("Invalid job on line %d of the manifest '%s'. Each job has -c and -o, and optionally -t.", lineNum, file.c_str());
+			return -2;
+		}
+
+		// The paths are relative to the manifest
+		configFile = acUtility::GetFullPath(file, configFile);
+		outputFile = acUtility::GetFullPath(file, outputFile);
+		if( textFile != "" )
+			textFile = acUtility::GetFullPath(file, textFile);
+
+		AddJob(configFile, outputFile, textFile);
+	}
+
+	return 0;
+}
+
+void CFontBatch::AddJob(const string &configFile, const string &outputFile, const string &textFile)
+{
+	SBatchJob job;
+	job.configFile = configFile;
+	job.outputFile = outputFile;
+	job.textFile   = textFile;
+	jobs.push_back(job);
+}
+
+int CFontBatch::GetNumJobs() const
+{
+	return (int)jobs.size();
+}
+
+const SBatchJob &CFontBatch::GetJob(int n) const
+{
+	return jobs[n];
+}
+
+void CFontBatch::SetNumThreads(int threads)
+{
+	numThreads = threads;
+}
+
+int CFontBatch::Run(bool quiet)
+{
+	int numFailed = 0;
+	for( unsigned int n = 0; n < jobs.size(); n++ )
+	{
+		if( !quiet && jobs.size() > 1 ) 
+			cout << "Job " << n+1 << " of " << jobs.size() << ": " << jobs[n].configFile << endl;
+
+		if( RunJob(jobs[n], quiet) != e_jobSucceeded )
+			numFailed++;
+	}
+
+	if( !quiet && jobs.size() > 1 )
+		cout << jobs.size() - numFailed << " of " << jobs.size() << " fonts were generated." << endl;
+
+	return numFailed;
+}
+
+// Output file for one of the sizes when the configuration has several font sizes
+static string GetSizeOutputFile(const string &outputFile, int size)
+{
+	string base = outputFile;
+	if( base.length() >= 4 && _stricmp(base.substr(base.length() - 4).c_str(), ".fnt") == 0 )
+		base = base.substr(0, base.length() - 4);
+	return acStringFormat("%s_%d.fnt", base.c_str(), size);
+}
+
+void CFontBatch::SizeThread(SSizeJob *sizeJob)
+{
+	CFontGen *fontGen = sizeJob->fontGen;
+	int r = sizeJob->drawOnly ? fontGen->DrawChars() : fontGen->GeneratePages(false);
+	if( r < 0 || fontGen->GetError() < 0 )
+		sizeJob->result = e_jobGenerateError;
+	else if( sizeJob->save && fontGen->SaveFont(sizeJob->outputFile.c_str()) < 0 )
+		sizeJob->result = e_jobSaveError;
+	else
+		sizeJob->result = e_jobSucceeded;
+}
+
+CFontGen *CFontBatch::LoadFont(const SBatchJob &job, bool quiet, int &result)
+{
+	CFontGen *fontGen = new CFontGen();
+	fontGen->SetFontCache(&fontCache);
+
+	result = e_jobSucceeded;
+	if( !quiet ) cout << "Loading config." << endl;
+	if( fontGen->LoadConfiguration(job.configFile.c_str()) < 0 )
+	{
+		cerr << "Failed to load the configuration file '" << job.configFile << "'." << endl;
+		result = e_jobInputError;
+	}
+
+	// A font that can't be loaded would otherwise just give a font without characters
+	if( result == e_jobSucceeded )
+	{
+		CFontBackend *backend = CFontBackend::Create(fontGen->GetFontBackend());
+		if( backend == 0 || backend->Open(fontGen, 0) < 0 )
+		{
+			cerr << "Failed to load the font '" << (fontGen->GetFontFile() != "" ? fontGen->GetFontFile() : fontGen->GetFontName()) << "'." << endl;
+			result = e_jobInputError;
+		}
+		delete backend;
+	}
+
+	if( result == e_jobSucceeded && job.textFile != "" )
+	{
+		if( !quiet ) cout << "Selecting characters from file." << endl;
+		if( fontGen->SelectCharsFromFile(job.textFile.c_str()) < 0 )
+		{
+			cerr << "Failed to read the text file '" << job.textFile << "'." << endl;
+			result = e_jobInputError;
+		}
+	}
+
+	if( result == e_jobSucceeded )
+	{
+		// The worker threads are started with the first job
+		if( threadPool.GetNumThreads() == 0 )
+			threadPool.Start(numThreads >= 0 ? numThreads : fontGen->GetNumThreads());
+		fontGen->SetThreadPool(&threadPool);
+	}
+
+	return fontGen;
+}
+
+int CFontBatch::RunJob(SBatchJob &job, bool quiet)
+{
+	CFontGen *fontGen = LoadFont(job, quiet, job.result);
+	vector<int> sizes = fontGen->GetFontSizes();
+	if( job.result == e_jobSucceeded && sizes.size() > 1 )
+	{
+		delete fontGen;
+		return RunSizes(job, sizes, quiet);
+	}
+
+	if( job.result == e_jobSucceeded )
+	{
+		if( !quiet ) cout << "Generating pages." << endl;
+		if( fontGen->GeneratePages(false) < 0 || fontGen->GetError() < 0 )
+		{
+			cerr << "Failed to generate the characters. The font couldn't be loaded or there wasn't enough memory." << endl;
+			job.result = e_jobGenerateError;
+		}
+	}
+
+	if( job.result == e_jobSucceeded )
+	{
+		ReportPages(fontGen, quiet);
+
+		if( !quiet ) cout << "Saving font." << endl;
+		if( fontGen->SaveFont(job.outputFile.c_str()) < 0 )
+		{
+			cerr << "Failed to save the font to '" << job.outputFile << "'." << endl;
+			job.result = e_jobSaveError;
+		}
+	}
+
+	delete fontGen;
+
+	if( !quiet && job.result == e_jobSucceeded ) cout << "Finished." << endl;
+
+	return job.result;
+}
+
+// Generates each of the font sizes in the configuration with its own generator. 
+// The generators share the font cache, so the existing characters and the 
+// kerning pairs are determined only once, while the glyphs for the different 
+// sizes are rasterized in parallel on the shared worker threads.
+int CFontBatch::RunSizes(SBatchJob &job, const vector<int> &sizes, bool quiet)
+{
+	vector<SSizeJob> sizeJobs(sizes.size());
+	for( unsigned int n = 0; n < sizes.size(); n++ )
+	{
+		sizeJobs[n].fontGen = LoadFont(job, true, sizeJobs[n].result);
+		if( sizeJobs[n].result != e_jobSucceeded )
+			job.result = sizeJobs[n].result;
+		sizeJobs[n].fontGen->SetFontSize(sizes[n]);
+		sizeJobs[n].outputFile = GetSizeOutputFile(job.outputFile, sizes[n]);
+		sizeJobs[n].save = true;
+		sizeJobs[n].drawOnly = false;
+	}
+
+	// With a shared atlas all the sizes are packed on the pages of the first size
+	CFontGen *owner = sizeJobs[0].fontGen;
+	bool sharedAtlas = owner->GetSharedAtlas();
+
+	if( job.result == e_jobSucceeded )
+	{
+		if( !quiet ) cout << "Generating pages for " << sizes.size() << " font sizes." << endl;
+
+		// The owner only draws its characters while the other sizes are drawn, 
+		// as it can't place them on the pages until all of them are done
+		if( sharedAtlas )
+		{
+			for( unsigned int n = 1; n < sizeJobs.size(); n++ )
+				sizeJobs[n].fontGen->SetAtlasOwner(owner);
+			for( unsigned int n = 0; n < sizeJobs.size(); n++ )
+				sizeJobs[n].save = false;
+			sizeJobs[0].drawOnly = true;
+		}
+
+		vector<thread*> threads;
+		for( unsigned int n = 0; n < sizeJobs.size(); n++ )
+			threads.push_back(new thread(SizeThread, &sizeJobs[n]));
+		for( unsigned int n = 0; n < threads.size(); n++ )
+		{
+			threads[n]->join();
+			delete threads[n];
+		}
+
+		// The owner packs the characters of all the sizes, and the texture files 
+		// must be saved before the other sizes can refer to them in their fonts
+		if( sharedAtlas )
+		{
+			if( sizeJobs[0].result == e_jobSucceeded )
+			{
+				sizeJobs[0].drawOnly = false;
+				sizeJobs[0].save     = true;
+				SizeThread(&sizeJobs[0]);
+			}
+			for( unsigned int n = 1; n < sizeJobs.size(); n++ )
+			{
+				if( sizeJobs[n].result != e_jobSucceeded )
+					continue;
+				if( sizeJobs[0].result != e_jobSucceeded )
+					sizeJobs[n].result = sizeJobs[0].result;
+				else if( sizeJobs[n].fontGen->SaveFont(sizeJobs[n].outputFile.c_str()) < 0 )
+					sizeJobs[n].result = e_jobSaveError;
+			}
+		}
+
+		for( unsigned int n = 0; n < sizeJobs.size(); n++ )
+		{
+			if( sizeJobs[n].result == e_jobGenerateError )
+				cerr << "Failed to generate the characters for size " << sizes[n] << ". The font couldn't be loaded or there wasn't enough memory." << endl;
+			else if( sizeJobs[n].result == e_jobSaveError )
+				cerr << "Failed to save the font to '" << sizeJobs[n].outputFile << "'." << endl;
+			else
+			{
+				if( !quiet ) cout << "Size " << sizes[n] << ": " << sizeJobs[n].outputFile << endl;
+				if( !sharedAtlas || n == 0 )
+					ReportPages(sizeJobs[n].fontGen, quiet);
+			}
+
+			if( sizeJobs[n].result != e_jobSucceeded && job.result == e_jobSucceeded )
+				job.result = sizeJobs[n].result;
+		}
+	}
+
+	// The fonts sharing the pages are detached from the owner when deleted
+	for( unsigned int n = sizeJobs.size(); n-- > 0; )
+		delete sizeJobs[n].fontGen;
+
+	if( !quiet && job.result == e_jobSucceeded ) cout << "Finished." << endl;
+
+	return job.result;
+}
+
+void CFontBatch::ReportPages(CFontGen *fontGen, bool quiet)
+{
+	if( !quiet ) 
+	{
+		cout << "Texture size " << fontGen->GetPageWidth() << "x" << fontGen->GetPageHeight() << ", " 
+		     << fontGen->GetNumPages() << " page(s), " << int(fontGen->GetFillRatio()*100 + 0.5f) << "% filled." << endl;
+
+		// Report how well each page was used
+		for( int n = 0; n < fontGen->GetNumPages(); n++ )
+		{
+			SPageStats stats;
+			if( fontGen->GetPageStats(n, stats) < 0 )
+				continue;
+
+			double area = double(stats.width) * stats.height * stats.numChannels;
+			cout << acStringFormat("Page %d: %d chars, %.1f%% used, %.1f%% spacing, %.1f%% holes, %.1f%% free above skyline, packed in %.2f ms", 
+			                       n, stats.numChars, 100*stats.usedArea/area, 100*stats.spacingArea/area, 100*stats.holeArea/area, 
+			                       100*stats.skylineArea/area, stats.packTime) << endl;
+			if( stats.numChannels == 4 )
+			{
+				double chnlArea = double(stats.width) * stats.height;
+				cout << acStringFormat("        channel fill: blue %.1f%%, green %.1f%%, red %.1f%%, alpha %.1f%%", 
+				                       100*stats.channelArea[0]/chnlArea, 100*stats.channelArea[1]/chnlArea, 
+				                       100*stats.channelArea[2]/chnlArea, 100*stats.channelArea[3]/chnlArea) << endl;
+			}
+		}
+		cout << acStringFormat("Packing took %.2f ms.", fontGen->GetPackingTime()) << endl;
+	}
+
+	if( fontGen->GetNumFailedChars() > 0 )
+		cerr << "Warning: " << fontGen->GetNumFailedChars() << " character(s) didn't fit on the pages." << endl;
+}
@@ -0,0 +1,117 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef FONTBATCH_H
+#define FONTBATCH_H
+
+#include <string>
+#include <vector>
+
+#include "acutil_threadpool.h"
+#include "fontcache.h"
+
+class CFontGen;
+
+enum EBatchJobResult
+{
+	e_jobNotRun,
+	e_jobSucceeded,
+	e_jobInputError,
+	e_jobGenerateError,
+	e_jobSaveError
+};
+
+struct SBatchJob
+{
+	SBatchJob() {result = e_jobNotRun;}
+
+	std::string configFile;
+	std::string outputFile;
+	std::string textFile;
+	int         result;
+};
+
+// Generates a list of fonts in one process. The jobs are generated one 
+// after the other, but they share the worker threads, and jobs that use 
+// the same font share the loaded font data and the scan for the existing 
+// characters, so only the first job with a font pays for it. A job whose 
+// configuration lists several font sizes generates one font per size.
+class CFontBatch
+{
+public:
+	CFontBatch();
+	~CFontBatch();
+
+	// Reads the jobs from a manifest file. Each line has the same -c, -o, 
+	// and -t arguments as the command line, and relative paths are relative 
+	// to the manifest. Empty lines and lines starting with # are ignored.
+	// Returns -1 if the file couldn't be read, or -2 if a line is invalid, 
+	// in which case the error describes the line.
+	int  LoadManifest(const std::string &file, std::string &error);
+	void AddJob(const std::string &configFile, const std::string &outputFile, const std::string &textFile);
+
+	int              GetNumJobs() const;
+	const SBatchJob &GetJob(int n) const;
+
+	// Number of worker threads shared by the jobs. If negative, which 
+	// is the default, the threads option of the first job is used.
+	void SetNumThreads(int threads);
+
+	// Generates all the jobs, reporting the progress on the standard 
+	// output unless quiet. Returns the number of jobs that failed.
+	int  Run(bool quiet);
+
+	// Reports the size and use of the generated pages on the standard output, 
+	// unless quiet, and warns about characters that didn't fit the pages
+	static void ReportPages(CFontGen *fontGen, bool quiet);
+
+protected:
+	struct SSizeJob
+	{
+		CFontGen   *fontGen;
+		std::string outputFile;
+		bool        save;
+		bool        drawOnly;
+		int         result;
+	};
+
+	CFontGen   *LoadFont(const SBatchJob &job, bool quiet, int &result);
+	int         RunJob(SBatchJob &job, bool quiet);
+	int         RunSizes(SBatchJob &job, const std::vector<int> &sizes, bool quiet);
+	static void SizeThread(SSizeJob *sizeJob);
+
+	std::vector<SBatchJob> jobs;
+	int                    numThreads;
+	acUtility::CThreadPool threadPool;
+	CFontCache             fontCache;
+
+private:
+	CFontBatch(const CFontBatch &);
+	CFontBatch &operator=(const CFontBatch &);
+};
+
+#endif
@@ -0,0 +1,211 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <stdio.h>
+#include <new>
+
+#include "fontcache.h"
+#include "fontgen.h"
+#include "fontbackend.h"
+#include "unicode.h"
+#include "chartable.h"
+#include "ac_string_util.h"
+
+using namespace std;
+
+CFontCache::CFontCache()
+{
+}
+
+CFontCache::~CFontCache()
+{
+	Clear();
+}
+
+void CFontCache::Clear()
+{
+	lock_guard<mutex> glyphsGuard(glyphsLock);
+	lock_guard<mutex> kerningGuard(kerningLock);
+	lock_guard<mutex> charsGuard(charsLock);
+	lock_guard<mutex> fileGuard(fileLock);
+
+	for( multimap<string, SKerning *>::iterator it = kerning.begin(); it != kerning.end(); ++it )
+		delete it->second;
+	kerning.clear();
+
+	for( multimap<string, SGlyphs *>::iterator it = glyphs.begin(); it != glyphs.end(); ++it )
+	{
+		delete it->second->glyphMap;
+		delete it->second;
+	}
+	glyphs.clear();
+
+	for( map<string, vector<BYTE> *>::iterator it = fileData.begin(); it != fileData.end(); ++it )
+		delete it->second;
+	fileData.clear();
+
+	for( map<string, CCharSet *>::iterator it = existingChars.begin(); it != existingChars.end(); ++it )
+		delete it->second;
+	existingChars.clear();
+}
+
+const vector<BYTE> *CFontCache::GetFontFileData(const string &file)
+{
+	lock_guard<mutex> guard(fileLock);
+
+	map<string, vector<BYTE> *>::iterator it = fileData.find(file);
+	if( it != fileData.end() )
+		return it->second;
+
+	// A file that can't be read is remembered too, so it isn't tried again
+	vector<BYTE> *data = 0;
+	FILE *f = 0;
+	errno_t e = fopen_s(&f, file.c_str(), "rb");
+	if( e == 0 && f )
+	{
+		fseek(f, 0, SEEK_END);
+		long size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		if( size > 0 )
+		{
+			data = new (std::nothrow) vector<BYTE>;
+			if( data )
+			{
+				try
+				{
+					data->resize(size);
+				}
+				catch( std::bad_alloc & )
+				{
+					delete data;
+					data = 0;
+				}
+			}
+
+			if( data && fread(&(*data)[0], 1, size, f) != (size_t)size )
+			{
+				delete data;
+				data = 0;
+			}
+		}
+
+		fclose(f);
+	}
+
+	fileData[file] = data;
+	return data;
+}
+
+// All the properties that decide which font is used and which 
+// characters are looked for, but not the size of the font
+string CFontCache::GetFontKey(const CFontGen *gen)
+{
+	return acStringFormat("%d|%s|%s|%d|%d|%d|%d", gen->GetFontBackend(), gen->GetFontName().c_str(), 
+	                      gen->GetFontFile().c_str(), gen->GetCharSet(), gen->IsBold(), gen->IsItalic(), 
+	                      gen->IsUsingUnicode());
+}
+
+const CCharSet *CFontCache::GetExistingChars(const CFontGen *gen)
+{
+	string key = GetFontKey(gen);
+
+	lock_guard<mutex> guard(charsLock);
+
+	map<string, CCharSet *>::iterator it = existingChars.find(key);
+	if( it != existingChars.end() )
+		return it->second;
+
+	CCharSet *chars = new (std::nothrow) CCharSet;
+	if( chars && gen->ScanExistingChars(*chars) < 0 )
+	{
+		delete chars;
+		chars = 0;
+	}
+
+	existingChars[key] = chars;
+	return chars;
+}
+
+const vector<KERNINGPAIR> *CFontCache::GetDesignKerningPairs(const CFontGen *gen, CFontBackend *backend, const vector<UINT> &chars)
+{
+	string key = GetFontKey(gen);
+
+	lock_guard<mutex> guard(kerningLock);
+
+	// The pairs are only given for the characters they were read for
+	pair<multimap<string, SKerning *>::iterator, multimap<string, SKerning *>::iterator> range = kerning.equal_range(key);
+	for( multimap<string, SKerning *>::iterator it = range.first; it != range.second; ++it )
+	{
+		if( it->second->chars == chars )
+			return it->second->isSupported ? &it->second->pairs : 0;
+	}
+
+	SKerning *k = new (std::nothrow) SKerning;
+	if( k == 0 )
+		return 0;
+
+	k->chars       = chars;
+	k->isSupported = backend->GetDesignKerningPairs(k->pairs, k->chars) >= 0;
+	if( k->isSupported && k->pairs.size() == 0 )
+		GetKerningPairsFromGPOS(backend, k->pairs, k->chars, 1);
+
+	kerning.insert(multimap<string, SKerning *>::value_type(key, k));
+	return k->isSupported ? &k->pairs : 0;
+}
+
+const CGlyphMap *CFontCache::GetGlyphMap(const CFontGen *gen, CFontBackend *backend, const vector<int> &chars)
+{
+	string key = GetFontKey(gen);
+
+	lock_guard<mutex> guard(glyphsLock);
+
+	// The map is only given for the characters it was built for
+	pair<multimap<string, SGlyphs *>::iterator, multimap<string, SGlyphs *>::iterator> range = glyphs.equal_range(key);
+	for( multimap<string, SGlyphs *>::iterator it = range.first; it != range.second; ++it )
+	{
+		if( it->second->chars == chars )
+			return it->second->glyphMap;
+	}
+
+	SGlyphs *g = new (std::nothrow) SGlyphs;
+	if( g == 0 )
+		return 0;
+
+	g->glyphMap = new (std::nothrow) CGlyphMap;
+	if( g->glyphMap == 0 )
+	{
+		delete g;
+		return 0;
+	}
+
+	g->chars = chars;
+	g->glyphMap->BuildGlyphs(backend, g->chars);
+
+	glyphs.insert(multimap<string, SGlyphs *>::value_type(key, g));
+	return g->glyphMap;
+}
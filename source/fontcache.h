@@ -0,0 +1,104 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+
+#include "platform.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+class CFontGen;
+class CFontBackend;
+class CCharSet;
+class CGlyphMap;
+
+// Keeps the data that only depends on the font, so that generators that use 
+// the same font, e.g. in a batch of fonts, don't have to load and scan the 
+// font again. The cache can be used from several threads at the same time.
+class CFontCache
+{
+public:
+	CFontCache();
+	~CFontCache();
+
+	// Returns the content of the font file. The file is only read the 
+	// first time. Returns null if the file couldn't be read.
+	const std::vector<BYTE> *GetFontFileData(const std::string &file);
+
+	// Returns the characters that exist in the font used by the generator. 
+	// The font is only scanned the first time for each font and style. 
+	// Returns null if the font couldn't be opened.
+	const CCharSet *GetExistingChars(const CFontGen *gen);
+
+	// Returns the kerning pairs in design units for the characters, so they 
+	// can be scaled to each size of the font. The font tables are only read 
+	// the first time. Returns null if the backend doesn't support it.
+	const std::vector<KERNINGPAIR> *GetDesignKerningPairs(const CFontGen *gen, CFontBackend *backend, const std::vector<UINT> &chars);
+
+	// Returns the glyph indices of the characters, which are the same for all 
+	// sizes of the font. The backend is only used the first time for the font 
+	// and the characters. Returns null if out of memory.
+	const CGlyphMap *GetGlyphMap(const CFontGen *gen, CFontBackend *backend, const std::vector<int> &chars);
+
+	void Clear();
+
+protected:
+	struct SKerning
+	{
+		std::vector<UINT>        chars;
+		std::vector<KERNINGPAIR> pairs;
+		bool                     isSupported;
+	};
+
+	struct SGlyphs
+	{
+		std::vector<int> chars;
+		CGlyphMap       *glyphMap;
+	};
+
+	static std::string GetFontKey(const CFontGen *gen);
+
+	// The font is scanned while holding the charsLock, and the 
+	// backend may then need the file data, so they have separate locks
+	std::mutex                                   fileLock;
+	std::map<std::string, std::vector<BYTE> *>   fileData;
+	std::mutex                                   charsLock;
+	std::map<std::string, CCharSet *>            existingChars;
+	std::mutex                                   kerningLock;
+	std::multimap<std::string, SKerning *>       kerning;
+	std::mutex                                   glyphsLock;
+	std::multimap<std::string, SGlyphs *>        glyphs;
+
+private:
+	CFontCache(const CFontCache &);
+	CFontCache &operator=(const CFontCache &);
+};
+
+#endif
@@ -26,22 +26,146 @@
 */
 
 #include <math.h>
+#include <string.h>
 #include "fontchar.h"
-#include "unicode.h"
-#include "acutil_unicode.h"
 #include "fontgen.h"
-#include "dynamic_funcs.h"
-#include <assert.h>
+#include "downscale.h"
+#include "distfield.h"
+#include "msdf.h"
+#include "rasterizer.h"
+
+static const char *outlineMethodNames[e_numOutlineMethods] = 
+{
+	"kernel",
+	"distance"
+};
+
+const char *GetOutlineMethodName(int method)
+{
+	if( method < 0 || method >= e_numOutlineMethods )
+		return outlineMethodNames[e_outlineKernel];
+
+	return outlineMethodNames[method];
+}
+
+int GetOutlineMethodFromName(const char *name)
+{
+	for( int n = 0; n < e_numOutlineMethods; n++ )
+	{
+		if( _stricmp(name, outlineMethodNames[n]) == 0 )
+			return n;
+	}
+
+	return -1;
+}
+
+static const char *distanceFieldNames[e_numDistanceFields] = 
+{
+	"none",
+	"sdf",
+	"msdf"
+};
+
+const char *GetDistanceFieldName(int type)
+{
+	if( type < 0 || type >= e_numDistanceFields )
+		return distanceFieldNames[e_distanceFieldNone];
+
+	return distanceFieldNames[type];
+}
+
+int GetDistanceFieldFromName(const char *name)
+{
+	for( int n = 0; n < e_numDistanceFields; n++ )
+	{
+		if( _stricmp(name, distanceFieldNames[n]) == 0 )
+			return n;
+	}
+
+	return -1;
+}
+
+CGlyphImage::CGlyphImage()
+{
+	width   = 0;
+	height  = 0;
+	format  = e_glyph8;
+	pixels8 = 0;
+}
+
+CGlyphImage::CGlyphImage(int width, int height, int format)
+{
+	pixels8 = 0;
+	Create(width, height, format);
+}
+
+CGlyphImage::~CGlyphImage()
+{
+	if( pixels8 )
+		delete[] pixels8;
+}
+
+int CGlyphImage::Create(int w, int h, int f)
+{
+	if( pixels8 )
+		delete[] pixels8;
+
+	format  = f;
+	pixels8 = new (std::nothrow) BYTE[w*h*GetBytesPerPixel()];
+	if( pixels8 == 0 )
+	{
+		width  = 0;
+		height = 0;
+		return -1;
+	}
+
+	width  = w;
+	height = h;
+	return 0;
+}
+
+void CGlyphImage::Clear()
+{
+	if( pixels8 )
+		memset(pixels8, 0, width*height*GetBytesPerPixel());
+}
+
+int CGlyphImage::GetBytesPerPixel() const
+{
+	if( format == e_glyphOutline16 ) return 2;
+	if( format == e_color32 ) return 4;
+	return 1;
+}
+
+DWORD CGlyphImage::GetColor(int x, int y) const
+{
+	if( format == e_glyph8 )
+	{
+		DWORD c = pixels8[y*width+x];
+		return c | (c<<8) | (c<<16) | (c<<24);
+	}
+	else if( format == e_glyphOutline16 )
+	{
+		DWORD c = pixels16[y*width+x];
+		DWORD g = c & 0xFF;
+		return ((c>>8)<<24) | (g<<16) | (g<<8) | g;
+	}
+
+	return pixels32[y*width+x];
+}
 
 CFontChar::CFontChar()
 {
 	m_charImg = 0;
+	m_shape   = 0;
 }
 
 CFontChar::~CFontChar()
 {
 	if( m_charImg )
 		delete m_charImg;
+	if( m_shape )
+		delete m_shape;
 }
 
 void CFontChar::CreateFromImage(int ch, cImage *image, int xoffset, int yoffset, int advance)
@@ -55,11 +179,11 @@ void CFontChar::CreateFromImage(int ch, cImage *image, int xoffset, int yoffset,
 	m_yoffset = yoffset;
 	m_colored = true;
 
-	m_charImg = new cImage(image->width, image->height);
-	m_charImg->isTopDown = true;
+	m_charImg = new CGlyphImage(image->width, image->height, e_color32);
 
 	// Copy the input image to charImg
-	memcpy(m_charImg->pixels, image->pixels, m_width*m_height*4);
+	for( int n = 0; n < m_width*m_height; n++ )
+		m_charImg->pixels32[n] = image->pixels[n];
 }
 
 bool CFontChar::HasOutline()
@@ -77,7 +201,7 @@ BYTE CFontChar::GetPixelValue(int x, int y, int encoding)
 		// Does the character have an outline?
 		if( m_colored )
 		{
-			DWORD color = m_charImg->pixels[y*m_charImg->width+x];
+			WORD color = m_charImg->pixels16[y*m_charImg->width+x];
 			if( BYTE(color) )
 			{
 				if( encoding == e_glyph )
@@ -92,204 +216,157 @@ BYTE CFontChar::GetPixelValue(int x, int y, int encoding)
 				if( encoding == e_glyph )
 					return 0;
 				else if( encoding == e_outline )
-                    return BYTE(color>>24);
+                    return BYTE(color>>8);
 				else if( encoding == e_glyph_outline )
-					return BYTE(color>>25);
+					return BYTE(color>>9);
 			}
 		}
 		else
 		{
 			// Since the character has no outline we 
 			// always return the same value
-			return (BYTE)m_charImg->pixels[y*m_charImg->width+x];
+			return m_charImg->pixels8[y*m_charImg->width+x];
 		}
 	}
 
 	return 0;
 }
 
-int CFontChar::DrawInvalidCharGlyph(HFONT font, const CFontGen *gen)
+int CFontChar::DrawInvalidCharGlyph(SRasterContext &ctx, const CFontGen *gen)
 {
 	m_id = -1;
-	return DrawGlyph(font, 0xFFFF, gen);
+	int r = DrawGlyph(ctx, 0xFFFF, gen);
+	if( r >= 0 )
+		FinishGlyph(ctx.fontHeight, gen);
+	return r;
 }
 
-int CFontChar::DrawChar(HFONT font, int ch, const CFontGen *gen)
+int CFontChar::DrawChar(SRasterContext &ctx, int ch, const CFontGen *gen)
 {
 	m_id = ch;
-	return DrawGlyph(font, ch, gen);
+	int r = DrawGlyph(ctx, ch, gen);
+	if( r >= 0 )
+		FinishGlyph(ctx.fontHeight, gen);
+	return r;
 }
 
-int CFontChar::DrawGlyphFromOutline(HDC dc, int ch, int fontHeight, int fontAscent, const CFontGen *gen)
+int CFontChar::DrawGlyphFromOutline(SRasterContext &ctx, int ch, int fontAscent, const CFontGen *gen)
 {
-	// Get the glyph info
-	int idx;
-	if( gen->IsUsingUnicode() )
-	{
-		idx = GetUnicodeGlyphIndex(dc, 0, ch);
-		if( idx < 0 )
-		{
-			// Get the default character instead
-			TEXTMETRICW tm;
-			GetTextMetricsW(dc, &tm);
-			WORD glyph;
-			fGetGlyphIndicesW(dc, &tm.tmDefaultChar, 1, &glyph, 0);
-			idx = glyph;
-		}
-	}
-	else
-	{
-		idx = ch;
-	}
+	// The largest distance in pixels between the curves and the polygons
+	const double flatness = 1/32.0;
 
-	GLYPHMETRICS gm;
+	vector<POINT> &points = ctx.points;
+	vector<int> &polyPointCounts = ctx.polyPointCounts;
+	points.clear();
+	polyPointCounts.clear();
 
-	// The DC is already initialized with a transformation matrix, so here we need to use the identity matrix
-	MAT2 mat = {{0,1},{0,0},{0,0},{0,1}};
-
-	vector<POINT> points;
-	vector<int> polyPointCounts;
-
-	// The code for converting true type outlines to polygons is described in the following article
-	// ref: http://support.microsoft.com/kb/87115
-
-	DWORD memSize;
-	if( gen->IsUsingUnicode() )
-		memSize = GetGlyphOutlineW(dc,idx,GGO_GLYPH_INDEX|GGO_NATIVE|(gen->GetUseHinting()?0:GGO_UNHINTED), &gm, 0, 0, &mat);
-	else
-		memSize = GetGlyphOutlineA(dc,idx,GGO_NATIVE|(gen->GetUseHinting()?0:GGO_UNHINTED), &gm, 0, 0, &mat);
-	if( memSize == GDI_ERROR )
-		return -1;
-
-	m_advance = gm.gmCellIncX;
-
-	BYTE *buf = new (std::nothrow) BYTE[memSize];
-	if( buf == 0 )
-	{
-		// Oops, I'm out of memory
-		return -2;
-	}
+	SGlyphOutline &outline = ctx.outline;
+	int r = ctx.backend->GetGlyphOutline(ch, outline);
+	if( r < 0 )
+		return r;
 
-	DWORD d;
-	if( gen->IsUsingUnicode() )
-		d = GetGlyphOutlineW(dc, idx, GGO_GLYPH_INDEX|GGO_NATIVE|(gen->GetUseHinting()?0:GGO_UNHINTED), &gm, memSize, buf, &mat);
-	else 
-		d = GetGlyphOutlineA(dc, idx, GGO_NATIVE|(gen->GetUseHinting()?0:GGO_UNHINTED), &gm, memSize, buf, &mat);
-	if( d == GDI_ERROR )
-	{
-		delete[] buf;	
-		return -1;
-	}
+	m_advance = outline.advance;
 
-	// Always render at 8 times the size then downscale. With this we avoid thin 
-	// lines disappearing for small characters, even when we do not use antialiasing
-	int scale = 65536 / 8;
+	// The multi-channel distance field is generated from the 
+	// curves themselves rather than from the rasterized polygons
+	if( gen->GetDistanceField() == e_distanceFieldMSDF )
+		m_shape = new CGlyphShape();
 
 	// Determine mininum rectangle
 	int minX = 10000<<16;
 	int maxX = -10000<<16;
 	int minY = 10000<<16;
 	int maxY = -10000<<16;
-	for( DWORD off = 0; off < memSize; )
+	int x = 0, y = 0;
+	int startX = 0, startY = 0;
+	int polyPointCount = 0;
+	UINT idx = 0;
+	for( UINT c = 0; c <= outline.commands.size(); c++ )
 	{
-		TTPOLYGONHEADER *head = (TTPOLYGONHEADER*)(buf + off);
-		head->cb;       // Number of bytes that describe the polygon
-		head->pfxStart; // Starting point for the polygon
-
-		int x = (*(int*)&head->pfxStart.x);
-		int y = (*(int*)&head->pfxStart.y);
-
-		int polyPointCount = 1;
-		POINT pt = {x,y};
-		points.push_back(pt);
-			
-		if( x < minX ) minX = x;
-		if( x > maxX ) maxX = x;
-		if( y < minY ) minY = y;
-		if( y > maxY ) maxY = y;
-
-		// The header is followed by N polygon curves (edges)
-		DWORD off2 = sizeof(TTPOLYGONHEADER);
-		while( off2 < head->cb )
+		// Close the previous polygon when a new one starts or the outline ends
+		if( c == outline.commands.size() || outline.commands[c] == e_moveTo )
 		{
-			TTPOLYCURVE *curve = (TTPOLYCURVE*)(buf + off + off2);
-			curve->wType; // TT_PRIM_LINE, TT_PRIM_QSPLINE, TT_PRIM_CSPLINE
-			curve->cpfx; // number of POINTFX 
-			
-			if( curve->wType != TT_PRIM_QSPLINE )
+			if( polyPointCount )
 			{
-				// True type doesn't use cubic bsplines, only quadratic bsplines
-				assert( curve->wType == TT_PRIM_LINE );
+				polyPointCounts.push_back(polyPointCount);
 
-				for( DWORD n = 0; n < curve->cpfx; n++ )
-				{
-					x = (*(int*)&curve->apfx[n].x);
-					y = (*(int*)&curve->apfx[n].y);
-
-					polyPointCount++;
-					POINT pt = {x,y};
-					points.push_back(pt);
-
-					if( x < minX ) minX = x;
-					if( x > maxX ) maxX = x;
-					if( y < minY ) minY = y;
-					if( y > maxY ) maxY = y;
-				}
+				// The polygons are implicitly closed
+				if( m_shape )
+					m_shape->LineTo(startX/65536.0, startY/65536.0);
 			}
-			else
-			{
-				for( int n = 0; n < curve->cpfx - 1; n++ )
-				{
-					int xA = x;
-					int yA = y;
+			if( c == outline.commands.size() )
+				break;
 
-					int xB = (*(int*)&curve->apfx[n].x);
-					int yB = (*(int*)&curve->apfx[n].y);
+			x = startX = outline.points[idx].x;
+			y = startY = outline.points[idx].y;
+			idx++;
 
-					int xC = (*(int*)&curve->apfx[n+1].x);
-					int yC = (*(int*)&curve->apfx[n+1].y);
+			polyPointCount = 1;
+			POINT pt = {x,y};
+			points.push_back(pt);
 
-					if( n < curve->cpfx - 2 )
-					{
-						xC = (xB + xC)/2;
-						yC = (yB + yC)/2;
-					}
+			if( m_shape )
+				m_shape->BeginContour(x/65536.0, y/65536.0);
+		}
+		else if( outline.commands[c] == e_lineTo )
+		{
+			x = outline.points[idx].x;
+			y = outline.points[idx].y;
+			idx++;
 
-					// Step through the quadratic bspline
-					for( DWORD ti = 1; ti <= 100; ti++ )
-					{
-						int t = ti*65536/100;
-						int t2 = t/256*t/256;
-						x = (xA-2*xB+xC)/256*t2/256 + (2*xB-2*xA)/256*t/256 + xA;
-						y = (yA-2*yB+yC)/256*t2/256 + (2*yB-2*yA)/256*t/256 + yA;
-
-						polyPointCount++;
-						POINT pt = {x,y};
-						points.push_back(pt);
-
-						if( x < minX ) minX = x;
-						if( x > maxX ) maxX = x;
-						if( y < minY ) minY = y;
-						if( y > maxY ) maxY = y;
-					}
+			polyPointCount++;
+			POINT pt = {x,y};
+			points.push_back(pt);
 
-					// Update current pos
-					x = xC;
-					y = yC;
-				}
+			if( m_shape )
+				m_shape->LineTo(x/65536.0, y/65536.0);
+		}
+		else
+		{
+			int xA = x;
+			int yA = y;
+			int xB = outline.points[idx].x;
+			int yB = outline.points[idx].y;
+			int xC = outline.points[idx+1].x;
+			int yC = outline.points[idx+1].y;
+			idx += 2;
+
+			if( m_shape )
+				m_shape->QuadTo(xB/65536.0, yB/65536.0, xC/65536.0, yC/65536.0);
+
+			// Step through the quadratic bspline. The error of each line 
+			// is at most |A-2B+C|/(4*steps^2), so the number of steps is 
+			// chosen to keep it within the tolerance
+			double ddx = (xA-2*xB+xC)/65536.0;
+			double ddy = (yA-2*yB+yC)/65536.0;
+			int steps = int(ceil(sqrt(sqrt(ddx*ddx + ddy*ddy)/(4*flatness))));
+			if( steps < 1 ) steps = 1;
+			if( steps > 1000 ) steps = 1000;
+			for( int ti = 1; ti <= steps; ti++ )
+			{
+				double t = double(ti)/steps;
+				double u = 1 - t;
+				x = int(floor(u*u*xA + 2*u*t*xB + t*t*xC + 0.5));
+				y = int(floor(u*u*yA + 2*u*t*yB + t*t*yC + 0.5));
+
+				polyPointCount++;
+				POINT pt = {x,y};
+				points.push_back(pt);
 			}
 
-			// Move to next polygon curve
-			off2 += sizeof(TTPOLYCURVE) + sizeof(POINTFX)*(curve->cpfx-1);
+			// Update current pos
+			x = xC;
+			y = yC;
 		}
+	}
 
-		polyPointCounts.push_back(polyPointCount);
-
-		// Move to next polygon
-		off += off2;
+	for( UINT n = 0; n < points.size(); n++ )
+	{
+		if( points[n].x < minX ) minX = points[n].x;
+		if( points[n].x > maxX ) maxX = points[n].x;
+		if( points[n].y < minY ) minY = points[n].y;
+		if( points[n].y > maxY ) maxY = points[n].y;
 	}
-	
-	delete[] buf;
 
 	if( points.size() == 0 )
 	{
@@ -298,405 +375,96 @@ int CFontChar::DrawGlyphFromOutline(HDC dc, int ch, int fontHeight, int fontAsce
 		m_xoffset = 0;
 		m_yoffset = 0;
 
-		m_charImg = new cImage(m_width, m_height);
-		m_charImg->isTopDown = true;
-		m_charImg->Clear(0);
+		m_charImg = new CGlyphImage(m_width, m_height, e_glyph8);
+		m_charImg->Clear();
 
 		return 0;
 	}
 
-	// Round boundaries to even pixels
-	minX -= scale/2;
-	minY -= scale/2;
-	maxX += scale/2;
-	maxY += scale/2;
+	// Round boundaries to even pixels, leaving a small margin 
+	// so that the edges are never on the border of the image
+	minX -= 65536/16;
+	minY -= 65536/16;
+	maxX += 65536/16;
+	maxY += 65536/16;
 	minX &= 0xFFFF0000;
 	minY &= 0xFFFF0000;
 	if( maxX & 0xFFFF ) maxX += 0x10000 - (maxX & 0xFFFF);
 	if( maxY & 0xFFFF ) maxY += 0x10000 - (maxY & 0xFFFF);
 
-	m_width  = maxX/scale - minX/scale;
-	m_height = maxY/scale - minY/scale;
+	m_width   = (maxX - minX)/65536;
+	m_height  = (maxY - minY)/65536;
+	m_xoffset = minX/65536;
+	m_yoffset = fontAscent - maxY/65536;
+
+	// Move the shape to the coordinates of the final image, with y pointing down
+	if( m_shape )
+		m_shape->Transform(1, -minX/65536.0, -1, maxY/65536.0);
 
 	// Create the image that will receive the pixels
-	m_charImg = new cImage(m_width, m_height);
-	if( m_charImg == 0 || m_charImg->pixels == 0 )
+	m_charImg = new CGlyphImage(m_width, m_height, e_glyph8);
+	if( m_charImg == 0 || m_charImg->pixels8 == 0 )
 	{
 		// Oops, I'm out of memory
 		return -2;
 	}
 
-	m_charImg->isTopDown = true;
-	m_charImg->Clear(0);
-
-	// Draw the character
-	DWORD *pixels;
-	BITMAPINFO bmi;
-	ZeroMemory(&bmi, sizeof(BITMAPINFO));
-	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-	bmi.bmiHeader.biWidth = m_charImg->width;
-	bmi.bmiHeader.biHeight = m_charImg->height;
-	bmi.bmiHeader.biPlanes = 1;
-	bmi.bmiHeader.biBitCount = 32;         
-	bmi.bmiHeader.biCompression = BI_RGB;
-	bmi.bmiHeader.biSizeImage = m_charImg->width * m_charImg->height * 4;
-
-	HBITMAP bm = CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, (void**)&pixels, 0, 0);
-	if( bm == 0 )
+	// Draw the character with the polygons in the 
+	// same coordinates as the image, with y pointing down
+	CGlyphRasterizer rasterizer;
+	rasterizer.Reset(m_width, m_height);
+	int start = 0;
+	for( UINT p = 0; p < polyPointCounts.size(); p++ )
 	{
-		// Oops, I'm out of memory
-		return -2;
-	}
-
-	HBITMAP oldBM = (HBITMAP)SelectObject(dc, bm);
-
-	HBRUSH white = (HBRUSH)GetStockObject(WHITE_BRUSH);
-	HBRUSH oldBrush = (HBRUSH)SelectObject(dc, white);
-	HPEN pen = CreatePen(PS_SOLID, 0, RGB(255,255,255));
-	HPEN oldPen = (HPEN)SelectObject(dc, pen);
-
-	memset(pixels, 0, bmi.bmiHeader.biSizeImage);
-
-	// Offset all points so we do not draw outside the box
-	m_xoffset = minX;
-	m_yoffset = minY;
-	m_xoffset /= scale;
-	m_yoffset /= scale;
-
-	for( UINT n = 0; n < points.size(); n++ )
-	{
-		points[n].x -= scale/2;
-		points[n].y -= scale/2;
-		points[n].x /= scale;
-		points[n].y /= scale;
-		points[n].x -= m_xoffset;
-		points[n].y -= m_yoffset;
+		int count = polyPointCounts[p];
+		for( int n = 0; n < count; n++ )
+		{
+			const POINT &a = points[start + n];
+			const POINT &b = points[start + (n + 1) % count];
+			rasterizer.AddLine((a.x - minX)/65536.0f, (maxY - a.y)/65536.0f, 
+			                   (b.x - minX)/65536.0f, (maxY - b.y)/65536.0f);
+		}
+		start += count;
 	}
+	rasterizer.GetCoverage(m_charImg->pixels8);
 
-	// Clear the transform before rendering the polygons as 
-	// they have already been created with the transform
-	if( SetGraphicsMode(dc, GM_ADVANCED) )
+	if( !gen->IsUsingSmoothing() )
 	{
-		XFORM mtx;
-		mtx.eM11 = 1.0f;
-		mtx.eM12 = 0;
-		mtx.eM21 = 0;
-		mtx.eM22 = 1.0f;
-		mtx.eDx = 0;
-		mtx.eDy = 0;
-		SetWorldTransform(dc, &mtx);
+		for( int n = 0; n < m_width*m_height; n++ )
+			m_charImg->pixels8[n] = (m_charImg->pixels8[n] >= 150) ? 255 : 0;
 	}
 
-	PolyPolygon(dc, &points[0], &polyPointCounts[0], polyPointCounts.size());
-
-	GdiFlush();
-
-	// Retrieve the pixels to the image
-	memcpy(m_charImg->pixels, pixels, m_charImg->width*m_charImg->height*4);
-
-	SelectObject(dc, oldBrush);
-	SelectObject(dc, oldBM);
-	SelectObject(dc, oldPen);
-	DeleteObject(pen);
-	DeleteObject(bm);
-
-	DownscaleImage(gen->IsUsingSmoothing());
-	m_width   /= 8;
-	m_height  /= 8;
-	m_xoffset /= 8;
-	m_yoffset = fontAscent - maxY/65536;
-
 	return 0;
 }
 
-int CFontChar::DrawGlyphFromBitmap(HDC dc, int ch, int fontHeight, int fontAscent, const CFontGen *gen)
+int CFontChar::DrawGlyphFromBitmap(SRasterContext &ctx, int ch)
 {
-	// Get the glyph info
-	int idx;
-	if( gen->IsUsingUnicode() )
-	{
-		idx = GetUnicodeGlyphIndex(dc, 0, ch);
-		if( idx < 0 )
-		{
-			// Get the default character instead
-			TEXTMETRICW tm;
-			GetTextMetricsW(dc, &tm);
-			WORD glyph;
-			fGetGlyphIndicesW(dc, &tm.tmDefaultChar, 1, &glyph, 0);
-			idx = glyph;
-		}
-	}
-	else
-	{
-		idx = ch;
-	}
-
-/*
-	Do not use GetGlyphOutline to retrieve the glyph bitmap. 
-	- It doesn't prevent clipping of glyphs that go above or below cell height
-	- When glyph go outside the cell height the black box doesn't reflect the true size
-	- It has less grayscale levels for antialiasing than the TextOut function has
-	- ClearType isn't available
-
-	I'm leaving the code here in case I ever want to use it again
-
-
-	MAT2 mat = {{0,1},{0,0},{0,0},{0,1}};
-	GLYPHMETRICS gm;
-	DWORD d;
-	if( useUnicode )
-	{
-		d = GetGlyphOutlineW(dc,idx,GGO_GLYPH_INDEX|(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,0,0,&mat);
-	}
-	else
-	{
-		d = GetGlyphOutlineA(dc,idx,(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,0,0,&mat);
-	}
-	if( d != GDI_ERROR )
-	{
-		// Create the image that will receive the pixels
-		m_width = gm.gmBlackBoxX;
-		m_height = gm.gmBlackBoxY;
-		m_xoffset = gm.gmptGlyphOrigin.x;
-		m_advance = gm.gmCellIncX;
-		m_yoffset = fontAscent - gm.gmptGlyphOrigin.y;
-
-		// GetGlyphOutline sometimes returns the incorrect height, usually when the
-		// glyph have accentual marks very high up. We can calculate the true height 
-		// from the buffer size. 
-
-		// Actually, it is not possible to calculate the true height. If the glyph is too far
-		// outside the cell height, then the blackbox may not reflect the true width or height
-		// thus we do not have anything that can be trusted for recalculating the height. This
-		// is why I decided to abandon this way of rendering.
-
-		UINT pitch = m_width;
-		if( pitch & 0x3 ) pitch += 4 - (pitch & 0x3);
-		if( d / pitch > (unsigned)m_height ) 
-		{
-			m_yoffset -= d / pitch - m_height;
-			m_height = d / pitch;
-		}
-
-        // Create the image
-		m_charImg = new cImage(m_width, m_height);
-		m_charImg->isTopDown = true;
-		m_charImg->Clear(0);
-
-		// Get the actual bitmap
-		if( d > 0 )
-		{
-			BYTE *tmpPixels = new BYTE[d];
-			if( useUnicode )
-				d = GetGlyphOutlineW(dc,idx,GGO_GLYPH_INDEX|(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,d,tmpPixels,&mat);
-			else
-				d = GetGlyphOutlineA(dc,idx,(useSmoothing ? GGO_GRAY8_BITMAP : GGO_BITMAP),&gm,d,tmpPixels,&mat);
-
-			if( useSmoothing )
-			{
-				// The above outputs the glyph with 65 levels of gray, so we need to convert this to 256 levels of gray
-				for( int y = 0; y < m_charImg->height; y++ )
-				{
-					for( int x = 0; x < m_charImg->width; x++ )
-					{
-						BYTE v = 255 * tmpPixels[x+y*pitch] / 64;
-						m_charImg->pixels[x+y*m_charImg->width] = (v << 24) | (v << 16) | (v << 8) | v;
-					}
-				}
-			}
-			else
-			{
-				UINT pitch = m_charImg->width / 8 + ((m_charImg->width & 0x7) ? 1 : 0);
-				if( pitch & 0x3 ) pitch += 4 - (pitch & 0x3);
+	SGlyphBitmap bitmap;
+	int r = ctx.backend->DrawGlyph(ch, bitmap);
+	if( r < 0 )
+		return r;
 
-				// The above outputs a glyph in a monochrome bitmap
-				for( int y = 0; y < m_charImg->height; y++ )
-				{
-					for( int x = 0; x < m_charImg->width; )
-					{
-						// Transform each byte into 8 pixels
-						for( int bit = 7; bit >= 0 && x < m_charImg->width; bit--, x++ )
-						{
-							m_charImg->pixels[x+y*m_charImg->width] = ((tmpPixels[x/8+y*pitch] >> bit) & 1) ? 0xFFFFFFFF : 0; 
-						}
-					}
-				}
-			}
+	m_advance = bitmap.advance;
 
-			delete[] tmpPixels;
-		}
-	}
-	else
-*/
+	if( bitmap.image == 0 )
 	{
-		// GetGlyphOutline only works for true type fonts, so we need a fallback for other fonts
-
-		// Determine the size needed for the char
-		ABC abc;
-		if( gen->IsUsingUnicode() )
-		{
-			if( GetUnicodeCharABCWidths(dc, 0, ch, &abc) < 0 )
-				memset(&abc, 0, sizeof(abc));
-
-			m_width = int(abc.abcB);
-		}
-		else
-		{
-			if( GetCharABCWidths(dc, ch, ch, &abc) )
-			{
-				m_width = int(abc.abcB);
-			}
-			else
-			{
-				// Use GetCharWidth32() instead
-				GetCharWidth32(dc, ch, ch, &m_width);
-
-				abc.abcA = abc.abcC = 0;
-				abc.abcB = (unsigned)m_width;
-			}
-		}
-
-		// If the requested font size is too large, the Windows API has a  
-		// bug that causes negative width to be returned in some cases
-		if( m_width < 0 )
-			m_width = 0;
-
-		m_height = fontHeight;
-		m_xoffset = abc.abcA;
-		m_advance = (abc.abcA + m_width + abc.abcC);
+		m_width   = 1;
+		m_height  = 1;
+		m_xoffset = 0;
 		m_yoffset = 0;
 
-		if( m_width == 0 )
-		{
-			m_width   = 1;
-			m_height  = 1;
-			m_xoffset = 0;
-			m_yoffset = 0;
-
-			m_charImg = new cImage(m_width, m_height);
-			m_charImg->isTopDown = true;
-			m_charImg->Clear(0);
-
-			return 0;
-		}
-
-		// We need to add extra width, because width received from GDI 
-		// doesn't always account for overhang, e.g. due to italic style
-		UINT extraWidth = m_width;
-		m_width += extraWidth*2;
-		m_xoffset -= extraWidth;
+		m_charImg = new CGlyphImage(m_width, m_height, e_glyph8);
+		m_charImg->Clear();
 
-		// Create the image that will receive the pixels
-		m_charImg = new cImage(m_width, m_height);
-		if( m_charImg == 0 || m_charImg->pixels == 0 )
-		{
-			// Oops, I'm out of memory
-			return -2;
-		}
-		m_charImg->isTopDown = true;
-		m_charImg->Clear(0);
-
-		// Draw the character
-		DWORD *pixels;
-		BITMAPINFO bmi;
-		ZeroMemory(&bmi, sizeof(BITMAPINFO));
-		bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-		bmi.bmiHeader.biWidth = m_charImg->width;
-		bmi.bmiHeader.biHeight = -m_charImg->height;
-		bmi.bmiHeader.biPlanes = 1;
-		bmi.bmiHeader.biBitCount = 32;         
-		bmi.bmiHeader.biCompression = BI_RGB;
-		bmi.bmiHeader.biSizeImage = m_charImg->width * m_charImg->height * 4;
-
-		HBITMAP bm = CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, (void**)&pixels, 0, 0);
-		if( bm == 0 )
-		{
-			// Oops, I'm out of memory
-			return -2;
-		}
-
-		HBITMAP oldBM = (HBITMAP)SelectObject(dc, bm);
-
-		memset(pixels, 0, bmi.bmiHeader.biSizeImage);
-
-		SetTextColor(dc, RGB(255,255,255));
-		SetBkColor(dc, RGB(0,0,0));
-		SetBkMode(dc, TRANSPARENT);
-
-		if( gen->IsUsingUnicode() )
-		{
-			WCHAR buf[2];
-			int length = acUtility::EncodeUTF16(ch, (unsigned char*)buf, 0);
-
-			TextOutW(dc, extraWidth-abc.abcA, 0, buf, length/2);
-/*
-			// Testing different ways of rendering
-			// All of them have the same problem of clipping glyphs that go above or below the cell
-
-			// I'm leaving the code here for reference, if anyone wants to know how to draw text with these other functions
-
-			// Ordinary GDI calls
-			RECT rc;
-			rc.left = 0;
-			rc.top = 0;
-			rc.right = fontHeight*5;
-			rc.bottom = fontHeight*5;
-			//ExtTextOutW(dc, -abc.abcA+fontHeight*2, +fontHeight*2, ETO_CLIPPED|ETO_GLYPH_INDEX, &rc, buf, length/2, 0);
-			//DrawTextExW(dc, buf, length/2, &rc, DT_CENTER|DT_NOCLIP|DT_SINGLELINE|DT_VCENTER, 0); 
-
-			// Uniscribe call, complex
-			SCRIPT_ITEM si[21];
-			int csi;
-			SCRIPT_CACHE sc = 0;
-			WORD glyphs[20];
-			WORD clusters[2];
-			SCRIPT_VISATTR va[20];
-			int cGlyphs;
-			int advance[20];
-			GOFFSET offsets[20];
-			ABC abc;
-			ScriptItemize(buf, length/2, 20, 0, 0, si, &csi);
-			ScriptShape(dc, &sc, buf, length/2, 20, &si[0].a, glyphs, clusters, va, &cGlyphs);
-			ScriptPlace(dc, &sc, glyphs, cGlyphs, va, &si[0].a, advance, offsets, &abc);
-			ScriptTextOut(dc, &sc, fontHeight*2, fontHeight*2, 0, 0, &si[0].a, 0, 0, glyphs, cGlyphs, advance, 0, offsets);
-			ScriptFreeCache(&sc);
-
-			// Uniscribe call, simpler
-			SCRIPT_STRING_ANALYSIS ssa;
-			ScriptStringAnalyse(dc, buf, length/2, 20, -1, SSA_GLYPHS, 0, 0, 0, 0, 0, 0, &ssa);
-			ScriptStringOut(ssa, fontHeight*2, fontHeight*2, 0, 0, 0, 0, 0);
-			ScriptStringFree(&ssa);
-*/
-		}
-		else
-			TextOutA(dc, extraWidth-abc.abcA, 0, (char*)&ch, 1);
-
-		GdiFlush();
-
-		// Retrieve the pixels to the image
-		memcpy(m_charImg->pixels, pixels, m_charImg->width*m_charImg->height*4);
-
-		// Clean up
-		SelectObject(dc, oldBM);
-		DeleteObject(bm);
-
-		if( gen->GetUseClearType() )
-		{
-			// Need to convert the red and blue levels to grayscale
-			for( int y = 0; y < m_charImg->height; y++ )
-			{
-				for( int x = 0; x < m_charImg->width; x++ )
-				{
-					UINT c = m_charImg->pixels[y*m_charImg->width + x];
-					c = (c&0xFF) + ((c>>8)&0xFF) + ((c>>16)&0xFF);
-					c /= 3;
-					c = c + (c<<8) + (c<<16);
-					m_charImg->pixels[y*m_charImg->width + x] = c;
-				}
-			}
-		}
+		return 0;
 	}
 
+	m_charImg = bitmap.image;
+	m_width   = m_charImg->width;
+	m_height  = m_charImg->height;
+	m_xoffset = bitmap.xoffset;
+	m_yoffset = bitmap.yoffset;
+
 	return 0;
 }
 
@@ -708,8 +476,7 @@ void CFontChar::TrimLeftAndRight()
 	{
 		for( int y = 0; y < m_charImg->height; y++ )
 		{
-			UINT c = m_charImg->pixels[y*m_charImg->width + x];
-			if( c )
+			if( m_charImg->pixels8[y*m_charImg->width + x] )
 			{
 				left = x;
 				break;
@@ -724,8 +491,7 @@ void CFontChar::TrimLeftAndRight()
 	{
 		for( int y = 0; y < m_charImg->height; y++ )
 		{
-			UINT c = m_charImg->pixels[y*m_charImg->width + x];
-			if( c )
+			if( m_charImg->pixels8[y*m_charImg->width + x] )
 			{
 				right = x;
 				break;
@@ -738,215 +504,142 @@ void CFontChar::TrimLeftAndRight()
 	// Copy the smaller image
 	if( left >= 0 )
 	{
-		cImage *img = new cImage(right-left+1, m_height);
+		CGlyphImage *img = new CGlyphImage(right-left+1, m_height, e_glyph8);
 		for( int y = 0; y < m_charImg->height; y++ )
 			for( int x = 0; x < img->width; x++ )
-				img->pixels[y*img->width + x] = m_charImg->pixels[y*m_charImg->width + x + left];
+				img->pixels8[y*img->width + x] = m_charImg->pixels8[y*m_charImg->width + x + left];
 
 		delete m_charImg;
 		m_charImg = img;
 
 		m_width = img->width;
 		m_xoffset += left;
+
+		if( m_shape )
+			m_shape->Transform(1, -left, 1, 0);
 	}
 }
 
-int CFontChar::DrawGlyph(HFONT font, int ch, const CFontGen *gen)
+int CFontChar::DrawGlyph(SRasterContext &ctx, int ch, const CFontGen *gen)
 {
 	m_colored = false;
 	m_isChar  = true;
 
-	// Create a memory dc
-	HDC dc = CreateCompatibleDC(0);
-
-	// Set the font
-	HFONT oldFont = (HFONT)SelectObject(dc, font);
-
-	// We need to determine text metrics before applying the world transform, because 
-	// the returned text metrics with transform is not consistent. The tmHeight for example
-	// is always the same, independently of the scale, but the tmAscent varies slightly,
-	// though not proportionally with the scale.
-	TEXTMETRIC tm;
-	GetTextMetrics(dc, &tm);
-
-	// Compute the height and ascent with scale
-	int fontHeight = int(ceilf(tm.tmHeight*float(gen->GetScaleHeight())/100.0f));
-	int fontAscent = int(ceilf(tm.tmAscent*float(gen->GetScaleHeight())/100.0f));
-
-	// Scale the coordinate system so that the font is stretched
-	if( SetGraphicsMode(dc, GM_ADVANCED) )
-	{
-		XFORM mtx;
-		mtx.eM11 = 1.0f;
-		mtx.eM12 = 0;
-		mtx.eM21 = 0;
-		mtx.eM22 = float(gen->GetScaleHeight())/100.0f;
-		mtx.eDx = 0;
-		mtx.eDy = 0;
-		SetWorldTransform(dc, &mtx);
-	}
-
+	// The text metrics were determined when the context was created
 	int r = -1;
-	if( gen->GetRenderFromOutline() )
-		r = DrawGlyphFromOutline(dc, ch, fontHeight, fontAscent, gen);
+	if( gen->GetRenderFromOutline() || gen->GetDistanceField() == e_distanceFieldMSDF )
+		r = DrawGlyphFromOutline(ctx, ch, ctx.fontAscent, gen);
 	
 	// In case of error fall back to drawing from bitmap
 	// Don't fall back in case of out of memory
 	if( r < 0 && r != -2 )
-		r = DrawGlyphFromBitmap(dc, ch, fontHeight, fontAscent, gen);
+		r = DrawGlyphFromBitmap(ctx, ch);
 
 	if( r < 0 )
 	{
 		// Failed to draw the image (probably out of memory)
-		SelectObject(dc, oldFont);
-		DeleteDC(dc);
 		return r;
 	}
 
 	// Remove excessive width
 	TrimLeftAndRight();
 
+	return 0;
+}
+
+void CFontChar::FinishGlyph(int fontHeight, const CFontGen *gen)
+{
 	// Downscale in case of supersampling
 	// Must downscale before removing empty lines
 	int aa = gen->GetAntiAliasingLevel();
-	if( aa > 1 )
+
+	// Characters without any pixels, e.g. space, don't get a distance field
+	bool hasPixels = false;
+	for( int n = 0; n < m_charImg->width*m_charImg->height && !hasPixels; n++ )
+		hasPixels = m_charImg->pixels8[n] != 0;
+
+	if( gen->GetDistanceField() != e_distanceFieldNone && hasPixels )
 	{
-		m_width = int(ceilf(float(m_width)/aa));
-		m_height = int(ceilf(float(m_height)/aa));
-		m_xoffset /= aa;
-		m_yoffset /= aa;
+		// The distance field is computed from the supersampled image and 
+		// extends spread pixels outside the glyph. The pixels that are 
+		// further away are 0, so the empty lines are still removed below
+		int spread = gen->GetDistanceFieldSpread();
+		m_width = int(ceilf(float(m_width)/aa)) + 2*spread;
+		m_height = int(ceilf(float(m_height)/aa)) + 2*spread;
+		m_xoffset = m_xoffset/aa - spread;
+		m_yoffset = m_yoffset/aa - spread;
 		m_advance /= aa;
 
-		cImage img;
-		img.Create(m_width, m_height);
-
-		if( aa == 2 )
+		CGlyphImage *img;
+		if( gen->GetDistanceField() == e_distanceFieldMSDF )
 		{
-			for( int y = 0; y < img.height; y++ )
+			img = new CGlyphImage(m_width, m_height, e_color32);
+			if( m_shape && !m_shape->IsEmpty() )
 			{
-				for( int x = 0; x < img.width; x++ )
-				{
-					int sy = y*2;
-					int c = 0;
-
-					c += m_charImg->pixels[x*2 + sy*m_charImg->width] & 0xFF;
-					if( x*2+1 < m_charImg->width ) c += m_charImg->pixels[x*2+1 + sy*m_charImg->width] & 0xFF;
-
-					if( sy+1 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*2 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*2+1 < m_charImg->width ) c += m_charImg->pixels[x*2+1 + (sy+1)*m_charImg->width] & 0xFF;
-					}
-
-					c /= 4;
-
-					img.pixels[y*img.width + x] = c | (c<<8) | (c<<16) | (c<<24);
-				}
+				// The shape is in the supersampled pixels
+				m_shape->ColorEdges();
+				m_shape->GenerateMSDF(img->pixels32, m_width, m_height, -spread*aa, -spread*aa, aa, spread);
 			}
-		}
-		else if( aa == 3 )
-		{
-			for( int y = 0; y < img.height; y++ )
+			else
 			{
-				for( int x = 0; x < img.width; x++ )
-				{
-					int sy = y*3;
-					int c = 0;
-
-					c += m_charImg->pixels[x*3 + sy*m_charImg->width] & 0xFF;
-					if( x*3+1 < m_charImg->width ) c += m_charImg->pixels[x*3+1 + sy*m_charImg->width] & 0xFF;
-					if( x*3+2 < m_charImg->width ) c += m_charImg->pixels[x*3+2 + sy*m_charImg->width] & 0xFF;
-
-					if( sy+1 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*3+0 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*3+1 < m_charImg->width ) c += m_charImg->pixels[x*3+1 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*3+2 < m_charImg->width ) c += m_charImg->pixels[x*3+2 + (sy+1)*m_charImg->width] & 0xFF;
-					}
-
-					if( sy+2 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*3+0 + (sy+2)*m_charImg->width] & 0xFF;
-						if( x*3+1 < m_charImg->width ) c += m_charImg->pixels[x*3+1 + (sy+2)*m_charImg->width] & 0xFF;
-						if( x*3+2 < m_charImg->width ) c += m_charImg->pixels[x*3+2 + (sy+2)*m_charImg->width] & 0xFF;
-					}
-
-					c /= 9;
-
-					img.pixels[y*img.width + x] = c | (c<<8) | (c<<16) | (c<<24);
-				}
+				// Glyphs drawn from bitmaps have no curves, so 
+				// the normal distance field is used in all channels
+				CGlyphImage sdf(m_width, m_height, e_glyph8);
+				CreateSignedDistanceField(m_charImg->pixels8, m_charImg->width, m_charImg->height, aa, spread, sdf.pixels8);
+				for( int n = 0; n < m_width*m_height; n++ )
+					img->pixels32[n] = DWORD(sdf.pixels8[n])*0x01010101;
 			}
 		}
-		else if( aa == 4 )
+		else
 		{
-			for( int y = 0; y < img.height; y++ )
-			{
-				for( int x = 0; x < img.width; x++ )
-				{
-					int sy = y*4;
-					int c = 0;
-
-					c += m_charImg->pixels[x*4 + sy*m_charImg->width] & 0xFF;
-					if( x*4+1 < m_charImg->width ) c += m_charImg->pixels[x*4+1 + sy*m_charImg->width] & 0xFF;
-					if( x*4+2 < m_charImg->width ) c += m_charImg->pixels[x*4+2 + sy*m_charImg->width] & 0xFF;
-					if( x*4+3 < m_charImg->width ) c += m_charImg->pixels[x*4+3 + sy*m_charImg->width] & 0xFF;
-
-					if( sy+1 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*4+0 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*4+1 < m_charImg->width ) c += m_charImg->pixels[x*4+1 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*4+2 < m_charImg->width ) c += m_charImg->pixels[x*4+2 + (sy+1)*m_charImg->width] & 0xFF;
-						if( x*4+3 < m_charImg->width ) c += m_charImg->pixels[x*4+3 + (sy+1)*m_charImg->width] & 0xFF;
-					}
-
-					if( sy+2 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*4+0 + (sy+2)*m_charImg->width] & 0xFF;
-						if( x*4+1 < m_charImg->width ) c += m_charImg->pixels[x*4+1 + (sy+2)*m_charImg->width] & 0xFF;
-						if( x*4+2 < m_charImg->width ) c += m_charImg->pixels[x*4+2 + (sy+2)*m_charImg->width] & 0xFF;
-						if( x*4+3 < m_charImg->width ) c += m_charImg->pixels[x*4+3 + (sy+2)*m_charImg->width] & 0xFF;
-					}
+			img = new CGlyphImage(m_width, m_height, e_glyph8);
+			CreateSignedDistanceField(m_charImg->pixels8, m_charImg->width, m_charImg->height, aa, spread, img->pixels8);
+		}
 
-					if( sy+3 < m_charImg->height )
-					{
-						c += m_charImg->pixels[x*4+0 + (sy+3)*m_charImg->width] & 0xFF;
-						if( x*4+1 < m_charImg->width ) c += m_charImg->pixels[x*4+1 + (sy+3)*m_charImg->width] & 0xFF;
-						if( x*4+2 < m_charImg->width ) c += m_charImg->pixels[x*4+2 + (sy+3)*m_charImg->width] & 0xFF;
-						if( x*4+3 < m_charImg->width ) c += m_charImg->pixels[x*4+3 + (sy+3)*m_charImg->width] & 0xFF;
-					}
+		delete m_charImg;
+		m_charImg = img;
+	}
+	else if( aa > 1 )
+	{
+		m_width = int(ceilf(float(m_width)/aa));
+		m_height = int(ceilf(float(m_height)/aa));
+		m_xoffset /= aa;
+		m_yoffset /= aa;
+		m_advance /= aa;
 
-					c /= 16;
+		CGlyphImage *img = new CGlyphImage(m_width, m_height, e_glyph8);
+		DownscaleCoverage(m_charImg->pixels8, m_charImg->width, m_charImg->height, aa, img->pixels8);
 
-					img.pixels[y*img.width + x] = c | (c<<8) | (c<<16) | (c<<24);
-				}
-			}
-		}
+		// Replace the charImg member with the downscaled image
+		delete m_charImg;
+		m_charImg = img;
+	}
 
-		// Move the pixels to the charImg member
-		m_charImg->width = img.width;
-		m_charImg->height = img.height;
-		delete[] m_charImg->pixels;
-		m_charImg->pixels = img.pixels;
-		img.pixels = 0;
+	if( m_shape )
+	{
+		delete m_shape;
+		m_shape = 0;
 	}
 
+	// The multi-channel distance field has 4 bytes per pixel
+	int bpp = m_charImg->GetBytesPerPixel();
+
 	// Adjust the cell height
 	if( gen->GetFixedHeight() || gen->GetForceZero() )
 	{
 		fontHeight = int(ceilf(float(fontHeight)/aa));
 
 		// Expand the image to the full cellheight with empty lines to 
-		cImage *tmp = m_charImg;
-		m_charImg = new cImage(tmp->width, fontHeight);
-		m_charImg->Clear(0);
+		CGlyphImage *tmp = m_charImg;
+		m_charImg = new CGlyphImage(tmp->width, fontHeight, tmp->format);
+		m_charImg->Clear();
 
 		// Make sure we don't draw outside the final cell
 		if( tmp->height + m_yoffset > fontHeight )
 			tmp->height -= tmp->height + m_yoffset - fontHeight;
 
 		for( int y = m_yoffset < 0 ? -m_yoffset : 0; y < tmp->height; y++ )
-			for( int x = 0; x < tmp->width; x++ )
-				m_charImg->pixels[x+(y+m_yoffset)*m_charImg->width] = tmp->pixels[x+y*tmp->width];
+			memcpy(m_charImg->pixels8 + (y+m_yoffset)*m_charImg->width*bpp, tmp->pixels8 + y*tmp->width*bpp, tmp->width*bpp);
 
 		delete tmp;
 
@@ -961,9 +654,9 @@ int CFontChar::DrawGlyph(HFONT font, int ch, const CFontGen *gen)
 		for( int y = 0; m_height > 1 && y < m_charImg->height; y++ )
 		{
 			bool empty = true;
-			for( int x = 0; x < m_charImg->width; x++ )
+			for( int x = 0; x < m_charImg->width*bpp; x++ )
 			{
-				if( m_charImg->pixels[y*m_charImg->width+x] != 0 )
+				if( m_charImg->pixels8[y*m_charImg->width*bpp+x] != 0 )
 				{
 					empty = false;
 					break;
@@ -984,9 +677,9 @@ int CFontChar::DrawGlyph(HFONT font, int ch, const CFontGen *gen)
 		for( int y = m_charImg->height-1; m_height > 1; y-- )
 		{
 			bool empty = true;
-			for( int x = 0; x < m_charImg->width; x++ )
+			for( int x = 0; x < m_charImg->width*bpp; x++ )
 			{
-				if( m_charImg->pixels[y*m_charImg->width+x] != 0 )
+				if( m_charImg->pixels8[y*m_charImg->width*bpp+x] != 0 )
 				{
 					empty = false;
 					break;
@@ -1005,8 +698,7 @@ int CFontChar::DrawGlyph(HFONT font, int ch, const CFontGen *gen)
 		if( removedLines )
 		{
 			for( int y = 0; y < m_height; y++ )
-				for( int x = 0; x < m_width; x++ )
-					m_charImg->pixels[y*m_charImg->width+x] = m_charImg->pixels[(y+removedLines)*m_charImg->width+x];			
+				memcpy(m_charImg->pixels8 + y*m_charImg->width*bpp, m_charImg->pixels8 + (y+removedLines)*m_charImg->width*bpp, m_width*bpp);
 		}
 
 		m_charImg->height = m_height;
@@ -1036,73 +728,17 @@ int CFontChar::DrawGlyph(HFONT font, int ch, const CFontGen *gen)
 
 		if( leftX || rightX )
 		{
-			cImage *cpy = new cImage(m_width, m_height);
-			cpy->Clear(0);
+			CGlyphImage *cpy = new CGlyphImage(m_width, m_height, m_charImg->format);
+			cpy->Clear();
 			for( int y = 0; y < m_charImg->height; y++ )
-			{
-				for( int x = 0; x < m_charImg->width; x++ )
-				{
-					cpy->pixels[leftX + x + y*cpy->width] = m_charImg->pixels[x + y*m_charImg->width];
-				}
-			}
+				memcpy(cpy->pixels8 + (leftX + y*cpy->width)*bpp, m_charImg->pixels8 + y*m_charImg->width*bpp, m_charImg->width*bpp);
 			delete m_charImg;
 			m_charImg = cpy;
 		}
 	}
-
-	// Clean up
-	SelectObject(dc, oldFont);
-	DeleteDC(dc);
-
-	return 0;
 }
 
-void CFontChar::DownscaleImage(bool useSmoothing)
-{
-	cImage img;
-	img.Create(m_charImg->width/8, m_charImg->height/8);
-
-	// The image will always composed of 8x8 blocks
-	assert( (m_charImg->width & 0x7) == 0 );
-	assert( (m_charImg->height & 0x7) == 0 );
-
-	for( int y = 0; y < img.height; y++ )
-	{
-		for( int x = 0; x < img.width; x++ )
-		{
-			int sy = y*8;
-			int c = 0;
-
-			for( int i = 0; i < 8; i++ )
-			{
-				c += m_charImg->pixels[x*8+0 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+1 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+2 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+3 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+4 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+5 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+6 + (sy+i)*m_charImg->width] & 0xFF;
-				c += m_charImg->pixels[x*8+7 + (sy+i)*m_charImg->width] & 0xFF;
-			}
-
-			c /= 64;
-
-			if( !useSmoothing )
-				c = (c >= 150) ? 255 : 0;
-
-			img.pixels[y*img.width + x] = c | (c<<8) | (c<<16) | (c<<24);
-		}
-	}
-
-	// Move the pixels to the charImg member
-	m_charImg->width = img.width;
-	m_charImg->height = img.height;
-	delete[] m_charImg->pixels;
-	m_charImg->pixels = img.pixels;
-	img.pixels = 0;
-}
-
-void CFontChar::AddOutline(int thickness)
+void CFontChar::AddOutline(int thickness, int method)
 {
 	if( !m_charImg->height || !m_charImg->width )
 		return;
@@ -1114,10 +750,25 @@ void CFontChar::AddOutline(int thickness)
 	m_xoffset -= thickness;
 	m_yoffset -= thickness;
 
-	cImage img;
-	img.Create(m_charImg->width+2*thickness, m_charImg->height+2*thickness);
-	img.Clear(0);
+	// The glyph is kept in the low byte and the outline in the high byte
+	CGlyphImage *img = new CGlyphImage(m_charImg->width+2*thickness, m_charImg->height+2*thickness, e_glyphOutline16);
+	img->Clear();
+
+	if( method == e_outlineDistance )
+		DrawOutlineWithDistance(img, thickness);
+	else
+		DrawOutlineWithKernel(img, thickness);
+
+	// Replace the charImg member with the outlined image
+	delete m_charImg;
+	m_charImg = img;
+}
 
+// The outline value of each pixel is the highest value of the kernel 
+// centered on the glyph pixels around it, scaled by their coverage. The 
+// cost grows with the square of the thickness.
+void CFontChar::DrawOutlineWithKernel(CGlyphImage *img, int thickness)
+{
 	// Create the kernel
 	int kernelWidth = thickness*2+1;
 	float *kernel = new float[kernelWidth*kernelWidth];
@@ -1145,7 +796,7 @@ void CFontChar::AddOutline(int thickness)
 	{
 		for( int x1 = 0; x1 < m_charImg->width; x1++ )
 		{
-			DWORD cs = m_charImg->pixels[y1*m_charImg->width+x1] & 0xFF;
+			WORD cs = m_charImg->pixels8[y1*m_charImg->width+x1];
 			for( int y2 = 0; y2 < kernelWidth; y2++ )
 			{
 				for( int x2 = 0; x2 < kernelWidth; x2++ )
@@ -1153,14 +804,14 @@ void CFontChar::AddOutline(int thickness)
 					if( x2 == thickness && y2 == thickness )
 					{
 						if( cs )
-							img.pixels[(y1+y2)*img.width+(x1+x2)] = 0xFF000000|(cs<<16)|(cs<<8)|cs;
+							img->pixels16[(y1+y2)*img->width+(x1+x2)] = 0xFF00|cs;
 					}
 					else
 					{
-						DWORD val = DWORD(cs*kernel[y2*kernelWidth+x2])<<24;
-						DWORD cd = img.pixels[(y1+y2)*img.width+(x1+x2)];
+						WORD val = WORD(WORD(cs*kernel[y2*kernelWidth+x2])<<8);
+						WORD cd = img->pixels16[(y1+y2)*img->width+(x1+x2)];
 						if( val > cd )
-							img.pixels[(y1+y2)*img.width+(x1+x2)] = val;
+							img->pixels16[(y1+y2)*img->width+(x1+x2)] = val;
 					}
 				}
 			}
@@ -1168,11 +819,105 @@ void CFontChar::AddOutline(int thickness)
 	}
 
 	delete[] kernel;
+}
+
+// The kernel value only depends on the squared distance between the pixels, 
+// so the outline of each pixel is the highest of L*kernel(D), where D is the 
+// squared distance to the nearest glyph pixel with a coverage of at least L. 
+// A distance transform is computed for each coverage level, so to bound the 
+// cost the partial coverage is grouped into consecutive values, each group 
+// represented by the lowest value in it, so that there are at most 16 levels. 
+// Full coverage is always kept as is. The result is the same as the kernel's 
+// when the glyph has at most 16 levels, e.g. when drawn without smoothing. 
+// Otherwise the outline around the partially covered pixels may be up to 16 
+// levels weaker, as the groups are then at most 17 values wide.
+void CFontChar::DrawOutlineWithDistance(CGlyphImage *img, int thickness)
+{
+	const unsigned int maxLevels = 16;
+
+	// Determine the coverage levels used by the glyph
+	bool used[256] = {false};
+	for( int n = 0; n < m_charImg->width*m_charImg->height; n++ )
+		used[m_charImg->pixels8[n]] = true;
+
+	// Find the narrowest groups that give at most maxLevels levels. Each group 
+	// starts at a used value and holds the values up to the next group
+	vector<int> levels;
+	for( int groupWidth = 1; ; groupWidth++ )
+	{
+		levels.clear();
+		for( int c = 1; c < 255; c++ )
+		{
+			if( used[c] )
+			{
+				levels.push_back(c);
+				c += groupWidth-1;
+			}
+		}
+		if( used[255] )
+			levels.push_back(255);
+
+		if( levels.size() <= maxLevels )
+			break;
+	}
+
+	// The kernel value for each squared distance. Beyond 
+	// thickness*(thickness+1) the kernel is always 0
+	int maxDist = thickness*(thickness+1);
+	vector<float> kernel(maxDist);
+	for( int d = 0; d < maxDist; d++ )
+	{
+		float val = thickness+1 - thickness*float(d)/(thickness*thickness);
+		if( val > 1 ) val = 1;
+		else if( val < 0 ) val = 0;
+		kernel[d] = val;
+	}
 
-	// Move the new image to charImg
-	m_charImg->width = img.width;
-	m_charImg->height = img.height;
-	delete[] m_charImg->pixels;
-	m_charImg->pixels = img.pixels;
-	img.pixels = 0;
+	vector<float> grid(img->width*img->height);
+	vector<WORD>  outline(img->width*img->height, 0);
+	for( unsigned int l = 0; l < levels.size(); l++ )
+	{
+		int level = levels[l];
+
+		// Mark the pixels with at least this coverage
+		for( int n = 0; n < (int)grid.size(); n++ )
+			grid[n] = DT_INF;
+		for( int y = 0; y < m_charImg->height; y++ )
+		{
+			for( int x = 0; x < m_charImg->width; x++ )
+			{
+				if( m_charImg->pixels8[y*m_charImg->width+x] >= level )
+					grid[(y+thickness)*img->width+(x+thickness)] = 0;
+			}
+		}
+
+		SquaredDistanceTransform(&grid[0], img->width, img->height);
+
+		for( int n = 0; n < (int)grid.size(); n++ )
+		{
+			if( grid[n] < maxDist )
+			{
+				WORD val = WORD(level*kernel[int(grid[n])]);
+				if( val > outline[n] )
+					outline[n] = val;
+			}
+		}
+	}
+
+	// The glyph pixels themselves are fully covered by the outline
+	for( int y = 0; y < img->height; y++ )
+	{
+		for( int x = 0; x < img->width; x++ )
+		{
+			WORD cs = 0;
+			if( x >= thickness && x < thickness + m_charImg->width && 
+				y >= thickness && y < thickness + m_charImg->height )
+				cs = m_charImg->pixels8[(y-thickness)*m_charImg->width+(x-thickness)];
+
+			if( cs )
+				img->pixels16[y*img->width+x] = 0xFF00|cs;
+			else
+				img->pixels16[y*img->width+x] = WORD(outline[y*img->width+x]<<8);
+		}
+	}
 }
\ No newline at end of file
@@ -28,9 +28,102 @@
 #ifndef FONTCHAR_H
 #define FONTCHAR_H
 
+#include <vector>
 #include "ac_image.h"
+#include "fontbackend.h"
 
 class CFontGen;
+class CGlyphShape;
+
+// The formats of the character images. The glyphs only need the coverage, 
+// so they are kept with one byte per pixel, or two bytes per pixel once 
+// the outline has been added. Only the imported images keep 32 bit colors. 
+// The images are converted to the texture format when the pages are composed.
+enum EGlyphFormat
+{
+	e_glyph8,          // The coverage of the glyph
+	e_glyphOutline16,  // The glyph in the low byte and the outline in the high byte
+	e_color32          // ARGB colors
+};
+
+// The ways the outline can be computed. The cost of the kernel grows with 
+// the square of the thickness, while the distance transforms only depend on 
+// the size of the outlined image. The distance transforms approximate the 
+// partial coverage, see CFontChar::DrawOutlineWithDistance.
+enum EOutlineMethod
+{
+	e_outlineKernel,
+	e_outlineDistance,
+	e_numOutlineMethods
+};
+
+// Names used for the outline methods in the font configuration file
+const char *GetOutlineMethodName(int method);
+int         GetOutlineMethodFromName(const char *name);
+
+// The distance fields that can be generated instead of the normal glyphs
+enum EDistanceField
+{
+	e_distanceFieldNone,
+	e_distanceFieldSDF,
+	e_distanceFieldMSDF,
+	e_numDistanceFields
+};
+
+// Names used for the distance fields in the font configuration file and the font descriptor
+const char *GetDistanceFieldName(int type);
+int         GetDistanceFieldFromName(const char *name);
+
+class CGlyphImage
+{
+public:
+	CGlyphImage();
+	CGlyphImage(int width, int height, int format);
+	~CGlyphImage();
+
+	int   Create(int width, int height, int format);
+	void  Clear();
+	int   GetBytesPerPixel() const;
+
+	// Returns the pixel as ARGB, with the glyph in the color 
+	// channels and the outline in the alpha channel
+	DWORD GetColor(int x, int y) const;
+
+	int width;
+	int height;
+	int format;
+
+	union
+	{
+		BYTE  *pixels8;
+		WORD  *pixels16;
+		DWORD *pixels32;
+	};
+
+private:
+	CGlyphImage(const CGlyphImage &);
+	CGlyphImage &operator=(const CGlyphImage &);
+};
+
+// The font backend used for drawing the characters. The backends can't be 
+// used by multiple threads at the same time, so each thread that draws 
+// characters must have its own context.
+struct SRasterContext
+{
+	SRasterContext() {backend = 0; fontHeight = 0; fontAscent = 0;}
+
+	CFontBackend *backend;
+
+	// Height and ascent of the font with the height scale applied
+	int   fontHeight;
+	int   fontAscent;
+
+	// The polygons of the glyph outline. They are kept in the context 
+	// so the memory is reused for each character drawn by the thread
+	std::vector<POINT> points;
+	std::vector<int>   polyPointCounts;
+	SGlyphOutline      outline;
+};
 
 class CFontChar
 {
@@ -38,16 +131,21 @@ public:
 	CFontChar();
 	~CFontChar();
 
-	int  DrawChar(HFONT font, int id, const CFontGen *gen);
-	int  DrawInvalidCharGlyph(HFONT font, const CFontGen *gen);
-	void AddOutline(int thickness);
+	int  DrawChar(SRasterContext &ctx, int id, const CFontGen *gen);
+	int  DrawInvalidCharGlyph(SRasterContext &ctx, const CFontGen *gen);
+	void AddOutline(int thickness, int method);
 
-	int  DrawGlyph(HFONT font, int glyph, const CFontGen *gen);
-	int  DrawGlyphFromOutline(HDC dc, int glyph, int fontHeight, int fontAscent, const CFontGen *gen);
-	int  DrawGlyphFromBitmap(HDC dc, int glyph, int fontHeight, int fontAscent, const CFontGen *gen);
+	// DrawChar is done in two steps. DrawGlyph rasterizes the glyph with the 
+	// font backend, and FinishGlyph downscales the supersampled image and adjusts 
+	// the cell. The second step doesn't use the backend and can be done by any thread.
+	int  DrawGlyph(SRasterContext &ctx, int glyph, const CFontGen *gen);
+	void FinishGlyph(int fontHeight, const CFontGen *gen);
+	int  DrawGlyphFromOutline(SRasterContext &ctx, int glyph, int fontAscent, const CFontGen *gen);
+	int  DrawGlyphFromBitmap(SRasterContext &ctx, int glyph);
 
-	void DownscaleImage(bool useSmoothing);
 	void TrimLeftAndRight();
+	void DrawOutlineWithKernel(CGlyphImage *img, int thickness);
+	void DrawOutlineWithDistance(CGlyphImage *img, int thickness);
 
 	void CreateFromImage(int id, cImage *image, int xoffset, int yoffset, int advance);
 
@@ -69,7 +167,11 @@ public:
 	bool m_colored;
 	bool m_isChar;
 
-	cImage *m_charImg;
+	CGlyphImage *m_charImg;
+
+	// The outline of the glyph, kept from DrawGlyph until 
+	// FinishGlyph when generating multi-channel distance fields
+	CGlyphShape *m_shape;
 };
 
 #endif
\ No newline at end of file
@@ -25,31 +25,73 @@
    andreas@angelcode.com
 */
 
-#include <process.h>
 #include <assert.h>
-#include <windows.h>
-#include <wingdi.h>
 #include <math.h>
-#include <Usp10.h>
+#include <stdlib.h>
 #include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include "acutil_config.h"
-#include "dynamic_funcs.h"
 #include "ac_string_util.h"
 #include "fontgen.h"
 #include "fontchar.h"
+#include "fontbackend.h"
+#include "fontcache.h"
+#include "fontpacker.h"
 #include "unicode.h"
 #include "acimg.h"
 #include "acutil_unicode.h"
 #include "acutil_path.h"
+
+#ifdef _WIN32
 #include "acwin_window.h"
+using namespace acWindow;
+#endif
 
 using namespace std;
-using namespace acWindow;
 
 #define CLR_BORDER 0x007F00ul
 #define CLR_UNUSED 0xFF0000ul
 
+// The characters are drawn in a pipeline of tasks. The first stage draws a 
+// range of characters from the list and splits off part of the range when it 
+// is large, so idle workers can steal it. Each drawn character then gets its 
+// own tasks for downscaling and adding the outline, as the cost of these vary 
+// a lot between characters.
+enum EGenerateStage
+{
+	e_drawRange,
+	e_finishGlyph,
+	e_addOutline
+};
+
+struct SGenerateTask
+{
+	CFontGen  *gen;
+	int        stage;
+	const int *charList;
+	int        begin;
+	int        end;
+	int        ch;
+	int        fontHeight;
+};
+
+// Each candidate texture width is tried in its own task, which 
+// searches for the smallest height that holds all the characters
+struct SAutoSizeTask
+{
+	CFontGen                 *gen;
+	const vector<CFontChar*> *chars;
+	const vector<int>        *heights;
+	int                       width;
+	int                       minHeight;
+	int                       maxPages;
+	int                       height;
+	int                       numPages;
+};
+
 CFontGen::CFontGen()
 {
 	fontChanged       = true;
@@ -60,6 +102,7 @@ CFontGen::CFontGen()
 	outOfMemory       = false;
 
 	fontName               = "Arial";
+	fontBackend            = GetDefaultFontBackend();
 	charSet                = ANSI_CHARSET;
 	fontSize               = 32;
 	aa                     = 1;
@@ -89,8 +132,19 @@ CFontGen::CFontGen()
 	textureFormat      = "tga";
 	textureCompression = 0;
 	fontDescFormat     = 0;
+	autoSize           = false;
+	autoSizeMaxPages   = 1;
+	autoSizePowerOf2   = true;
+	pageWidth          = outWidth;
+	pageHeight         = outHeight;
+	packingTime        = 0;
 
 	outlineThickness   = 0;
+	outlineMethod      = e_outlineKernel;
+	distanceField      = e_distanceFieldNone;
+	distanceFieldSpread = 4;
+	numThreads         = 0;
+	packer             = e_packerSkyline;
 	alphaChnl = 1;
 	redChnl   = 0;
 	greenChnl = 0;
@@ -100,18 +154,30 @@ CFontGen::CFontGen()
 	invG = false;
 	invB = false;
 
-	memset(selected, 0, sizeof(selected));
-	memset(chars, 0, sizeof(chars));
 	invalidCharGlyph = 0;
+
+	threadPool = &ownThreadPool;
+	fontCache  = 0;
+	atlasOwner = 0;
+
+	fontSizes.push_back(fontSize);
+	sharedAtlas = false;
+	drawOnly    = false;
 }
 
 CFontGen::~CFontGen()
 {
 	assert(!isWorking);
 
+	// Stop sharing the pages, as they refer to the characters of the fonts
+	SetAtlasOwner(0);
+	while( atlasFonts.size() )
+		atlasFonts.back()->SetAtlasOwner(0);
+
 	ClearSubsets();
 
 	ClearPages();
+	ClearGlyphCache();
 
 	ClearIconImages();
 }
@@ -326,6 +392,26 @@ string CFontGen::GetFontFile() const
 	return fontFile;
 }
 
+int CFontGen::GetFontBackend() const
+{
+	return fontBackend;
+}
+
+int CFontGen::SetFontBackend(int backend)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( !IsFontBackendAvailable(backend) )
+		return -1;
+
+	if( fontBackend != backend )
+		fontChanged = true;
+	fontBackend = backend;
+
+	return 0;
+}
+
 string CFontGen::GetTextureFormat() const
 {
 	return textureFormat;
@@ -359,9 +445,9 @@ int CFontGen::IsSubsetSelected(int subset)
 
 		for( int n = subsets[subset]->charBegin; n <= subsets[subset]->charEnd; n++ )
 		{
-			if( !disabled[n] )
+			if( !disabled.Get(n) )
 			{
-				if( selected[n] )
+				if( selected.Get(n) )
 					someChecked = true;
 				else
 					allChecked = false;
@@ -396,7 +482,7 @@ int CFontGen::ClearAll()
 	if( isWorking ) return -1;
 	arePagesGenerated = false;
 	
-	memset(selected, 0, (maxUnicodeChar+1)*sizeof(bool));
+	selected.SetAll(false);
 	numCharsSelected = 0;
 
 	// Clear all subset selected flags
@@ -428,17 +514,17 @@ int CFontGen::GetNumCharsAvailable()
 
 bool CFontGen::DidNotFit(int charIdx)
 {
-	return noFit[charIdx];
+	return noFit.Get(charIdx);
 }
 
 bool CFontGen::IsDisabled(int charIdx)
 {
-	return disabled[charIdx];
+	return disabled.Get(charIdx);
 }
 
 bool CFontGen::IsSelected(int charIdx)
 {
-	return selected[charIdx];
+	return selected.Get(charIdx);
 }
 
 bool CFontGen::IsAlphaInverted() const
@@ -461,7 +547,8 @@ bool CFontGen::IsBlueInverted() const
 	return invB;
 }
 
-HFONT CFontGen::CreateFont(int FontSize)
+#ifdef _WIN32
+HFONT CFontGen::CreateFont(int FontSize) const
 {
 	if( FontSize == 0 ) FontSize = fontSize*aa;
 	DWORD quality = useSmoothing ? ANTIALIASED_QUALITY : NONANTIALIASED_QUALITY;
@@ -475,6 +562,7 @@ HFONT CFontGen::CreateFont(int FontSize)
 
 	return font;
 }
+#endif
 
 
 int CFontGen::SetSelected(int idx, bool set)
@@ -482,12 +570,12 @@ int CFontGen::SetSelected(int idx, bool set)
 	if( isWorking ) return -1;
 	arePagesGenerated = false;
 
-	if( disabled[idx] )
+	if( disabled.Get(idx) )
 		return -1;
 
-	if( selected[idx] != set )
+	if( selected.Get(idx) != set )
 	{
-		selected[idx] = set;
+		selected.Set(idx, set);
 		numCharsSelected += set ? 1 : -1;
 
 		// Clear the cached subset selected flag
@@ -509,6 +597,15 @@ int CFontGen::Prepare()
 	if( fourChnlPacked && outBitDepth != 32 )
 		Set4ChnlPacked(false);
 
+	// The multi-channel distance field needs all the channels
+	if( distanceField == e_distanceFieldMSDF )
+	{
+		if( outBitDepth != 32 )
+			SetOutBitDepth(32);
+		if( fourChnlPacked )
+			Set4ChnlPacked(false);
+	}
+
 	ResetFont();
 
 	return 0;
@@ -577,6 +674,49 @@ int CFontGen::SetOutWidth(int width)
 	return 0;
 }
 
+bool CFontGen::GetAutoSize() const
+{
+	return autoSize;
+}
+
+int CFontGen::SetAutoSize(bool set)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	autoSize = set;
+	return 0;
+}
+
+int CFontGen::GetAutoSizeMaxPages() const
+{
+	return autoSizeMaxPages;
+}
+
+int CFontGen::SetAutoSizeMaxPages(int maxPages)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( maxPages < 1 ) maxPages = 1;
+	autoSizeMaxPages = maxPages;
+	return 0;
+}
+
+bool CFontGen::GetAutoSizePowerOf2() const
+{
+	return autoSizePowerOf2;
+}
+
+int CFontGen::SetAutoSizePowerOf2(bool set)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	autoSizePowerOf2 = set;
+	return 0;
+}
+
 int CFontGen::GetOutlineThickness() const
 {
 	return outlineThickness;
@@ -591,6 +731,180 @@ int CFontGen::SetOutlineThickness(int thickness)
 	return 0;
 }
 
+int CFontGen::GetOutlineMethod() const
+{
+	return outlineMethod;
+}
+
+int CFontGen::SetOutlineMethod(int method)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( method < 0 || method >= e_numOutlineMethods )
+		return -1;
+
+	outlineMethod = method;
+	return 0;
+}
+
+int CFontGen::GetDistanceField() const
+{
+	return distanceField;
+}
+
+int CFontGen::SetDistanceField(int type)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( type < 0 || type >= e_numDistanceFields )
+		return -1;
+
+	distanceField = type;
+	return 0;
+}
+
+int CFontGen::GetDistanceFieldSpread() const
+{
+	return distanceFieldSpread;
+}
+
+int CFontGen::SetDistanceFieldSpread(int spread)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( spread < 1 )
+		return -1;
+
+	distanceFieldSpread = spread;
+	return 0;
+}
+
+int CFontGen::GetNumThreads() const
+{
+	return numThreads;
+}
+
+int CFontGen::SetNumThreads(int threads)
+{
+	if( isWorking ) return -1;
+
+	if( threads < 0 ) threads = 0;
+
+	// The worker threads will be restarted with the new count on the next generation
+	if( numThreads != threads )
+		ownThreadPool.Stop();
+
+	numThreads = threads;
+	return 0;
+}
+
+acUtility::CThreadPool *CFontGen::GetThreadPool() const
+{
+	if( threadPool == &ownThreadPool )
+		return 0;
+
+	return threadPool;
+}
+
+int CFontGen::SetThreadPool(acUtility::CThreadPool *pool)
+{
+	if( isWorking ) return -1;
+	if( pool && pool->GetNumThreads() == 0 ) return -1;
+
+	threadPool = pool ? pool : &ownThreadPool;
+	return 0;
+}
+
+CFontCache *CFontGen::GetFontCache() const
+{
+	return fontCache;
+}
+
+CFontGen *CFontGen::GetAtlasOwner() const
+{
+	return atlasOwner;
+}
+
+int CFontGen::SetAtlasOwner(CFontGen *owner)
+{
+	if( isWorking ) return -1;
+
+	// The owner can't share the pages of another generator in turn
+	if( owner == this || (owner && (owner->atlasOwner || atlasFonts.size())) )
+		return -1;
+	if( (atlasOwner && atlasOwner->isWorking) || (owner && owner->isWorking) )
+		return -1;
+
+	arePagesGenerated = false;
+
+	if( atlasOwner )
+	{
+		// The owner's pages refer to the characters of this font
+		atlasOwner->ClearPages();
+		atlasOwner->arePagesGenerated = false;
+
+		for( unsigned int n = 0; n < atlasOwner->atlasFonts.size(); n++ )
+		{
+			if( atlasOwner->atlasFonts[n] == this )
+			{
+				atlasOwner->atlasFonts.erase(atlasOwner->atlasFonts.begin() + n);
+				break;
+			}
+		}
+	}
+
+	atlasOwner = owner;
+
+	if( owner )
+	{
+		owner->atlasFonts.push_back(this);
+		owner->arePagesGenerated = false;
+	}
+
+	return 0;
+}
+
+int CFontGen::SetFontCache(CFontCache *cache)
+{
+	if( isWorking ) return -1;
+
+	fontCache = cache;
+	return 0;
+}
+
+int CFontGen::GetPacker() const
+{
+	return packer;
+}
+
+int CFontGen::SetPacker(int value)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( value < 0 || value >= e_numPackers )
+		return -1;
+
+	packer = value;
+	return 0;
+}
+
+string CFontGen::GetGlyphCacheDir() const
+{
+	return glyphCacheDir;
+}
+
+int CFontGen::SetGlyphCacheDir(const string &dir)
+{
+	if( isWorking ) return -1;
+
+	glyphCacheDir = dir;
+	return 0;
+}
+
 int CFontGen::SetAlphaChnl(int value)
 {
 	if( isWorking ) return -1;
@@ -817,6 +1131,38 @@ int CFontGen::SetFontSize(int fontSize)
 	arePagesGenerated = false;
 
 	this->fontSize = fontSize;
+	fontSizes.assign(1, fontSize);
+	return 0;
+}
+
+vector<int> CFontGen::GetFontSizes() const
+{
+	return fontSizes;
+}
+
+int CFontGen::SetFontSizes(const vector<int> &sizes)
+{
+	if( isWorking ) return -1;
+	arePagesGenerated = false;
+
+	if( sizes.size() == 0 )
+		return -1;
+
+	fontSize  = sizes[0];
+	fontSizes = sizes;
+	return 0;
+}
+
+bool CFontGen::GetSharedAtlas() const
+{
+	return sharedAtlas;
+}
+
+int CFontGen::SetSharedAtlas(bool set)
+{
+	if( isWorking ) return -1;
+
+	sharedAtlas = set;
 	return 0;
 }
 
@@ -849,6 +1195,8 @@ int CFontGen::SetFontFile(const string &file)
 	if( isWorking ) return -1;
 	arePagesGenerated = false;
 
+#ifdef _WIN32
+	// The GDI backend can only use fonts that are installed or added to the system
 	if( fontFile != file )
 	{
 		// Remove the old font
@@ -864,6 +1212,11 @@ int CFontGen::SetFontFile(const string &file)
 		ConvertUtf8ToTChar(file, buf, 1024);
 		AddFontResourceEx(buf, FR_PRIVATE, 0);
 	}
+#endif
+
+	// With the FreeType backend the file is what selects the font
+	if( fontFile != file )
+		fontChanged = true;
 
 	fontFile = file;
 	return 0;
@@ -1020,6 +1373,44 @@ int CFontGen::GetNumPages()
 	return pages.size();
 }
 
+int CFontGen::GetPageWidth() const
+{
+	return pageWidth;
+}
+
+int CFontGen::GetPageHeight() const
+{
+	return pageHeight;
+}
+
+float CFontGen::GetFillRatio()
+{
+	if( pages.size() == 0 ) return 0;
+
+	// In four channel packed mode each channel is a separate layer
+	int numChannels = (outBitDepth == 32 && fourChnlPacked) ? 4 : 1;
+
+	double used = 0;
+	for( unsigned int n = 0; n < pages.size(); n++ )
+		used += pages[n]->GetUsedArea();
+
+	return float(used / (double(pageWidth) * pageHeight * numChannels * pages.size()));
+}
+
+int CFontGen::GetPageStats(int page, SPageStats &stats)
+{
+	if( isWorking ) return -1;
+	if( page < 0 || page >= (signed)pages.size() ) return -1;
+
+	stats = pages[page]->GetStats();
+	return 0;
+}
+
+double CFontGen::GetPackingTime() const
+{
+	return packingTime;
+}
+
 string CFontGen::GetFontName() const
 {
 	return fontName;
@@ -1046,8 +1437,8 @@ void CFontGen::ResetFont()
 {
 	if( fontChanged )
 	{
-		memset(disabled, 0, sizeof(disabled));
-		memset(noFit, 0, sizeof(noFit));
+		disabled.SetAll(false);
+		noFit.SetAll(false);
 
 		DetermineExistingChars();
 	}
@@ -1057,133 +1448,257 @@ void CFontGen::ResetFont()
 // Internal
 void CFontGen::DetermineExistingChars()
 {
-	HDC dc = GetDC(0);
+	// Fonts that are shared with other generators are only scanned once
+	CCharSet scanned;
+	const CCharSet *existing = 0;
+	if( fontCache )
+		existing = fontCache->GetExistingChars(this);
+	else if( ScanExistingChars(scanned) >= 0 )
+		existing = &scanned;
+
+	// A font that couldn't be opened has no characters, 
+	// but the subsets must still be set up for the selection
+	if( existing == 0 )
+	{
+		scanned.SetAll(false);
+		existing = &scanned;
+	}
 
-	HFONT font = CreateFont(10);
-	HFONT oldFont = (HFONT)SelectObject(dc, font);
+	numCharsAvailable = 0;
+	numCharsSelected = 0;
 
-	if( fGetGlyphIndicesA )
+	if( useUnicode )
 	{
-		numCharsAvailable = 0;
-		numCharsSelected = 0;
+		ClearSubsets();
+		disabled.SetAll(true);
 
-		if( useUnicode )
+		for( int subset = 0; subset < numUnicodeSubsets; subset++ )
 		{
-			ClearSubsets();
-			memset(disabled, 1, (maxUnicodeChar+1)*sizeof(bool));
-
-			// GetGlyphIndices doesn't support surrogate pairs
-			// neither does ScriptGetCMap, so we'll have to go the 
-			// long route and use ScriptItemize and ScriptShape	
-			SCRIPT_CACHE sc = 0;
+			// Unicode subsets that have no defined characters are all disabled
+			if( UnicodeSubsets[subset].name[0] == '(' )
+				continue;
 
-			for( int subset = 0; subset < numUnicodeSubsets; subset++ )
+			unsigned int begin = UnicodeSubsets[subset].beginChar;
+			while( begin <= UnicodeSubsets[subset].endChar )
 			{
-				// Unicode subsets that have no defined characters are all disabled
-				if( UnicodeSubsets[subset].name[0] == '(' )
-					continue;
-
-				unsigned int begin = UnicodeSubsets[subset].beginChar;
-				while( begin <= UnicodeSubsets[subset].endChar )
+				unsigned int end = begin + 255;
+				if( end > UnicodeSubsets[subset].endChar )
+					end = UnicodeSubsets[subset].endChar;
+
+				// Create a subset with at most 256 characters
+				SSubset *set = new SSubset;
+				set->name      = UnicodeSubsets[subset].name;
+				set->charBegin = begin;
+				set->charEnd   = end;
+				subsets.push_back(set);
+
+				// Determine the available characters in this set
+				for( unsigned int n = begin; n <= end; n++ )
 				{
-					unsigned int end = begin + 255;
-					if( end > UnicodeSubsets[subset].endChar )
-						end = UnicodeSubsets[subset].endChar;
-
-					// Create a subset with at most 256 characters
-					SSubset *set = new SSubset;
-					set->name      = UnicodeSubsets[subset].name;
-					set->charBegin = begin;
-					set->charEnd   = end;
-					subsets.push_back(set);
-
-					// Determine the available characters in this set
-					for( unsigned int n = begin; n <= end; n++ )
-					{
-						bool exists = DoesUnicodeCharExist(dc, &sc, n) > 0;
+					bool exists = existing->Get(n);
 
-						if( !disableBoxChars || exists )
-						{
-							disabled[n] = false;
+					if( !disableBoxChars || exists )
+					{
+						disabled.Set(n, false);
 
-							// Mark the subset as available
-							set->available = true;
+						// Mark the subset as available
+						set->available = true;
 
-							// Count the number of available characters
-							// and update the number of selected ones
-							numCharsAvailable++;
-							if( selected[n] ) 
-								numCharsSelected++;
-						}
+						// Count the number of available characters
+						// and update the number of selected ones
+						numCharsAvailable++;
+						if( selected.Get(n) ) 
+							numCharsSelected++;
 					}
-
-					// Next 256 characters in the subset
-					begin += 256;
 				}
-			}
 
-			// Clean up the cache created by Uniscribe
-			if( sc != 0 )
-				ScriptFreeCache(&sc);
+				// Next 256 characters in the subset
+				begin += 256;
+			}
 		}
-		else
-		{
-			// Create the basic subset
-			SSubset *set = new SSubset;
-			set->name      = "";
-			set->charBegin = 0;
-			set->charEnd   = 255;
-			subsets.push_back(set);
+	}
+	else
+	{
+		// Create the basic subset
+		SSubset *set = new SSubset;
+		set->name      = "";
+		set->charBegin = 0;
+		set->charEnd   = 255;
+		subsets.push_back(set);
 
-			memset(disabled, 0, 256*sizeof(bool));
+		for( int n = 0; n < 256; n++ )
+			disabled.Set(n, false);
 
-			for( int n = 0; n < 256; n++ )
+		for( int n = 0; n < 256; n++ )
+		{
+			if( disableBoxChars && !existing->Get(n) )
+				disabled.Set(n, true);
+			else
 			{
-				char buf[2];
-				buf[0] = n;
-				buf[1] = '\0';
-
-				WORD idx;
-				int r = fGetGlyphIndicesA(dc, buf, 1, &idx, GGI_MARK_NONEXISTING_GLYPHS);
-
-				if( disableBoxChars && (r == GDI_ERROR || idx == 0xFFFF) )
-					disabled[n] = true;
-				else
-				{
-					numCharsAvailable++;
-					if( selected[n] ) 
-						numCharsSelected++;
-				}
+				numCharsAvailable++;
+				if( selected.Get(n) ) 
+					numCharsSelected++;
 			}
 		}
 	}
-
-	SelectObject(dc, oldFont);
-	DeleteObject(font);
-
-	ReleaseDC(0, dc);
 }
 
 // Internal
-void CFontGen::ClearPages()
+// Finds the characters that exist in the font, among the characters that may be selected
+int CFontGen::ScanExistingChars(CCharSet &existing) const
 {
-	for( int n = 0; n < (signed)pages.size(); n++ )
+	CFontBackend *backend = CFontBackend::Create(fontBackend);
+	if( backend == 0 || backend->Open(this, 10) < 0 )
 	{
-		if( pages[n] ) delete pages[n];
-		pages[n] = 0;
+		delete backend;
+		return -1;
 	}
 
-	pages.clear();
-
-	for( int n = 0; n < maxUnicodeChar+1; n++ )
+	// Reading the cmap table directly is much faster than asking the 
+	// font system about each of the more than a million code points
+	if( useUnicode && GetCharsFromCMAP(backend, existing) >= 0 )
 	{
-		if( chars[n] ) delete chars[n];
-		chars[n] = 0;
+		delete backend;
+		return 0;
 	}
 
-	if( invalidCharGlyph ) delete invalidCharGlyph;
-	invalidCharGlyph = 0;
-}
+	existing.SetAll(false);
+	if( useUnicode )
+	{
+		for( int subset = 0; subset < numUnicodeSubsets; subset++ )
+		{
+			// Unicode subsets that have no defined characters are all disabled
+			if( UnicodeSubsets[subset].name[0] == '(' )
+				continue;
+
+			for( unsigned int n = UnicodeSubsets[subset].beginChar; n <= UnicodeSubsets[subset].endChar; n++ )
+			{
+				if( backend->DoesCharExist(n) )
+					existing.Set(n, true);
+			}
+		}
+	}
+	else
+	{
+		for( int n = 0; n < 256; n++ )
+		{
+			if( backend->DoesCharExist(n) )
+				existing.Set(n, true);
+		}
+	}
+
+	delete backend;
+	return 0;
+}
+
+// Internal
+void CFontGen::ClearPages()
+{
+	for( int n = 0; n < (signed)pages.size(); n++ )
+	{
+		if( pages[n] ) 
+		{
+			// The characters may be cached so they must be restored
+			pages[n]->RemoveChars();
+			delete pages[n];
+		}
+		pages[n] = 0;
+	}
+
+	pages.clear();
+
+	// The glyphs that are in the cache are owned by it
+	for( int n = chars.Next(0); n >= 0; n = chars.Next(n+1) )
+	{
+		CFontChar *fontChar = chars.Get(n);
+		if( fontChar != glyphCache.Get(n) )
+			delete fontChar;
+	}
+	chars.RemoveAll();
+
+	if( invalidCharGlyph ) delete invalidCharGlyph;
+	invalidCharGlyph = 0;
+}
+
+// Internal
+// Must be called after ClearPages, as the chars table may share the glyphs
+void CFontGen::ClearGlyphCache()
+{
+	glyphCache.DeleteAll();
+	glyphCacheKey = "";
+}
+
+// Internal
+// Describes all the settings that affect how the glyphs are drawn. The 
+// font file is not included, as the glyph cache file identifies the font 
+// by its content so the cache can be shared between computers.
+string CFontGen::GetGlyphCacheKey() const
+{
+	return acStringFormat("%s|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d", fontName.c_str(), 
+	                      fontBackend, charSet, fontSize, aa, scaleH, useSmoothing, isBold, isItalic, useUnicode, 
+	                      renderFromOutline, useHinting, useClearType, fixedHeight, forceZero, outlineThickness, 
+	                      outlineMethod, distanceField, distanceFieldSpread);
+}
+
+// Internal
+// Loads the glyphs from the cache file that were drawn in earlier runs, 
+// and removes them from the list of characters that must be drawn
+void CFontGen::LoadCachedGlyphs(CGlyphCacheFile &cacheFile, vector<int> &charList)
+{
+	// The cache file is identified by the font data, which is 
+	// the same whether the font is installed or loaded from file
+	SRasterContext ctx;
+	if( CreateRasterContext(ctx) < 0 )
+		return;
+
+	vector<BYTE> fontData;
+	ctx.backend->GetFontTable(0, fontData);
+	FreeRasterContext(ctx);
+
+	// Fonts that are not TrueType or OpenType are not cached
+	if( fontData.empty() )
+		return;
+
+	if( cacheFile.Open(glyphCacheDir, &fontData[0], fontData.size(), GetGlyphCacheKey()) < 0 )
+		return;
+
+#ifdef TRACE_GENERATE
+	trace << "The glyph cache file has " << cacheFile.GetNumGlyphs() << " glyphs" << endl;
+	trace.flush();
+#endif
+
+	unsigned int numLeft = 0;
+	for( unsigned int c = 0; c < charList.size(); c++ )
+	{
+		int n = charList[c];
+		CFontChar *fontChar = cacheFile.Load(n);
+		if( fontChar )
+		{
+			chars.Set(n, fontChar);
+			glyphCache.Set(n, fontChar);
+			counter++;
+		}
+		else
+			charList[numLeft++] = n;
+	}
+	charList.resize(numLeft);
+}
+
+// Internal
+// Adds the newly drawn glyphs to the cache file
+void CFontGen::SaveCachedGlyphs(CGlyphCacheFile &cacheFile, const vector<int> &charList)
+{
+	vector<CFontChar*> glyphs;
+	glyphs.reserve(charList.size());
+	for( unsigned int c = 0; c < charList.size(); c++ )
+	{
+		if( chars.Get(charList[c]) )
+			glyphs.push_back(chars.Get(charList[c]));
+	}
+
+	if( glyphs.size() )
+		cacheFile.Save(glyphs);
+}
 
 #ifdef TRACE_GENERATE
 ofstream trace;
@@ -1192,7 +1707,7 @@ ofstream trace;
 // Internal
 int CFontGen::CreatePage()
 {
-	CFontPage *page = new CFontPage(this, pages.size(), outWidth, outHeight, spacingHoriz, spacingVert);
+	CFontPage *page = new CFontPage(this, pages.size(), pageWidth, pageHeight, spacingHoriz, spacingVert);
 	if( page == 0 || !page->IsOK() )
 	{
 		stopWorking = true;
@@ -1235,8 +1750,21 @@ void CFontGen::InternalGeneratePages()
 
 	ClearPages();
 
+	// The glyphs from the earlier generations can only be 
+	// reused if they would be drawn exactly the same way
+	string cacheKey = fontFile + "|" + GetGlyphCacheKey();
+	if( cacheKey != glyphCacheKey )
+	{
+		ClearGlyphCache();
+		glyphCacheKey = cacheKey;
+	}
+
+	pageWidth   = outWidth;
+	pageHeight  = outHeight;
+	packingTime = 0;
+
 	bool didNotFit = false;
-	memset(noFit, 0, sizeof(noFit));
+	noFit.SetAll(false);
 
 	if( stopWorking )
 	{
@@ -1262,25 +1790,26 @@ void CFontGen::InternalGeneratePages()
 	for( int n = 0; n < (signed)iconImages.size(); n++ )
 	{
 		int ch = iconImages[n]->id;
-		chars[ch] = new CFontChar();
-		chars[ch]->CreateFromImage(n, iconImages[n]->image, iconImages[n]->xoffset, iconImages[n]->yoffset, iconImages[n]->advance);
+		CFontChar *fontChar = new CFontChar();
+		fontChar->CreateFromImage(n, iconImages[n]->image, iconImages[n]->xoffset, iconImages[n]->yoffset, iconImages[n]->advance);
+		chars.Set(ch, fontChar);
 
 #ifdef TRACE_GENERATE
 //		trace << "Character [" << ch << "] created from image" << endl;
 //		trace.flush();
 #endif
 
-		if( chars[ch]->m_height > 0 && chars[ch]->m_width > 0 )
+		if( fontChar->m_height > 0 && fontChar->m_width > 0 )
 		{
-			if( (chars[ch]->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
-				(chars[ch]->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz )
+			if( (fontChar->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
+				(fontChar->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz )
 			{
 				didNotFit = true;
-				noFit[ch] = true;
+				noFit.Set(ch, true);
 
 				// Delete the character again so that it isn't considered again
-				delete chars[ch];
-				chars[ch] = 0;
+				delete fontChar;
+				chars.Set(ch, 0);
 
 #ifdef TRACE_GENERATE
 				trace << "Character [" << ch << "] is too large to fit texture" << endl;
@@ -1302,81 +1831,120 @@ void CFontGen::InternalGeneratePages()
 		}
 	}
 
-	// Draw each of the chars into individual images
-	HFONT font = CreateFont(0);
-	for( int n = 0; n < maxChars; n++ )
+	// Build the list of characters that must be drawn, unless 
+	// the character is already taken by an imported icon or was 
+	// drawn in an earlier generation. The storage for the characters 
+	// is reserved here, so the worker threads can store the characters 
+	// without synchronization.
+	vector<int> charList;
+	vector<int> enabledList;
+	charList.reserve(numCharsSelected);
+	enabledList.reserve(numCharsSelected);
+	for( int n = selected.Next(0); n >= 0 && n < maxChars; n = selected.Next(n+1) )
 	{
-		if( !disabled[n] && selected[n] )
+		if( !disabled.Get(n) )
 		{
-			// Unless the image is taken by an imported icon
-			// Draw the character in a separate image
-			// Determine the dimensions of the character
-			if( chars[n] == 0 )
+			enabledList.push_back(n);
+			if( chars.Get(n) == 0 )
 			{
-				chars[n] = new CFontChar();
-				int r = chars[n]->DrawChar(font, n, this);
-				if( r < 0 )
+				if( chars.Reserve(n) < 0 )
 				{
-					// The character couldn't be drawn (probably due to out of memory)
 					outOfMemory = true;
-					delete chars[n];
-					chars[n] = 0;
 					stopWorking = true;
+					break;
+				}
 
-#ifdef TRACE_GENERATE
-					trace << "Out of memory when drawing character [" << n << "]" << endl;
-					trace.flush();
-#endif
+				if( glyphCache.Get(n) )
+				{
+					chars.Set(n, glyphCache.Get(n));
+					counter++;
 				}
-				if( outlineThickness && chars[n] )
-					chars[n]->AddOutline(outlineThickness);
+				else
+					charList.push_back(n);
+			}
+			else
+				counter++;
+		}
+	}
 
-#ifdef TRACE_GENERATE
-//		trace << "Character [" << n << "] was drawn" << endl;
-//		trace.flush();
-#endif
+	// The glyphs that are not in memory may have been drawn in an earlier run
+	glyphMap.Clear();
+	CGlyphCacheFile cacheFile;
+	if( glyphCacheDir != "" && charList.size() && !stopWorking )
+		LoadCachedGlyphs(cacheFile, charList);
 
-				if( chars[n] && chars[n]->m_height > 0 && chars[n]->m_width > 0 )
-				{
-					if( (chars[n]->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
-						(chars[n]->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz )
-					{
-						didNotFit = true;
-						noFit[n] = true;	
+	// Look up the glyphs once, rather than in each worker thread. The glyph 
+	// indices are shared through the font cache by all the sizes of the font, 
+	// so only the metrics, which depend on the size, are looked up here.
+	if( charList.size() && !stopWorking )
+	{
+		CFontBackend *backend = CFontBackend::Create(fontBackend);
+		if( backend && backend->Open(this, 0) >= 0 )
+		{
+			if( fontCache )
+				backend->SetGlyphMap(fontCache->GetGlyphMap(this, backend, enabledList));
+			glyphMap.Build(backend, charList);
+		}
+		delete backend;
+	}
+
+	// Draw each of the chars into individual images. The worker threads 
+	// share the work dynamically, but each character has its own slot in 
+	// the chars array so the result is the same regardless of the order 
+	// in which the tasks are processed.
+	if( threadPool->GetNumThreads() == 0 )
+		threadPool->Start(numThreads);
+
+	rasterContexts.resize(threadPool->GetNumThreads(), 0);
+
+	if( charList.size() )
+	{
+		SGenerateTask *task = new SGenerateTask;
+		task->gen        = this;
+		task->stage      = e_drawRange;
+		task->charList   = &charList[0];
+		task->begin      = 0;
+		task->end        = charList.size();
+		task->ch         = 0;
+		task->fontHeight = 0;
+		threadPool->AddTask(taskGroup, GenerateTask, task);
+	}
+	threadPool->Wait(taskGroup);
 
-						// Delete the character again so that it isn't considered again
-						delete chars[n];
-						chars[n] = 0;
+	// Release the GDI objects used by the worker threads
+	for( unsigned int n = 0; n < rasterContexts.size(); n++ )
+	{
+		if( rasterContexts[n] )
+		{
+			FreeRasterContext(*rasterContexts[n]);
+			delete rasterContexts[n];
+			rasterContexts[n] = 0;
+		}
+	}
 
+	if( stopWorking )
+	{
+		if( outOfMemory )
+		{
 #ifdef TRACE_GENERATE
-						trace << "Character [" << n << "] is too large to fit texture" << endl;
-						trace.flush();
+			trace << "Out of memory when drawing characters" << endl;
+			trace.flush();
 #endif
-					}
-				}
-			}
-			counter++;
 
-			if( stopWorking )
-			{
-				if( outOfMemory )
-				{
-					// Free up memory so the user can continue to use the app
-					ClearPages();
-				}
+			// Free up memory so the user can continue to use the app
+			ClearPages();
+			ClearGlyphCache();
+		}
 
-				status    = 0;
-				isWorking = false;
-				DeleteObject(font);
+		status    = 0;
+		isWorking = false;
 
 #ifdef TRACE_GENERATE
-				trace << "Aborted" << endl;
-				trace.close();
+		trace << "Aborted" << endl;
+		trace.close();
 #endif
 
-				return;
-			}
-		}
+		return;
 	}
 
 #ifdef TRACE_GENERATE
@@ -1384,11 +1952,53 @@ void CFontGen::InternalGeneratePages()
 	trace.flush();
 #endif
 
+	// Keep the new glyphs for the next generation, and for the next run
+	for( unsigned int c = 0; c < charList.size(); c++ )
+	{
+		int n = charList[c];
+		if( chars.Get(n) )
+			glyphCache.Set(n, chars.Get(n));
+	}
+
+	if( cacheFile.IsOpen() )
+	{
+		SaveCachedGlyphs(cacheFile, charList);
+		cacheFile.Close();
+	}
+
+	// Remove the characters that are too large to fit the texture. The 
+	// reused glyphs must be checked too, as the texture may be smaller now.
+	for( int n = selected.Next(0); n >= 0 && n < maxChars; n = selected.Next(n+1) )
+	{
+		CFontChar *fontChar = chars.Get(n);
+		if( fontChar == 0 || fontChar != glyphCache.Get(n) )
+			continue;
+
+		if( fontChar->m_height > 0 && fontChar->m_width > 0 )
+		{
+			if( (fontChar->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
+				(fontChar->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz )
+			{
+				noFit.Set(n, true);
+
+				// Remove the character so that it isn't considered again. 
+				// It stays in the cache in case the texture gets larger.
+				chars.Set(n, 0);
+			}
+		}
+	}
+
 	// Add the invalid char glyph
 	if( outputInvalidCharGlyph )
 	{
-		invalidCharGlyph = new CFontChar();
-		int r = invalidCharGlyph->DrawInvalidCharGlyph(font, this);
+		SRasterContext ctx;
+		int r = CreateRasterContext(ctx);
+		if( r >= 0 )
+		{
+			invalidCharGlyph = new CFontChar();
+			r = invalidCharGlyph->DrawInvalidCharGlyph(ctx, this);
+			FreeRasterContext(ctx);
+		}
 		if( r < 0 )
 		{
 			// The character couldn't be drawn (probably due to out of memory)
@@ -1402,8 +2012,8 @@ void CFontGen::InternalGeneratePages()
 			trace.flush();
 #endif
 		}
-		if( outlineThickness && invalidCharGlyph )
-			invalidCharGlyph->AddOutline(outlineThickness);
+		if( outlineThickness && distanceField == e_distanceFieldNone && invalidCharGlyph )
+			invalidCharGlyph->AddOutline(outlineThickness, outlineMethod);
 
 #ifdef TRACE_GENERATE
 		trace << "Invalid char was drawn" << endl;
@@ -1411,8 +2021,8 @@ void CFontGen::InternalGeneratePages()
 #endif
 
 		if( invalidCharGlyph &&
-			(invalidCharGlyph->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
-			(invalidCharGlyph->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz )
+			((invalidCharGlyph->m_height + paddingUp + paddingDown) > outHeight-spacingVert || 
+			 (invalidCharGlyph->m_width + paddingRight + paddingLeft) > outWidth-spacingHoriz) )
 		{
 			didNotFit = true;
 
@@ -1427,22 +2037,61 @@ void CFontGen::InternalGeneratePages()
 		}
 	}
 
-	DeleteObject(font);
+	// The characters are placed on the pages when the atlas owner generates its pages
+	if( atlasOwner || drawOnly )
+	{
+		status    = 0;
+		isWorking = false;
+		if( atlasOwner )
+			arePagesGenerated = !stopWorking;
+
+#ifdef TRACE_GENERATE
+		trace << "Finished drawing for the atlas" << endl;
+		trace.close();
+#endif
+		return;
+	}
 
 	// Build a list of used characters
 	status = 2;
 	counter = 0;
 
-	static CFontChar *ch[maxUnicodeChar+2];
-	int numChars = 0;
-	for( int n = 0; n < maxChars; n++ )
+	vector<CFontChar*> ch;
+	for( int n = chars.Next(0); n >= 0 && n < maxChars; n = chars.Next(n+1) )
+		ch.push_back(chars.Get(n));
+
+	if( outputInvalidCharGlyph && invalidCharGlyph )
+		ch.push_back(invalidCharGlyph);
+
+	// The fonts that share the pages have drawn their characters already
+	for( unsigned int f = 0; f < atlasFonts.size(); f++ )
 	{
-		if( chars[n] )
-			ch[numChars++] = chars[n];
+		CFontGen *font = atlasFonts[f];
+		if( !font->arePagesGenerated )
+			continue;
+
+		int fontMaxChars = font->useUnicode ? maxUnicodeChar+1 : 256;
+		for( int n = font->chars.Next(0); n >= 0 && n < fontMaxChars; n = font->chars.Next(n+1) )
+			ch.push_back(font->chars.Get(n));
+
+		if( font->outputInvalidCharGlyph && font->invalidCharGlyph )
+			ch.push_back(font->invalidCharGlyph);
 	}
 
-	if( outputInvalidCharGlyph && invalidCharGlyph )
-		ch[numChars++] = invalidCharGlyph;
+	int numChars = (int)ch.size();
+
+	chrono::high_resolution_clock::time_point packStart = chrono::high_resolution_clock::now();
+
+	// Find the smallest texture size that holds all the characters
+	if( autoSize && numChars > 0 )
+	{
+		FindAutoSize(ch);
+
+#ifdef TRACE_GENERATE
+		trace << "Texture size " << pageWidth << "x" << pageHeight << " was chosen" << endl;
+		trace.flush();
+#endif
+	}
 
 	// Create pages until there are no more chars
 	while( numChars > 0 )
@@ -1464,6 +2113,7 @@ void CFontGen::InternalGeneratePages()
 #endif
 				// Free up memory so the user can continue to work
 				ClearPages();
+				ClearGlyphCache();
 			}
 
 			status    = 0;
@@ -1482,7 +2132,7 @@ void CFontGen::InternalGeneratePages()
 		trace.flush();
 #endif
 
-		pages[page]->AddChars(ch, numChars);
+		pages[page]->AddChars(&ch[0], numChars);
 
 #ifdef TRACE_GENERATE
 		trace << "Compacting list of remaining characters" << endl;
@@ -1508,6 +2158,8 @@ void CFontGen::InternalGeneratePages()
 		}
 	}
 
+	packingTime = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - packStart).count();
+
 	status    = 0;
 	isWorking = false;
 	arePagesGenerated = true;
@@ -1518,6 +2170,294 @@ void CFontGen::InternalGeneratePages()
 #endif
 }
 
+// Internal
+// Packs the characters on pages of the given size without drawing them. 
+// Returns the number of pages needed, or -1 if more than maxPages are needed.
+int CFontGen::TrialPack(int width, int height, const vector<CFontChar*> &list, int maxPages)
+{
+	vector<CFontChar*> ch(list);
+	int numChars = (int)ch.size();
+	int numPages = 0;
+
+	while( numChars > 0 )
+	{
+		if( numPages == maxPages || stopWorking )
+			return -1;
+
+		CFontPage page(this, numPages, width, height, spacingHoriz, spacingVert, true);
+		page.SetPadding(paddingLeft, paddingUp, paddingRight, paddingDown);
+		page.SetIntendedFormat(outBitDepth, fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
+		page.AddChars(&ch[0], numChars);
+		numPages++;
+
+		// Remove the characters that were placed
+		int numLeft = 0;
+		for( int n = 0; n < numChars; n++ )
+			if( ch[n] )
+				ch[numLeft++] = ch[n];
+
+		// Nothing more will fit on this size
+		if( numLeft == numChars )
+			return -1;
+
+		numChars = numLeft;
+	}
+
+	return numPages;
+}
+
+// Internal
+void CFontGen::AutoSizeTask(void *arg, int /*worker*/)
+{
+	SAutoSizeTask *task = reinterpret_cast<SAutoSizeTask*>(arg);
+	CFontGen *gen = task->gen;
+	const vector<int> &heights = *task->heights;
+
+	task->height   = 0;
+	task->numPages = 0;
+
+	// Skip the heights that cannot possibly hold the characters
+	int lo = 0;
+	while( lo < (signed)heights.size() && heights[lo] < task->minHeight )
+		lo++;
+	if( lo == (signed)heights.size() )
+		return;
+
+	// The largest height must work, or else there is no point in searching
+	int hi = (int)heights.size() - 1;
+	int numPages = gen->TrialPack(task->width, heights[hi], *task->chars, task->maxPages);
+	if( numPages < 0 )
+		return;
+
+	// Binary search for the smallest height that still holds the characters
+	task->height   = heights[hi];
+	task->numPages = numPages;
+	while( lo < hi )
+	{
+		int mid = (lo + hi) / 2;
+		numPages = gen->TrialPack(task->width, heights[mid], *task->chars, task->maxPages);
+		if( numPages < 0 )
+			lo = mid + 1;
+		else
+		{
+			hi = mid;
+			task->height   = heights[mid];
+			task->numPages = numPages;
+		}
+	}
+}
+
+// Internal
+void CFontGen::FindAutoSize(const vector<CFontChar*> &list)
+{
+	// Determine the largest character and the total area 
+	// needed, which gives the lower bounds of the size
+	int numChannels = (outBitDepth == 32 && fourChnlPacked) ? 4 : 1;
+	int maxW = 1, maxH = 1;
+	double area = 0;
+	for( unsigned int n = 0; n < list.size(); n++ )
+	{
+		int w = list[n]->m_width + paddingLeft + paddingRight + spacingHoriz;
+		int h = list[n]->m_height + paddingUp + paddingDown + spacingVert;
+		if( w > maxW ) maxW = w;
+		if( h > maxH ) maxH = h;
+
+		// Colored images use all channels
+		area += double(w) * h * ((numChannels == 4 && !list[n]->m_isChar) ? 4 : 1);
+	}
+	area /= double(numChannels) * autoSizeMaxPages;
+
+	// Determine the candidate sizes. Without power of 2 the 
+	// sizes are kept to multiples of 4 for the sake of texture 
+	// compression and to keep the number of candidates small.
+	vector<int> widths, heights;
+	if( autoSizePowerOf2 )
+	{
+		for( int w = 1; w < outWidth; w *= 2 )
+			if( w >= maxW ) widths.push_back(w);
+		for( int h = 1; h < outHeight; h *= 2 )
+			if( h >= maxH ) heights.push_back(h);
+	}
+	else
+	{
+		int step = (outWidth/64 + 3) & ~3;
+		if( step < 4 ) step = 4;
+		for( int w = step; w < outWidth; w += step )
+			if( w >= maxW ) widths.push_back(w);
+		for( int h = 4; h < outHeight; h += 4 )
+			if( h >= maxH ) heights.push_back(h);
+	}
+	widths.push_back(outWidth);
+	heights.push_back(outHeight);
+
+	// Try each width in parallel
+	if( threadPool->GetNumThreads() == 0 )
+		threadPool->Start(numThreads);
+
+	vector<SAutoSizeTask> tasks(widths.size());
+	for( unsigned int n = 0; n < widths.size(); n++ )
+	{
+		SAutoSizeTask &task = tasks[n];
+		task.gen       = this;
+		task.chars     = &list;
+		task.heights   = &heights;
+		task.width     = widths[n];
+		task.minHeight = int(ceil(area / widths[n]));
+		task.maxPages  = autoSizeMaxPages;
+		threadPool->AddTask(taskGroup, AutoSizeTask, &task);
+	}
+	threadPool->Wait(taskGroup);
+
+	// Pick the size with the least total texture area. On a tie the 
+	// squarer size is preferred, and after that the narrower one.
+	double bestArea = 0;
+	for( unsigned int n = 0; n < tasks.size(); n++ )
+	{
+		if( tasks[n].height == 0 )
+			continue;
+
+		int w = tasks[n].width;
+		int h = tasks[n].height;
+		double a = double(w) * h * tasks[n].numPages;
+		if( bestArea == 0 || a < bestArea || 
+			(a == bestArea && abs(w - h) < abs(pageWidth - pageHeight)) )
+		{
+			bestArea   = a;
+			pageWidth  = w;
+			pageHeight = h;
+		}
+	}
+
+	// If nothing fits within the page limit the maximum size is used
+}
+
+// Internal
+int CFontGen::CreateRasterContext(SRasterContext &ctx)
+{
+	ctx.backend = CFontBackend::Create(fontBackend);
+	if( ctx.backend == 0 || ctx.backend->Open(this, 0) < 0 )
+	{
+		FreeRasterContext(ctx);
+		return -1;
+	}
+
+	ctx.backend->SetGlyphMap(&glyphMap);
+
+	int height, ascent;
+	ctx.backend->GetMetrics(height, ascent);
+
+	// Compute the height and ascent with scale
+	ctx.fontHeight = int(ceilf(height*float(scaleH)/100.0f));
+	ctx.fontAscent = int(ceilf(ascent*float(scaleH)/100.0f));
+
+	return 0;
+}
+
+// Internal
+void CFontGen::FreeRasterContext(SRasterContext &ctx)
+{
+	if( ctx.backend )
+		delete ctx.backend;
+
+	ctx.backend = 0;
+}
+
+// Internal
+void CFontGen::GenerateTask(void *arg, int worker)
+{
+	SGenerateTask *task = (SGenerateTask*)arg;
+	task->gen->RunGenerateTask(task, worker);
+}
+
+// Internal
+// This is called from the worker threads
+void CFontGen::RunGenerateTask(SGenerateTask *task, int worker)
+{
+	if( stopWorking )
+	{
+		delete task;
+		return;
+	}
+
+	if( task->stage == e_drawRange )
+	{
+		// Split the range in half until it is small enough, and 
+		// queue the other half where another worker can steal it
+		while( task->end - task->begin > 4 )
+		{
+			SGenerateTask *other = new SGenerateTask(*task);
+			other->begin = (task->begin + task->end)/2;
+			task->end    = other->begin;
+			threadPool->AddTask(taskGroup, GenerateTask, other, worker);
+		}
+
+		// Each worker thread has its own GDI objects
+		if( rasterContexts[worker] == 0 )
+		{
+			rasterContexts[worker] = new SRasterContext;
+			if( CreateRasterContext(*rasterContexts[worker]) < 0 )
+			{
+				outOfMemory = true;
+				stopWorking = true;
+			}
+		}
+		SRasterContext &ctx = *rasterContexts[worker];
+
+		for( int c = task->begin; c < task->end && !stopWorking; c++ )
+		{
+			int n = task->charList[c];
+
+			// Draw the character in a separate image
+			CFontChar *fontChar = new CFontChar();
+			fontChar->m_id = n;
+			int r = fontChar->DrawGlyph(ctx, n, this);
+			if( r < 0 )
+			{
+				// The character couldn't be drawn (probably due to out of memory)
+				outOfMemory = true;
+				delete fontChar;
+				stopWorking = true;
+				break;
+			}
+			chars.Set(n, fontChar);
+
+			// The downscaling is done in a separate task
+			SGenerateTask *next = new SGenerateTask(*task);
+			next->stage      = e_finishGlyph;
+			next->ch         = n;
+			next->fontHeight = ctx.fontHeight;
+			threadPool->AddTask(taskGroup, GenerateTask, next, worker);
+		}
+
+		delete task;
+		return;
+	}
+
+	CFontChar *fontChar = chars.Get(task->ch);
+	if( task->stage == e_finishGlyph )
+	{
+		fontChar->FinishGlyph(task->fontHeight, this);
+
+		// The outline is done in a separate task
+		if( outlineThickness && distanceField == e_distanceFieldNone )
+		{
+			task->stage = e_addOutline;
+			threadPool->AddTask(taskGroup, GenerateTask, task, worker);
+			return;
+		}
+	}
+	else if( task->stage == e_addOutline )
+	{
+		fontChar->AddOutline(outlineThickness, outlineMethod);
+	}
+
+	// The character is complete. The check if it fits the 
+	// texture is done after all characters have been drawn
+	counter++;
+
+	delete task;
+}
+
 // Internal
 void CFontGen::GenerateThread(CFontGen *fontGen)
 {
@@ -1543,6 +2483,17 @@ int CFontGen::GeneratePages(bool async)
 		}
 	}
 
+	// The pages of the atlas owner refer to the characters that will be drawn 
+	// again. The owner isn't touched if it hasn't generated its pages, as it 
+	// may then be drawing its own characters at the same time, see DrawChars.
+	if( atlasOwner && !arePagesGenerated && atlasOwner->arePagesGenerated )
+	{
+		if( atlasOwner->isWorking ) return -1;
+
+		atlasOwner->ClearPages();
+		atlasOwner->arePagesGenerated = false;
+	}
+
 	// Set status refresh timer
 	status = 1;
 	counter = 0;
@@ -1550,16 +2501,110 @@ int CFontGen::GeneratePages(bool async)
 	isWorking         = true;
 	stopWorking       = false;
 
-	memset(noFit, 0, sizeof(noFit));
+	noFit.SetAll(false);
 
 	if( async )
-		_beginthread((void (*)(void*))GenerateThread, 0, this);	
+		std::thread(GenerateThread, this).detach();
 	else
 		InternalGeneratePages();
 
 	return 0;
 }
 
+int CFontGen::DrawChars()
+{
+	if( isWorking ) return -1;
+
+	// The characters are kept in the glyph cache, so they must be 
+	// placed on the pages again when GeneratePages is called
+	if( arePagesGenerated )
+	{
+		ClearPages();
+		arePagesGenerated = false;
+	}
+
+	drawOnly = true;
+	int r = GeneratePages(false);
+	drawOnly = false;
+
+	return r;
+}
+
+static bool KerningPairLess(const KERNINGPAIR &a, const KERNINGPAIR &b)
+{
+	if( a.wFirst != b.wFirst )
+		return a.wFirst < b.wFirst;
+	return a.wSecond < b.wSecond;
+}
+
+static bool KerningPairEqual(const KERNINGPAIR &a, const KERNINGPAIR &b)
+{
+	return a.wFirst == b.wFirst && a.wSecond == b.wSecond;
+}
+
+// Internal
+// Returns the kerning pairs to output for the exported characters, with the 
+// amounts in output pixels. The pairs are sorted on the first and then the 
+// second character. If the font gives the same pair more than once, the first 
+// one given is used, as the font system and OpenType do when laying out text.
+void CFontGen::GetKerningPairs(CFontBackend *backend, vector<KERNINGPAIR> &pairs)
+{
+	// Build a list of all selected chars
+	vector<UINT> charList;
+	charList.reserve(GetNumCharsSelected());
+	for( int n = selected.Next(0); n >= 0; n = selected.Next(n+1) )
+		charList.push_back(n);
+
+	// The kerning in design units is the same for all sizes of 
+	// the font, so it is only read once when the font is shared
+	const vector<KERNINGPAIR> *designPairs = 0;
+	if( fontCache )
+		designPairs = fontCache->GetDesignKerningPairs(this, backend, charList);
+
+	if( designPairs )
+		ScaleKerningPairs(*designPairs, backend->GetDesignUnitScale(), pairs);
+	else
+	{
+		backend->GetKerningPairs(pairs, charList);
+
+		if( pairs.size() == 0 )
+			GetKerningPairsFromGPOS(backend, pairs, charList, backend->GetDesignUnitScale());
+	}
+
+	// It's been reported that for Chinese WinXP the kerning pairs for 
+	// non-unicode charsets may contain characters > 255, so we need to 
+	// filter for this. The order of the remaining pairs is kept.
+	const int maxChars = useUnicode ? maxUnicodeChar+1 : 256;
+	size_t count = 0;
+	for( size_t n = 0; n < pairs.size(); n++ )
+	{
+		KERNINGPAIR pair = pairs[n];
+		pair.iKernAmount /= aa;
+
+		if( pair.iKernAmount == 0 ||               // Filter kerning pairs where the adjustment is too small
+			pair.wFirst >= maxChars ||             // Filter kerning pairs if they are outside the valid range
+			pair.wSecond >= maxChars ||
+			disabled.Get(pair.wFirst) ||           // Filter kerning pairs for characters that won't be exported
+			disabled.Get(pair.wSecond) ||
+			!selected.Get(pair.wFirst) ||          // Filter kerning pairs for characters that won't be exported
+			!selected.Get(pair.wSecond) ||
+			chars.Get(pair.wFirst) == 0 ||         // Filter kerning pairs for characters that won't be exported
+			chars.Get(pair.wSecond) == 0 ||
+			!chars.Get(pair.wFirst)->m_isChar ||   // Filter kerning pairs for imported images
+			!chars.Get(pair.wSecond)->m_isChar )
+			continue;
+
+		pairs[count++] = pair;
+	}
+	pairs.resize(count);
+
+	// The list of kerning pairs returned by GetKerningPairsA sometimes has 
+	// duplicates, and a font may have the same pair in several GPOS subtables. 
+	// The stable sort keeps the duplicates in the order they were given.
+	stable_sort(pairs.begin(), pairs.end(), KerningPairLess);
+	pairs.erase(unique(pairs.begin(), pairs.end(), KerningPairEqual), pairs.end());
+}
+
 int CFontGen::SaveFont(const char *szFile)
 {
 	if( isWorking ) return -1;
@@ -1567,21 +2612,28 @@ int CFontGen::SaveFont(const char *szFile)
 	// The pages must be generated first
 	if( !arePagesGenerated ) return -1;
 
-	// Create a memory dc
-	HDC dc = CreateCompatibleDC(0);
+	// When the pages are shared the owner's texture files are used
+	const CFontGen *atlas = atlasOwner ? atlasOwner : this;
+	if( atlasOwner && (!atlasOwner->arePagesGenerated || atlasOwner->savedFileName == "") ) return -1;
 
-	HFONT font = CreateFont(0);
-	HFONT oldFont = (HFONT)SelectObject(dc, font);
+	// Load the font for the metrics and kerning pairs
+	CFontBackend *backend = CFontBackend::Create(fontBackend);
+	if( backend == 0 || backend->Open(this, 0) < 0 )
+	{
+		delete backend;
+		return -1;
+	}
+
+	// Reuse the glyphs that were looked up when the pages were generated
+	backend->SetGlyphMap(&glyphMap);
 
 	// Determine the size needed for the char
 	int height, base;
-
-	TEXTMETRIC tm;
-	GetTextMetrics(dc, &tm);
+	backend->GetMetrics(height, base);
 
 	// Round up to make sure fractional pixels are covered
-	height = (int)ceil(float(tm.tmHeight)/aa);
-	base = (int)ceil(float(tm.tmAscent)/aa);
+	height = (int)ceil(float(height)/aa);
+	base = (int)ceil(float(base)/aa);
 
 	// Save the character attributes
 	FILE *f;
@@ -1592,18 +2644,33 @@ int CFontGen::SaveFont(const char *szFile)
 
 	errno_t e = fopen_s(&f, (filename + ".fnt").c_str(), "wb");
 	if( e != 0 || f == 0 )
+	{
+		delete backend;
 		return -1;
+	}
 
 	// Get the filename without path
-	int r = filename.rfind('\\');
+	int r = (int)filename.find_last_of("\\/");
 	string filenameonly;
 	if( r != -1 )
 		filenameonly = filename.substr(r+1);
 	else
 		filenameonly = filename;
-		
+
+	// The name of the texture files, relative to the font descriptor
+	string pageFile = filenameonly;
+	if( atlasOwner )
+	{
+		string owner = atlasOwner->savedFileName;
+		int o = (int)owner.find_last_of("\\/");
+		if( filename.substr(0, r+1) == owner.substr(0, o+1) )
+			pageFile = owner.substr(o+1);
+		else
+			pageFile = acUtility::GetRelativePath(filename, owner);
+	}
+
 	if( outBitDepth != 32 ) fourChnlPacked = false;
-	int numPages = pages.size();
+	int numPages = atlas->pages.size();
 
 	// Determine the number of digits needed for the page file id
 	int numDigits = numPages > 1 ? int(log10(float(numPages-1))+1) : 1;
@@ -1612,21 +2679,23 @@ int CFontGen::SaveFont(const char *szFile)
 	{
 		fprintf(f, "<?xml version=\"1.0\"?>\r\n");
 		fprintf(f, "<font>\r\n");
-		fprintf(f, "  <info face=\"%s\" size=\"%d\" bold=\"%d\" italic=\"%d\" charset=\"%s\" unicode=\"%d\" stretchH=\"%d\" smooth=\"%d\" aa=\"%d\" padding=\"%d,%d,%d,%d\" spacing=\"%d,%d\" outline=\"%d\"/>\r\n", fontName.c_str(), fontSize, isBold, isItalic, useUnicode ? "" : GetCharSetName(charSet).c_str(), useUnicode, scaleH, useSmoothing, aa, paddingUp, paddingRight, paddingDown, paddingLeft, spacingHoriz, spacingVert, outlineThickness);
-		fprintf(f, "  <common lineHeight=\"%d\" base=\"%d\" scaleW=\"%d\" scaleH=\"%d\" pages=\"%d\" packed=\"%d\" alphaChnl=\"%d\" redChnl=\"%d\" greenChnl=\"%d\" blueChnl=\"%d\"/>\r\n", int(ceilf(height*float(scaleH)/100.0f)), int(ceilf(base*float(scaleH)/100.0f)), outWidth, outHeight, numPages, fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
+		fprintf(f, "  <info face=\"%s\" size=\"%d\" bold=\"%d\" italic=\"%d\" charset=\"%s\" unicode=\"%d\" stretchH=\"%d\" smooth=\"%d\" aa=\"%d\" padding=\"%d,%d,%d,%d\" spacing=\"%d,%d\" outline=\"%d\"%s/>\r\n", fontName.c_str(), fontSize, isBold, isItalic, useUnicode ? "" : GetCharSetName(charSet).c_str(), useUnicode, scaleH, useSmoothing, aa, paddingUp, paddingRight, paddingDown, paddingLeft, spacingHoriz, spacingVert, outlineThickness, 
+		        distanceField ? acStringFormat(" distanceField=\"%s\" spread=\"%d\"", GetDistanceFieldName(distanceField), distanceFieldSpread).c_str() : "");
+		fprintf(f, "  <common lineHeight=\"%d\" base=\"%d\" scaleW=\"%d\" scaleH=\"%d\" pages=\"%d\" packed=\"%d\" alphaChnl=\"%d\" redChnl=\"%d\" greenChnl=\"%d\" blueChnl=\"%d\"/>\r\n", int(ceilf(height*float(scaleH)/100.0f)), int(ceilf(base*float(scaleH)/100.0f)), atlas->pageWidth, atlas->pageHeight, numPages, fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
 
 		fprintf(f, "  <pages>\r\n");
 		for( int n = 0; n < numPages; n++ )
-			fprintf(f, "    <page id=\"%d\" file=\"%s_%0*d.%s\" />\r\n", n, filenameonly.c_str(), numDigits, n, textureFormat.c_str());
+			fprintf(f, "    <page id=\"%d\" file=\"%s_%0*d.%s\" />\r\n", n, pageFile.c_str(), numDigits, n, textureFormat.c_str());
 		fprintf(f, "  </pages>\r\n");
 	}
 	else if( fontDescFormat == 0 )
 	{
-		fprintf(f, "info face=\"%s\" size=%d bold=%d italic=%d charset=\"%s\" unicode=%d stretchH=%d smooth=%d aa=%d padding=%d,%d,%d,%d spacing=%d,%d outline=%d\r\n", fontName.c_str(), fontSize, isBold, isItalic, useUnicode ? "" : GetCharSetName(charSet).c_str(), useUnicode, scaleH, useSmoothing, aa, paddingUp, paddingRight, paddingDown, paddingLeft, spacingHoriz, spacingVert, outlineThickness);
-		fprintf(f, "common lineHeight=%d base=%d scaleW=%d scaleH=%d pages=%d packed=%d alphaChnl=%d redChnl=%d greenChnl=%d blueChnl=%d\r\n", int(ceilf(height*float(scaleH)/100.0f)), int(ceilf(base*float(scaleH)/100.0f)), outWidth, outHeight, numPages, fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
+		fprintf(f, "info face=\"%s\" size=%d bold=%d italic=%d charset=\"%s\" unicode=%d stretchH=%d smooth=%d aa=%d padding=%d,%d,%d,%d spacing=%d,%d outline=%d%s\r\n", fontName.c_str(), fontSize, isBold, isItalic, useUnicode ? "" : GetCharSetName(charSet).c_str(), useUnicode, scaleH, useSmoothing, aa, paddingUp, paddingRight, paddingDown, paddingLeft, spacingHoriz, spacingVert, outlineThickness, 
+		        distanceField ? acStringFormat(" distanceField=%s spread=%d", GetDistanceFieldName(distanceField), distanceFieldSpread).c_str() : "");
+		fprintf(f, "common lineHeight=%d base=%d scaleW=%d scaleH=%d pages=%d packed=%d alphaChnl=%d redChnl=%d greenChnl=%d blueChnl=%d\r\n", int(ceilf(height*float(scaleH)/100.0f)), int(ceilf(base*float(scaleH)/100.0f)), atlas->pageWidth, atlas->pageHeight, numPages, fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
 
 		for( int n = 0; n < numPages; n++ )
-			fprintf(f, "page id=%d file=\"%s_%0*d.%s\"\r\n", n, filenameonly.c_str(), numDigits, n, textureFormat.c_str());
+			fprintf(f, "page id=%d file=\"%s_%0*d.%s\"\r\n", n, pageFile.c_str(), numDigits, n, textureFormat.c_str());
 	}
 	else
 	{
@@ -1705,8 +2774,8 @@ int CFontGen::SaveFont(const char *szFile)
 		common.blockSize  = sizeof(common) - 4;
 		common.lineHeight = int(ceilf(height*float(scaleH)/100.0f));
 		common.base       = int(ceilf(base*float(scaleH)/100.0f));
-		common.scaleW     = outWidth;
-		common.scaleH     = outHeight;
+		common.scaleW     = atlas->pageWidth;
+		common.scaleH     = atlas->pageHeight;
 		common.pages      = numPages;
 		common.reserved   = 0;
 		common.packed     = fourChnlPacked;
@@ -1720,12 +2789,12 @@ int CFontGen::SaveFont(const char *szFile)
 
 		// Write the page block
 		fputc(3, f);
-		int size = (filenameonly.length() + numDigits + 2 + textureFormat.length() + 1)*numPages;
+		int size = (pageFile.length() + numDigits + 2 + textureFormat.length() + 1)*numPages;
 		fwrite(&size, sizeof(size), 1, f);
 
 		for( int n = 0; n < numPages; n++ )
 		{
-			fprintf(f, "%s_%0*d.%s", filenameonly.c_str(), numDigits, n, textureFormat.c_str());
+			fprintf(f, "%s_%0*d.%s", pageFile.c_str(), numDigits, n, textureFormat.c_str());
 			fputc(0, f);
 		}
 	}
@@ -1735,9 +2804,8 @@ int CFontGen::SaveFont(const char *szFile)
 	// Count the number of characters that will be written
 	int numChars = 0;
 	int n;
-	for( n = 0; n < maxChars; n++ )
-		if( chars[n] )
-			numChars++;
+	for( n = chars.Next(0); n >= 0 && n < maxChars; n = chars.Next(n+1) )
+		numChars++;
 
 	if( invalidCharGlyph )
 		numChars++;
@@ -1795,50 +2863,48 @@ int CFontGen::SaveFont(const char *szFile)
 		}
 	}
 
-	for( n = 0; n < maxChars; n++ )
+	for( n = chars.Next(0); n >= 0 && n < maxChars; n = chars.Next(n+1) )
 	{
-        if( chars[n] )
+		CFontChar *ch = chars.Get(n);
+		int page, chnl;
+		page = ch->m_page;
+		chnl = ch->m_chnl;
+
+		if( fontDescFormat == 1 )
+			fprintf(f, "    <char id=\"%d\" x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" xoffset=\"%d\" yoffset=\"%d\" xadvance=\"%d\" page=\"%d\" chnl=\"%d\" />\r\n", n, ch->m_x, ch->m_y, ch->m_width, ch->m_height, ch->m_xoffset, ch->m_yoffset, ch->m_advance, page, chnl);
+		else if( fontDescFormat == 0 )
+			fprintf(f, "char id=%-4d x=%-5d y=%-5d width=%-5d height=%-5d xoffset=%-5d yoffset=%-5d xadvance=%-5d page=%-2d chnl=%-2d\r\n", n, ch->m_x, ch->m_y, ch->m_width, ch->m_height, ch->m_xoffset, ch->m_yoffset, ch->m_advance, page, chnl);
+		else
 		{
-			int page, chnl;
-			page = chars[n]->m_page;
-			chnl = chars[n]->m_chnl;
-			
-			if( fontDescFormat == 1 )
-				fprintf(f, "    <char id=\"%d\" x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" xoffset=\"%d\" yoffset=\"%d\" xadvance=\"%d\" page=\"%d\" chnl=\"%d\" />\r\n", n, chars[n]->m_x, chars[n]->m_y, chars[n]->m_width, chars[n]->m_height, chars[n]->m_xoffset, chars[n]->m_yoffset, chars[n]->m_advance, page, chnl);
-			else if( fontDescFormat == 0 )
-				fprintf(f, "char id=%-4d x=%-5d y=%-5d width=%-5d height=%-5d xoffset=%-5d yoffset=%-5d xadvance=%-5d page=%-2d chnl=%-2d\r\n", n, chars[n]->m_x, chars[n]->m_y, chars[n]->m_width, chars[n]->m_height, chars[n]->m_xoffset, chars[n]->m_yoffset, chars[n]->m_advance, page, chnl);
-			else
-			{
 #pragma pack(push)
 #pragma pack(1)
-				struct charBlock
-				{
-					DWORD id;
-					WORD x;
-					WORD y;
-					WORD width;
-					WORD height;
-					short xoffset;
-					short yoffset;
-					short xadvance;
-					char  page;
-					char  channel;
-				} charInfo;
+			struct charBlock
+			{
+				DWORD id;
+				WORD x;
+				WORD y;
+				WORD width;
+				WORD height;
+				short xoffset;
+				short yoffset;
+				short xadvance;
+				char  page;
+				char  channel;
+			} charInfo;
 #pragma pack(pop)
 
-				charInfo.id = n;
-				charInfo.x  = chars[n]->m_x;
-				charInfo.y  = chars[n]->m_y;
-				charInfo.width = chars[n]->m_width;
-				charInfo.height = chars[n]->m_height;
-				charInfo.xoffset = chars[n]->m_xoffset;
-				charInfo.yoffset = chars[n]->m_yoffset;
-				charInfo.xadvance = chars[n]->m_advance;
-				charInfo.page = page;
-				charInfo.channel = chnl;
-
-				fwrite(&charInfo, sizeof(charInfo), 1, f);
-			}
+			charInfo.id = n;
+			charInfo.x  = ch->m_x;
+			charInfo.y  = ch->m_y;
+			charInfo.width = ch->m_width;
+			charInfo.height = ch->m_height;
+			charInfo.xoffset = ch->m_xoffset;
+			charInfo.yoffset = ch->m_yoffset;
+			charInfo.xadvance = ch->m_advance;
+			charInfo.page = page;
+			charInfo.channel = chnl;
+
+			fwrite(&charInfo, sizeof(charInfo), 1, f);
 		}
 	}
 
@@ -1849,111 +2915,7 @@ int CFontGen::SaveFont(const char *szFile)
 	{
 		// Save the kerning pairs as well
 		vector<KERNINGPAIR> pairs;
-		if( useUnicode )
-		{
-			// TODO: How do I obtain the kerning pairs for 
-			// the characters in the higher planes?
-
-			int num = GetKerningPairsW(dc, 0, 0);
-			if( num > 0 )
-			{
-				pairs.resize(num);
-				GetKerningPairsW(dc, num, &pairs[0]);
-			}
-		}
-		else
-		{
-			int num = GetKerningPairsA(dc, 0, 0);
-			if( num > 0 )
-			{
-				pairs.resize(num);
-				GetKerningPairsA(dc, num, &pairs[0]);
-			}
-		}
-	/*
-		{
-			pairs.resize(0);
-
-			// Build a list of all selected chars
-			vector<UINT> chars;
-			chars.reserve(GetNumCharsSelected());
-			for( UINT n = 0; n <= maxUnicodeChar; n++ )
-			{
-				if( selected[n] )
-				{
-					chars.push_back(n);
-					if( chars.size() == GetNumCharsSelected() )
-						break;
-				}
-			}
-
-			GetKerningPairsFromKERN(dc, pairs, chars);
-		}
-	*/
-		if( pairs.size() == 0 )
-		{
-			// Build a list of all selected chars
-			vector<UINT> chars;
-			chars.reserve(GetNumCharsSelected());
-			for( UINT n = 0; n <= maxUnicodeChar; n++ )
-			{
-				if( selected[n] )
-				{
-					chars.push_back(n);
-					if( chars.size() == GetNumCharsSelected() )
-						break;
-				}
-			}
-
-			GetKerningPairsFromGPOS(dc, pairs, chars);
-		}
-
-		if( pairs.size() > 0 )
-		{
-			// It's been reported that for Chinese WinXP the kerning pairs for 
-			// non-unicode charsets may contain characters > 255, so we need to 
-			// filter for this.
-			for( unsigned int n = 0; n < pairs.size(); n++ )
-			{
-				if( pairs[n].iKernAmount/aa == 0 ||       // Filter kerning pairs where the adjustment is too small
-					pairs[n].wFirst >= maxChars ||        // Filter kerning pairs if they are outside the valid range
-					pairs[n].wSecond >= maxChars ||
-					disabled[pairs[n].wFirst] ||          // Filter kerning pairs for characters that won't be exported
-					disabled[pairs[n].wSecond] ||
-					!selected[pairs[n].wFirst] ||         // Filter kerning pairs for characters that won't be exported
-					!selected[pairs[n].wSecond] ||
-					chars[pairs[n].wFirst] == 0 ||        // Filter kerning pairs for characters that won't be exported
-					chars[pairs[n].wSecond] == 0 ||
-					!chars[pairs[n].wFirst]->m_isChar ||  // Filter kerning pairs for imported images
-					!chars[pairs[n].wSecond]->m_isChar )
-				{
-					pairs[n] = pairs[pairs.size()-1];
-					pairs.pop_back();
-					n--;
-				}
-			}
-
-			// The list of kerning pairs returned by GetKerningPairs sometimes also 
-			// have duplicates, so that needs to be filtered too. It seems to be a bug 
-			// when calling GetKerningPairsA but not for W.
-			// TODO: Sometimes the adjustment is not equal for the duplicates, which should be used then?
-			if( !useUnicode )
-			{
-				for( unsigned int n = 0; n < pairs.size(); n++ )
-				{
-					for( unsigned int m = n+1; m < pairs.size(); m++ )
-					{
-						if( pairs[n].wFirst  == pairs[m].wFirst  &&
-							pairs[n].wSecond == pairs[m].wSecond )
-						{
-							pairs[m] = pairs[pairs.size()-1];
-							pairs.pop_back();
-							m--;
-						}
-					}
-				}
-			}
-		}
+		GetKerningPairs(backend, pairs);
 
 		if( pairs.size() > 0 )
 		{
@@ -1975,9 +2937,9 @@ int CFontGen::SaveFont(const char *szFile)
 		for( unsigned int n = 0; n < pairs.size(); n++ )
 		{
 			if( fontDescFormat == 1 )
-				fprintf(f, "    <kerning first=\"%d\" second=\"%d\" amount=\"%d\" />\r\n", pairs[n].wFirst, pairs[n].wSecond, pairs[n].iKernAmount/aa);
+				fprintf(f, "    <kerning first=\"%d\" second=\"%d\" amount=\"%d\" />\r\n", pairs[n].wFirst, pairs[n].wSecond, pairs[n].iKernAmount);
 			else if( fontDescFormat == 0 )
-				fprintf(f, "kerning first=%-3d second=%-3d amount=%-4d\r\n", pairs[n].wFirst, pairs[n].wSecond, pairs[n].iKernAmount/aa);
+				fprintf(f, "kerning first=%-3d second=%-3d amount=%-4d\r\n", pairs[n].wFirst, pairs[n].wSecond, pairs[n].iKernAmount);
 			else 
 			{
 #pragma pack(push)
@@ -1991,7 +2953,7 @@ int CFontGen::SaveFont(const char *szFile)
 #pragma pack(pop)
 				kerning.first = pairs[n].wFirst;
 				kerning.second = pairs[n].wSecond;
-				kerning.amount = pairs[n].iKernAmount/aa;
+				kerning.amount = pairs[n].iKernAmount;
 
 				fwrite(&kerning, sizeof(kerning), 1, f);
 			}
@@ -2005,10 +2967,10 @@ int CFontGen::SaveFont(const char *szFile)
 
 	fclose(f);
 
-	SelectObject(dc, oldFont);
-	DeleteObject(font);
+	delete backend;
 
-	DeleteDC(dc);
+	// Fonts that share the pages refer to the texture files by this name
+	savedFileName = filename;
 
 	// Save the image file
 	for( n = 0; n < (signed)pages.size(); n++ )
@@ -2016,8 +2978,8 @@ int CFontGen::SaveFont(const char *szFile)
 		string str = acStringFormat("%s_%0*d.%s", filename.c_str(), numDigits, n, textureFormat.c_str());
 
 		acImage::Image image;
-		image.width = outWidth;
-		image.height = outHeight;
+		image.width = pageWidth;
+		image.height = pageHeight;
 		if( outBitDepth == 32 )
 		{
 			image.pitch = image.width*4;
@@ -2038,11 +3000,11 @@ int CFontGen::SaveFont(const char *szFile)
 		if( outBitDepth == 8 )
 		{
 			// Write image data
-			for( int y = 0; y < outHeight; y++ )
+			for( int y = 0; y < pageHeight; y++ )
 			{
-				for( int x = 0; x < outWidth; x++ )
+				for( int x = 0; x < pageWidth; x++ )
 				{
-					DWORD pixel = page->pixels[y*outWidth + x];
+					DWORD pixel = page->pixels[y*pageWidth + x];
 					image.data[y*image.pitch + x] = (BYTE)(pixel>>24);
 				}
 			}
@@ -2050,11 +3012,11 @@ int CFontGen::SaveFont(const char *szFile)
 		else
 		{
 			// Write image data
-			for( int y = 0; y < outHeight; y++ )
+			for( int y = 0; y < pageHeight; y++ )
 			{
-				for( int x = 0; x < outWidth; x++ )
+				for( int x = 0; x < pageWidth; x++ )
 				{
-					DWORD pixel = page->pixels[y*outWidth + x];
+					DWORD pixel = page->pixels[y*pageWidth + x];
 					*(DWORD*)&image.data[y*image.pitch + x*4] = pixel;
 				}
 			}
@@ -2098,9 +3060,14 @@ int CFontGen::SaveConfiguration(const char *szFile)
 	// Determine relative path to save the font file
 	string tmp = acUtility::GetRelativePath(filename, fontFile);
 	fprintf(f, "fontFile=%s\n", tmp.c_str());
+	fprintf(f, "fontBackend=%s\n", GetFontBackendName(fontBackend));
 
 	fprintf(f, "charSet=%d\n", charSet);
-	fprintf(f, "fontSize=%d\n", fontSize);
+	fprintf(f, "fontSize=");
+	for( size_t n = 0; n < fontSizes.size(); n++ )
+		fprintf(f, n ? ",%d" : "%d", fontSizes[n]);
+	fprintf(f, "\n");
+	fprintf(f, "sharedAtlas=%d\n", sharedAtlas);
 	fprintf(f, "aa=%d\n", aa);
 	fprintf(f, "scaleH=%d\n", scaleH);
 	fprintf(f, "useSmoothing=%d\n", useSmoothing);
@@ -2140,9 +3107,23 @@ int CFontGen::SaveConfiguration(const char *szFile)
 	fprintf(f, "invR=%d\n", invR);
 	fprintf(f, "invG=%d\n", invG);
 	fprintf(f, "invB=%d\n", invB);
+	fprintf(f, "autoSize=%d\n", autoSize);
+	fprintf(f, "autoSizeMaxPages=%d\n", autoSizeMaxPages);
+	fprintf(f, "autoSizePowerOf2=%d\n", autoSizePowerOf2);
 
 	fprintf(f, "\n# outline\n");
 	fprintf(f, "outlineThickness=%d\n", outlineThickness);
+	fprintf(f, "outlineMethod=%s\n", GetOutlineMethodName(outlineMethod));
+
+	fprintf(f, "\n# distance field\n");
+	fprintf(f, "distanceField=%s\n", GetDistanceFieldName(distanceField));
+	fprintf(f, "distanceFieldSpread=%d\n", distanceFieldSpread);
+
+	fprintf(f, "\n# generation\n");
+	fprintf(f, "threads=%d\n", numThreads);
+	fprintf(f, "packer=%s\n", GetPackerName(packer));
+	tmp = acUtility::GetRelativePath(filename, glyphCacheDir);
+	fprintf(f, "glyphCacheDir=%s\n", tmp.c_str());
 
 	fprintf(f, "\n# selected chars\n");
 	
@@ -2150,9 +3131,9 @@ int CFontGen::SaveConfiguration(const char *szFile)
 	int lastChar = -1;
 	bool isRange = false;
 	int lineLength = 0;
-	for( int n = 0; n < maxChars; n++ )
+	for( int n = selected.Next(0); n >= 0 && n < maxChars; n = selected.Next(n+1) )
 	{
-		if( selected[n] && !disabled[n] )
+		if( !disabled.Get(n) )
 		{
 			// Is this the first char on the line?
 			if( lastChar == -1 )
@@ -2169,7 +3150,7 @@ int CFontGen::SaveConfiguration(const char *szFile)
 					isRange = true;
 				}
 				// Is this the last char in the range?
-				if( n+1 == maxChars || !selected[n+1] || disabled[n+1] )
+				if( n+1 == maxChars || !selected.Get(n+1) || disabled.Get(n+1) )
 				{
 					lineLength += fprintf(f, "%d", n);
 					isRange = false;
@@ -2218,13 +3199,15 @@ int CFontGen::LoadConfiguration(const char *filename)
 	int    _fileVersion;            config.GetAttrAsInt("fileVersion", _fileVersion);
 	string _fontName;               config.GetAttrAsString("fontName", _fontName, 0, "Arial");
 	string _fontFile;               config.GetAttrAsString("fontFile", _fontFile, 0, "");
+	string _fontBackend;            config.GetAttrAsString("fontBackend", _fontBackend, 0, GetFontBackendName(GetDefaultFontBackend()));
 
 	// Determine the full path for the font file
 	if( _fontFile != "" )
 		_fontFile = acUtility::GetFullPath(filename, _fontFile);
 
 	int    _charSet;                config.GetAttrAsInt("charSet", _charSet, 0, ANSI_CHARSET);
-	int    _fontSize;               config.GetAttrAsInt("fontSize", _fontSize, 0, 32);
+	string _fontSize;               config.GetAttrAsString("fontSize", _fontSize, 0, "32");
+	bool   _sharedAtlas;            config.GetAttrAsBool("sharedAtlas", _sharedAtlas, 0, false);
 	int    _aa;                     config.GetAttrAsInt("aa", _aa, 0, 1);
 	int    _scaleH;                 config.GetAttrAsInt("scaleH", _scaleH, 0, 100);
 	bool   _useSmoothing;           config.GetAttrAsBool("useSmoothing", _useSmoothing, 0, true);
@@ -2260,9 +3243,35 @@ int CFontGen::LoadConfiguration(const char *filename)
 	bool   _invR;                   config.GetAttrAsBool("invR", _invR, 0, false);
 	bool   _invG;                   config.GetAttrAsBool("invG", _invG, 0, false);
 	bool   _invB;                   config.GetAttrAsBool("invB", _invB, 0, false);
+	bool   _autoSize;               config.GetAttrAsBool("autoSize", _autoSize, 0, false);
+	int    _autoSizeMaxPages;       config.GetAttrAsInt("autoSizeMaxPages", _autoSizeMaxPages, 0, 1);
+	bool   _autoSizePowerOf2;       config.GetAttrAsBool("autoSizePowerOf2", _autoSizePowerOf2, 0, true);
+	int    _numThreads;             config.GetAttrAsInt("threads", _numThreads, 0, 0);
+	string _packer;                 config.GetAttrAsString("packer", _packer, 0, "skyline");
+	string _glyphCacheDir;          config.GetAttrAsString("glyphCacheDir", _glyphCacheDir, 0, "");
+	string _outlineMethod;          config.GetAttrAsString("outlineMethod", _outlineMethod, 0, "kernel");
+	string _distanceField;          config.GetAttrAsString("distanceField", _distanceField, 0, "none");
+	int    _distanceFieldSpread;    config.GetAttrAsInt("distanceFieldSpread", _distanceFieldSpread, 0, 4);
+
+	// The font size can be a list of sizes to generate from the same configuration
+	vector<int> _fontSizes;
+	const char *s = _fontSize.c_str();
+	for(;;)
+	{
+		char *e;
+		int size = strtol(s, &e, 10);
+		if( e == s ) break;
+		if( size != 0 && find(_fontSizes.begin(), _fontSizes.end(), size) == _fontSizes.end() )
+			_fontSizes.push_back(size);
+		s = e;
+		while( *s == ' ' || *s == '\t' ) s++;
+		if( *s != ',' ) break;
+		s++;
+	}
+	if( _fontSizes.empty() )
+		_fontSizes.push_back(32);
 
-	static bool _selected[maxUnicodeChar+1];
-	memset(_selected, 0, sizeof(_selected));
+	CCharSet _selected;
 
 	for( int n = 0; n < config.GetAttrCount("chars"); n++ )
 	{
@@ -2277,10 +3286,10 @@ int CFontGen::LoadConfiguration(const char *filename)
 			{
 				int lastChar = strtol(c+1, &c, 10);
 				for( int n = firstChar; n <= lastChar; n++ )
-					_selected[n] = true;
+					_selected.Set(n, true);
 			}
 			else
-				_selected[firstChar] = true;
+				_selected.Set(firstChar, true);
 
 			if( *c == ',' ) c++;
 		}
@@ -2340,6 +3349,18 @@ int CFontGen::LoadConfiguration(const char *filename)
 	if( _outHeight < 1 ) _outHeight = 1;
 	if( _outBitDepth != 8 && _outBitDepth != 32 ) _outBitDepth = 8;
 	if( _fontDescFormat < 0 || _fontDescFormat > 2 ) _fontDescFormat = 0;
+	if( _numThreads < 0 ) _numThreads = 0;
+	int packerType = GetPackerFromName(_packer.c_str());
+	if( packerType < 0 ) packerType = e_packerSkyline;
+	int outlineMethodType = GetOutlineMethodFromName(_outlineMethod.c_str());
+	if( outlineMethodType < 0 ) outlineMethodType = e_outlineKernel;
+	int distanceFieldType = GetDistanceFieldFromName(_distanceField.c_str());
+	if( distanceFieldType < 0 ) distanceFieldType = e_distanceFieldNone;
+	int fontBackendType = GetFontBackendFromName(_fontBackend.c_str());
+	if( fontBackendType < 0 || !IsFontBackendAvailable(fontBackendType) ) fontBackendType = GetDefaultFontBackend();
+	if( _distanceFieldSpread < 1 ) _distanceFieldSpread = 1;
+	if( _glyphCacheDir != "" )
+		_glyphCacheDir = acUtility::GetFullPath(filename, _glyphCacheDir);
     
 	pos = _textureFormat.find_last_not_of(" \t\n\r");
 	if( pos != string::npos ) _textureFormat.erase(pos + 1);
@@ -2371,8 +3392,10 @@ int CFontGen::LoadConfiguration(const char *filename)
 	// Set the properties
 	SetFontName(_fontName);
 	SetFontFile(_fontFile);
+	SetFontBackend(fontBackendType);
 	SetCharSet(_charSet);
-	SetFontSize(_fontSize);
+	SetFontSizes(_fontSizes);
+	SetSharedAtlas(_sharedAtlas);
 	SetAntiAliasingLevel(_aa);
 	SetScaleHeight(_scaleH);
 	SetUseSmoothing(_useSmoothing);
@@ -2400,6 +3423,9 @@ int CFontGen::LoadConfiguration(const char *filename)
 	SetTextureFormat(_textureFormat);
 	SetTextureCompression(_textureCompression);
 	SetOutlineThickness(_outlineThickness);
+	SetOutlineMethod(outlineMethodType);
+	SetDistanceField(distanceFieldType);
+	SetDistanceFieldSpread(_distanceFieldSpread);
 	SetAlphaChnl(_alphaChnl);
 	SetRedChnl(_redChnl);
 	SetGreenChnl(_greenChnl);
@@ -2408,23 +3434,26 @@ int CFontGen::LoadConfiguration(const char *filename)
 	SetRedInverted(_invR);
 	SetGreenInverted(_invG);
 	SetBlueInverted(_invB);
+	SetAutoSize(_autoSize);
+	SetAutoSizeMaxPages(_autoSizeMaxPages);
+	SetAutoSizePowerOf2(_autoSizePowerOf2);
+	SetNumThreads(_numThreads);
+	SetPacker(packerType);
+	SetGlyphCacheDir(_glyphCacheDir);
 
 	Prepare();
 
+	ClearAll();
 	int maxChars = useUnicode ? maxUnicodeChar+1 : 256;
-	for( int n = 0; n < maxChars; n++ )
-		SetSelected(n, _selected[n]);
+	for( int n = _selected.Next(0); n >= 0 && n < maxChars; n = _selected.Next(n+1) )
+		SetSelected(n, true);
 
 	return 0;
 }
 
 int CFontGen::GetNumFailedChars()
 {
-	int numFailed = 0;
-	for( int n = 0; n < maxUnicodeChar+1; n++ )
-		if( noFit[n] ) numFailed++;
-
-	return numFailed;
+	return noFit.GetCount();
 }
 
 int CFontGen::SelectCharsFromFile(const char *filename)
@@ -2435,7 +3464,7 @@ int CFontGen::SelectCharsFromFile(const char *filename)
 	errno_t e = fopen_s(&f, filename, "rb");
 	if( e != 0 || f == 0 ) return -1;
 
-	memset(noFit, 0, sizeof(noFit));
+	noFit.SetAll(false);
 
 	if( IsUsingUnicode() )
 	{
@@ -2477,7 +3506,7 @@ int CFontGen::SelectCharsFromFile(const char *filename)
 				if( utf8 )
 					value = acUtility::DecodeUTF8(buf+n, &len);
 				else
-					value = acUtility::DecodeUTF16(buf+n, &len, utf16_littleEndian ? acUtility::LITTLE_ENDIAN : acUtility::BIG_ENDIAN);
+					value = acUtility::DecodeUTF16(buf+n, &len, utf16_littleEndian ? acUtility::UTF16_LITTLE_ENDIAN : acUtility::UTF16_BIG_ENDIAN);
 
 				if( value >= 0 )
 				{
@@ -2486,7 +3515,7 @@ int CFontGen::SelectCharsFromFile(const char *filename)
 					{
 						// Control characters are not visible
 						if( value >= 32 && value != 0xFEFF )
-							noFit[value] = true;
+							noFit.Set(value, true);
 					}
 				}
 				else
@@ -2520,7 +3549,7 @@ int CFontGen::SelectCharsFromFile(const char *filename)
 			for( UINT n = 0; n < cnt; n++ )
 			{
 				if( SetSelected(buf[n], true) < 0 )
-					noFit[buf[n]] = true;
+					noFit.Set(buf[n], true);
 			}
 	}
 
@@ -2539,17 +3568,11 @@ int CFontGen::FindNextFailedCharacterSubset(int startSubset)
 			startSubset = 0;
 
 		int startChar = subsets[startSubset]->charBegin;
-		for( int n = startChar; n < maxUnicodeChar+1; n++ )
-		{
-			if( noFit[n] )
-				return SubsetFromChar(n);
-		}
-
-		for( int n = 0; n <= startChar; n++ )
-		{
-			if( noFit[n] )
-				return SubsetFromChar(n);
-		}
+		int n = noFit.Next(startChar);
+		if( n < 0 )
+			n = noFit.Next(0);
+		if( n >= 0 )
+			return SubsetFromChar(n);
 	}
 
 	return 0;
@@ -2581,5 +3604,5 @@ int CFontGen::SubsetFromChar(int ch)
 
 void CFontGen::ClearFailedCharacters()
 {
-	memset(noFit, 0, sizeof(noFit));
+	noFit.SetAll(false);
 }
\ No newline at end of file
@@ -28,17 +28,26 @@
 #ifndef FONTGEN_H
 #define FONTGEN_H
 
-#include <windows.h>
+#include "platform.h"
 
 #include <string>
 using std::string;
 #include <vector>
 using std::vector;
+#include <atomic>
 
 #include "fontpage.h"
+#include "chartable.h"
+#include "acutil_threadpool.h"
+#include "glyphcache.h"
+#include "fontbackend.h"
 
 static const int maxUnicodeChar = 0x10FFFF;
 class CFontChar;
+class CFontCache;
+class CFontBackend;
+struct SRasterContext;
+struct SGenerateTask;
 
 struct SSubset
 {
@@ -85,6 +94,12 @@ public:
 	// Generate font pages asynchronously
 	int     GeneratePages(bool async = true);
 	void    Abort();
+
+	// Draws the characters without placing them on the pages, so the next 
+	// GeneratePages only packs them. This lets an atlas owner draw its 
+	// characters at the same time as the fonts that share its pages.
+	int     DrawChars();
+
 	int     GetStatus();
 	int     GetStatusCounter();
 	int     GetError();
@@ -124,6 +139,7 @@ public:
 	// Font properties
 	string  GetFontName() const;           int SetFontName(const string &name);
 	string  GetFontFile() const;           int SetFontFile(const string &file);
+	int     GetFontBackend() const;        int SetFontBackend(int backend);
 	int     GetCharSet() const;            int SetCharSet(int charSet);
 	int     GetFontSize() const;           int SetFontSize(int fontSize);
 	bool    IsBold() const;                int SetBold(bool set);
@@ -135,6 +151,13 @@ public:
 	bool    GetUseHinting() const;         int SetUseHinting(bool set);
 	bool    GetUseClearType() const;       int SetUseClearType(bool set);
 
+	// Several sizes can be generated from one configuration, see CFontBatch. The 
+	// pages are generated for the first size, which is also the one returned by 
+	// GetFontSize. SetFontSize replaces the list with a single size. The sizes 
+	// can share the same pages, see SetAtlasOwner.
+	vector<int> GetFontSizes() const;      int SetFontSizes(const vector<int> &sizes);
+	bool    GetSharedAtlas() const;        int SetSharedAtlas(bool set);
+
 	// Character padding and spacing
 	int     GetPaddingDown() const;        int SetPaddingDown(int pad);
 	int     GetPaddingUp() const;          int SetPaddingUp(int pad);
@@ -163,19 +186,69 @@ public:
 	bool    IsGreenInverted() const;       int SetGreenInverted(bool set);
 	bool    IsBlueInverted() const;        int SetBlueInverted(bool set);
 
+	// Search for the smallest texture size that holds the characters. The 
+	// outWidth and outHeight are then used as the largest allowed size.
+	bool    GetAutoSize() const;           int SetAutoSize(bool set);
+	int     GetAutoSizeMaxPages() const;   int SetAutoSizeMaxPages(int maxPages);
+	bool    GetAutoSizePowerOf2() const;   int SetAutoSizePowerOf2(bool set);
+
 	// Outline
 	int     GetOutlineThickness() const;   int SetOutlineThickness(int thickness);
 
+	// How the outline is computed, see EOutlineMethod
+	int     GetOutlineMethod() const;      int SetOutlineMethod(int method);
+
+	// Distance field, see EDistanceField. The spread is the distance in 
+	// pixels that the field covers on each side of the glyph edges. The 
+	// outline is not used with distance fields
+	int     GetDistanceField() const;      int SetDistanceField(int type);
+	int     GetDistanceFieldSpread() const; int SetDistanceFieldSpread(int spread);
+
+	// Number of threads used for generating the pages, 0 means one per hardware thread
+	int     GetNumThreads() const;         int SetNumThreads(int threads);
+
+	// Algorithm used for placing the characters on the pages, see EPackerType
+	int     GetPacker() const;             int SetPacker(int packer);
+
+	// Directory where the drawn glyphs are cached between runs, empty to disable
+	string  GetGlyphCacheDir() const;      int SetGlyphCacheDir(const string &dir);
+
+	// Share the worker threads and the font data with other generators, e.g. 
+	// when generating a batch of fonts. The shared thread pool is used instead 
+	// of starting threads according to SetNumThreads. It must already be started, 
+	// as the generators may add tasks to it at the same time. Set null to stop sharing.
+	acUtility::CThreadPool *GetThreadPool() const; int SetThreadPool(acUtility::CThreadPool *pool);
+	CFontCache *GetFontCache() const;      int SetFontCache(CFontCache *cache);
+
+	// Places the characters on the pages of another generator, so several fonts, 
+	// e.g. the sizes of the same font, share the textures. This generator only 
+	// draws the characters, and they are placed on the pages when the owner 
+	// generates its pages afterwards. The owner must be saved first, as the font 
+	// descriptor refers to the owner's texture files. Set null to stop sharing.
+	CFontGen *GetAtlasOwner() const;       int SetAtlasOwner(CFontGen *owner);
+
 	// Call this after updating the font properties
 	int     Prepare();
 
+#ifdef _WIN32
 	// A helper function for creating the font object
-	HFONT   CreateFont(int fontSize);
+	HFONT   CreateFont(int fontSize) const;
+#endif
 
 	// Visualize pages
 	int     GetNumPages();
 	cImage *GetPageImage(int page, int channel);
 
+	// Size of the generated textures and how much of them the characters cover
+	int     GetPageWidth() const;
+	int     GetPageHeight() const;
+	float   GetFillRatio();
+
+	// Packing efficiency of each page, and the total time spent placing 
+	// the characters in milliseconds, including the texture size search
+	int     GetPageStats(int page, SPageStats &stats);
+	double  GetPackingTime() const;
+
 	// Save the font to disk
 	int     SaveFont(const char *filename);
 
@@ -186,23 +259,43 @@ public:
 
 protected:
 	friend class CFontPage;
+	friend class CSkylinePacker;
+	friend class CMaxRectsPacker;
+	friend class CFontCache;
 
 	void ResetFont();
 	void ClearPages();
+	void ClearGlyphCache();
+	string GetGlyphCacheKey() const;
+	void LoadCachedGlyphs(CGlyphCacheFile &cacheFile, vector<int> &charList);
+	void SaveCachedGlyphs(CGlyphCacheFile &cacheFile, const vector<int> &charList);
 	int  CreatePage();
 	void ClearSubsets();
 	void DetermineExistingChars();
+	void GetKerningPairs(CFontBackend *backend, vector<KERNINGPAIR> &pairs);
+	int  ScanExistingChars(CCharSet &existing) const;
 
 	static void __cdecl GenerateThread(CFontGen *fontGen);
 	void InternalGeneratePages();
 
+	// Parallel drawing of the characters
+	static void GenerateTask(void *arg, int worker);
+	void RunGenerateTask(SGenerateTask *task, int worker);
+	int  CreateRasterContext(SRasterContext &ctx);
+	void FreeRasterContext(SRasterContext &ctx);
+
+	// Search for the texture size when autoSize is set
+	void FindAutoSize(const vector<CFontChar*> &chars);
+	static void AutoSizeTask(void *arg, int worker);
+	int  TrialPack(int width, int height, const vector<CFontChar*> &chars, int maxPages);
+
 	bool fontChanged;
 
-	bool isWorking;
-	bool stopWorking;
-	int  status;
-	bool outOfMemory;
-	int  counter;
+	bool              isWorking;
+	std::atomic<bool> stopWorking;
+	int               status;
+	std::atomic<bool> outOfMemory;
+	std::atomic<int>  counter;
 	bool disableBoxChars;
 	bool outputInvalidCharGlyph;
 	bool arePagesGenerated;
@@ -211,8 +304,12 @@ protected:
 	// Font properties
 	string fontName;
 	string fontFile;
+	int    fontBackend;
 	int    charSet;
 	int    fontSize;
+	vector<int> fontSizes;
+	bool   sharedAtlas;
+	bool   drawOnly;
 	int    aa;
 	int    scaleH;
 	bool   useSmoothing;
@@ -249,22 +346,67 @@ protected:
 	bool   invR;
 	bool   invG;
 	bool   invB;
+	bool   autoSize;
+	int    autoSizeMaxPages;
+	bool   autoSizePowerOf2;
+
+	// Actual size of the textures, which is the outWidth and 
+	// outHeight unless the size is determined automatically
+	int    pageWidth;
+	int    pageHeight;
+	double packingTime;
 
 	// Outline
 	int    outlineThickness;
+	int    outlineMethod;
+
+	// Distance field
+	int    distanceField;
+	int    distanceFieldSpread;
+
+	// Generation
+	int    numThreads;
+	int    packer;
+	string glyphCacheDir;
 
 	// Characters
 	int  numCharsSelected;
 	int  numCharsAvailable;
-	bool disabled[maxUnicodeChar+1];
-	bool selected[maxUnicodeChar+1];
-	bool noFit[maxUnicodeChar+1];
-	CFontChar *chars[maxUnicodeChar+1];
+	CCharSet   disabled;
+	CCharSet   selected;
+	CCharSet   noFit;
+	CCharTable chars;
 	CFontChar *invalidCharGlyph;
 
+	// Glyphs drawn in earlier generations, which are reused as long as 
+	// the settings that affect the drawing stay the same. The glyphs are 
+	// shared with the chars table while the pages are generated.
+	CCharTable glyphCache;
+	string     glyphCacheKey;
+
 	// Font textures
 	vector<CFontPage *> pages;
 
+	// Worker threads for generating the pages. The threadPool 
+	// points to the ownThreadPool unless a shared one is used. The 
+	// taskGroup lets the generator wait for only its own tasks.
+	acUtility::CThreadPool     ownThreadPool;
+	acUtility::CThreadPool    *threadPool;
+	acUtility::CTaskGroup      taskGroup;
+	vector<SRasterContext *>   rasterContexts;
+
+	// The glyphs of the characters that are drawn, shared by the worker threads
+	CGlyphMap                  glyphMap;
+
+	// Font data shared with other generators
+	CFontCache *fontCache;
+
+	// The generator whose pages hold the characters of this one, or 
+	// the generators whose characters are placed on these pages
+	CFontGen          *atlasOwner;
+	vector<CFontGen *> atlasFonts;
+	string             savedFileName;
+
 	// Icon images
 	vector<SIconImage *> iconImages;
 
@@ -0,0 +1,137 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <algorithm>
+#include <string.h>
+
+#include "fontpacker.h"
+#include "fontpage.h"
+#include "fontchar.h"
+#include "fontgen.h"
+
+using namespace std;
+
+static const char *packerNames[e_numPackers] = 
+{
+	"skyline",
+	"maxrects",
+	"maxrects_contact"
+};
+
+const char *GetPackerName(int packer)
+{
+	if( packer < 0 || packer >= e_numPackers )
+		return packerNames[e_packerSkyline];
+
+	return packerNames[packer];
+}
+
+int GetPackerFromName(const char *name)
+{
+	for( int n = 0; n < e_numPackers; n++ )
+	{
+		if( _stricmp(name, packerNames[n]) == 0 )
+			return n;
+	}
+
+	return -1;
+}
+
+CFontPacker *CFontPacker::Create(int packer, CFontPage *page)
+{
+	switch( packer )
+	{
+	case e_packerMaxRects:
+		return new (std::nothrow) CMaxRectsPacker(page, false);
+	case e_packerMaxRectsContact:
+		return new (std::nothrow) CMaxRectsPacker(page, true);
+	}
+
+	return new (std::nothrow) CSkylinePacker(page);
+}
+
+CFontPacker::CFontPacker(CFontPage *page)
+{
+	this->page = page;
+	gen = page->gen;
+
+	width    = page->width;
+	height   = page->height;
+	spacingH = page->spacingH;
+	spacingV = page->spacingV;
+
+	paddingRight = page->paddingRight;
+	paddingLeft  = page->paddingLeft;
+	paddingUp    = page->paddingUp;
+	paddingDown  = page->paddingDown;
+
+	numChannels = (page->bitDepth == 32 && page->fourChnlPacked) ? 4 : 1;
+}
+
+CFontPacker::~CFontPacker()
+{
+}
+
+void CFontPacker::PlaceChar(int x, int y, CFontChar *ch, int channel)
+{
+	page->AddChar(x, y, ch, channel);
+}
+
+int CFontPacker::GetCellWidth(CFontChar *ch)
+{
+	return ch->m_charImg->width + paddingLeft + paddingRight + spacingH;
+}
+
+int CFontPacker::GetCellHeight(CFontChar *ch)
+{
+	return ch->m_charImg->height + paddingUp + paddingDown + spacingV;
+}
+
+// Comparison functor for the sorting algorithm. The list of characters is held 
+// by the functor rather than a global variable so multiple generators can sort 
+// their lists at the same time.
+struct SCompareCharSize
+{
+	SCompareCharSize(CFontChar **chars) : chars(chars) {}
+
+	bool operator()(int a, int b) const
+	{
+		// We want to sort the characters from larger to smaller
+		if( chars[a]->m_height > chars[b]->m_height ||
+		    (chars[a]->m_height == chars[b]->m_height &&
+		     chars[a]->m_width > chars[b]->m_width) )
+			return true;
+		return false;
+	}
+
+	CFontChar **chars;
+};
+
+void CFontPacker::SortList(CFontChar **chars, int *index, int numChars)
+{
+	std::sort(index, index + numChars, SCompareCharSize(chars));
+}
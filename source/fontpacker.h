@@ -0,0 +1,199 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef FONTPACKER_H
+#define FONTPACKER_H
+
+#include <vector>
+#include <map>
+
+class CFontChar;
+class CFontGen;
+class CFontPage;
+
+// The packers that can be used to place the characters on the pages
+enum EPackerType
+{
+	e_packerSkyline,
+	e_packerMaxRects,
+	e_packerMaxRectsContact,
+	e_numPackers
+};
+
+// Names used for the packers in the font configuration file
+const char *GetPackerName(int packer);
+int         GetPackerFromName(const char *name);
+
+// A packer decides where the characters are placed on a page. It is created 
+// for the page when the characters are added to it, and then discarded.
+class CFontPacker
+{
+public:
+	static CFontPacker *Create(int packer, CFontPage *page);
+	virtual ~CFontPacker();
+
+	// Returns false if the packer couldn't allocate its memory
+	virtual bool IsOK() = 0;
+
+	// Adds as many of the characters as possible to the page. The 
+	// characters that were added are set to null in the list.
+	virtual void AddChars(CFontChar **chars, int count) = 0;
+
+protected:
+	CFontPacker(CFontPage *page);
+
+	void    PlaceChar(int x, int y, CFontChar *ch, int channel);
+	void    SortList(CFontChar **chars, int *indices, int count);
+
+	// The space taken by the character on the page, including padding and spacing
+	int     GetCellWidth(CFontChar *ch);
+	int     GetCellHeight(CFontChar *ch);
+
+	CFontPage *page;
+	CFontGen  *gen;
+
+	int     width;
+	int     height;
+	int     spacingH;
+	int     spacingV;
+
+	int     paddingRight;
+	int     paddingLeft;
+	int     paddingUp;
+	int     paddingDown;
+
+	// Each channel is a separate packing area when packing 
+	// the monochrome characters in the four channels
+	int     numChannels;
+};
+
+struct SHole
+{
+	int x;
+	int y;
+	int w;
+	int h;
+	int chnl;
+};
+
+// Index of the holes, i.e. the free space that is left below the skyline. The 
+// holes are kept in buckets by height, and ordered by width within each bucket, 
+// so the best fitting hole can be found without looking at all of them.
+class CHoleIndex
+{
+public:
+	CHoleIndex();
+
+	void    Clear();
+	void    Add(const SHole &hole);
+	int     GetCount() const;
+
+	// Finds the hole with the smallest height, and then the smallest 
+	// width, that can fit the rectangle. The hole is removed from the index.
+	bool    TakeBestFit(int w, int h, SHole &hole);
+
+protected:
+	typedef std::multimap<int, SHole> widthMap_t;
+	std::map<int, widthMap_t> buckets;
+	int     count;
+};
+
+// A horizontal segment of the skyline, i.e. a range of x positions where 
+// the used space has the same height
+struct SSkylineSegment
+{
+	int x;
+	int w;
+	int y;
+};
+
+// The skyline packer keeps track of the height of the used space as a list 
+// of segments and places the characters in rows from left to right. Space that 
+// is left below the skyline is remembered as holes that are filled with the 
+// smaller characters.
+class CSkylinePacker : public CFontPacker
+{
+public:
+	CSkylinePacker(CFontPage *page);
+	~CSkylinePacker();
+
+	bool    IsOK();
+	void    AddChars(CFontChar **chars, int count);
+
+protected:
+	void    AddChar(int x, int y, CFontChar *ch, int channel);
+	int     AddChar(CFontChar *ch, int channel);
+	void    AddCharsToPage(CFontChar **ch, int count, bool colored, int channel);
+	int     GetNextIdealImageWidth();
+	int     DetermineStartX(CFontChar **ch, int *indices, int count, int channel);
+
+	int     FindSegment(int x, int channel);
+	int     GetHeight(int x, int channel);
+	int     GetMaxHeight(int x, int w, int channel);
+	void    RaiseSkyline(int x0, int x1, int y, int channel);
+	int     FindPosition(int from, int to, int w, int maxY, int channel);
+	int     FillHoles(CFontChar **chars, int *index, int numChars, int channel);
+
+	std::vector<SSkylineSegment> skyline[4];
+	int     currX;
+
+	CHoleIndex holes[4];
+};
+
+struct SRect
+{
+	int x;
+	int y;
+	int w;
+	int h;
+};
+
+// The MaxRects packer keeps a list of the maximal free rectangles on the page, 
+// that may overlap each other, and places each character in the free rectangle 
+// that gives the best score according to the chosen heuristic.
+class CMaxRectsPacker : public CFontPacker
+{
+public:
+	CMaxRectsPacker(CFontPage *page, bool contactPoint);
+
+	bool    IsOK();
+	void    AddChars(CFontChar **chars, int count);
+
+protected:
+	void    AddCharsToPage(CFontChar **chars, int count, bool colored, int channel);
+	bool    FindPosition(int w, int h, int channel, SRect &rect);
+	int     ContactScore(const SRect &rect, int channel);
+	void    PlaceRect(const SRect &rect, int channel);
+	void    PruneFreeRects(int channel, unsigned int firstNew);
+
+	bool    contactPoint;
+
+	std::vector<SRect> freeRects[4];
+	std::vector<SRect> usedRects[4];
+};
+
+#endif
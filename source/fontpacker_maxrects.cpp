@@ -0,0 +1,294 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <fstream>
+
+#include "fontpacker.h"
+#include "fontchar.h"
+#include "fontgen.h"
+
+using namespace std;
+
+#ifdef TRACE_GENERATE
+extern ofstream trace;
+#endif
+
+CMaxRectsPacker::CMaxRectsPacker(CFontPage *page, bool contactPoint) : CFontPacker(page)
+{
+	this->contactPoint = contactPoint;
+
+	// The whole page is free in the beginning
+	SRect rect;
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = width;
+	rect.h = height;
+	freeRects[0].push_back(rect);
+}
+
+bool CMaxRectsPacker::IsOK()
+{
+	return true;
+}
+
+void CMaxRectsPacker::AddChars(CFontChar **chars, int count)
+{
+#ifdef TRACE_GENERATE
+	trace << "Adding colored images\n";
+	trace.flush();
+#endif
+
+	// Add the colored images first, as they use all channels
+	AddCharsToPage(chars, count, true, 0);
+
+	// Check if we should stop
+	if( gen->stopWorking ) return;
+
+	// Each channel starts with the space that is left after the colored images
+	for( int n = 1; n < numChannels; n++ )
+	{
+		freeRects[n] = freeRects[0];
+		usedRects[n] = usedRects[0];
+	}
+
+	// Then the black & white images
+	for( int n = 0; n < numChannels; n++ )
+	{
+#ifdef TRACE_GENERATE
+		trace << "Adding monochrome images to channel " << n << "\n";
+		trace.flush();
+#endif
+
+		AddCharsToPage(chars, count, false, n);
+
+		// Check if we should stop
+		if( gen->stopWorking ) return;
+	}
+}
+
+void CMaxRectsPacker::AddCharsToPage(CFontChar **chars, int count, bool colored, int channel)
+{
+	vector<int> index;
+	for( int n = 0; n < count; n++ )
+	{
+		if( chars[n] && chars[n]->m_isChar != colored )
+			index.push_back(n);
+	}
+
+	if( index.size() == 0 )
+		return;
+
+#ifdef TRACE_GENERATE
+	trace << "Sorting list of " << index.size() << " candidates\n";
+	trace.flush();
+#endif
+
+	// Sort the characters by height/width, largest first
+	SortList(chars, &index[0], index.size());
+
+	for( unsigned int n = 0; n < index.size() && freeRects[channel].size(); n++ )
+	{
+		CFontChar *ch = chars[index[n]];
+
+		SRect rect;
+		if( !FindPosition(GetCellWidth(ch), GetCellHeight(ch), channel, rect) )
+			continue;
+
+		PlaceRect(rect, channel);
+		PlaceChar(rect.x, rect.y, ch, channel);
+		chars[index[n]] = 0;
+
+		// Check if we should stop
+		if( gen->stopWorking ) return;
+	}
+}
+
+bool CMaxRectsPacker::FindPosition(int w, int h, int channel, SRect &best)
+{
+	vector<SRect> &rects = freeRects[channel];
+
+	bool found = false;
+	int bestScore1 = 0, bestScore2 = 0;
+	for( unsigned int n = 0; n < rects.size(); n++ )
+	{
+		if( rects[n].w < w || rects[n].h < h )
+			continue;
+
+		SRect rect;
+		rect.x = rects[n].x;
+		rect.y = rects[n].y;
+		rect.w = w;
+		rect.h = h;
+
+		// A lower score is better
+		int score1, score2;
+		if( contactPoint )
+		{
+			// Maximize the length of the edges that touch other characters or the border
+			score1 = -ContactScore(rect, channel);
+			score2 = rect.y;
+		}
+		else
+		{
+			// Best short side fit, i.e. minimize the shortest leftover side of the free rectangle
+			int leftoverH = rects[n].w - w;
+			int leftoverV = rects[n].h - h;
+			score1 = leftoverH < leftoverV ? leftoverH : leftoverV;
+			score2 = leftoverH < leftoverV ? leftoverV : leftoverH;
+		}
+
+		// Ties are broken by the position so the result is deterministic
+		if( !found || score1 < bestScore1 || 
+			(score1 == bestScore1 && (score2 < bestScore2 || 
+			(score2 == bestScore2 && (rect.y < best.y || (rect.y == best.y && rect.x < best.x))))) )
+		{
+			best = rect;
+			bestScore1 = score1;
+			bestScore2 = score2;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+// Returns the length of the common part of the two intervals
+static int CommonIntervalLength(int start1, int end1, int start2, int end2)
+{
+	if( end1 < start2 || end2 < start1 )
+		return 0;
+
+	return (end1 < end2 ? end1 : end2) - (start1 > start2 ? start1 : start2);
+}
+
+int CMaxRectsPacker::ContactScore(const SRect &rect, int channel)
+{
+	int score = 0;
+
+	if( rect.x == 0 || rect.x + rect.w == width )
+		score += rect.h;
+	if( rect.y == 0 || rect.y + rect.h == height )
+		score += rect.w;
+
+	vector<SRect> &used = usedRects[channel];
+	for( unsigned int n = 0; n < used.size(); n++ )
+	{
+		if( used[n].x == rect.x + rect.w || used[n].x + used[n].w == rect.x )
+			score += CommonIntervalLength(used[n].y, used[n].y + used[n].h, rect.y, rect.y + rect.h);
+		if( used[n].y == rect.y + rect.h || used[n].y + used[n].h == rect.y )
+			score += CommonIntervalLength(used[n].x, used[n].x + used[n].w, rect.x, rect.x + rect.w);
+	}
+
+	return score;
+}
+
+void CMaxRectsPacker::PlaceRect(const SRect &used, int channel)
+{
+	vector<SRect> &rects = freeRects[channel];
+
+	// Split the free rectangles that intersect the used area into 
+	// the maximal rectangles that remain around the used area
+	vector<SRect> newRects;
+	for( unsigned int n = 0; n < rects.size(); n++ )
+	{
+		SRect free = rects[n];
+		if( used.x >= free.x + free.w || used.x + used.w <= free.x ||
+			used.y >= free.y + free.h || used.y + used.h <= free.y )
+			continue;
+
+		SRect r;
+		if( used.x > free.x )
+		{
+			r.x = free.x; r.y = free.y; r.w = used.x - free.x; r.h = free.h;
+			newRects.push_back(r);
+		}
+		if( used.x + used.w < free.x + free.w )
+		{
+			r.x = used.x + used.w; r.y = free.y; r.w = free.x + free.w - r.x; r.h = free.h;
+			newRects.push_back(r);
+		}
+		if( used.y > free.y )
+		{
+			r.x = free.x; r.y = free.y; r.w = free.w; r.h = used.y - free.y;
+			newRects.push_back(r);
+		}
+		if( used.y + used.h < free.y + free.h )
+		{
+			r.x = free.x; r.y = used.y + used.h; r.w = free.w; r.h = free.y + free.h - r.y;
+			newRects.push_back(r);
+		}
+
+		// Remove the free rectangle
+		rects[n] = rects.back();
+		rects.pop_back();
+		n--;
+	}
+
+	// Only the new rectangles need to be compared, as the 
+	// remaining ones were already pruned against each other
+	unsigned int numOld = rects.size();
+	for( unsigned int n = 0; n < newRects.size(); n++ )
+		rects.push_back(newRects[n]);
+	PruneFreeRects(channel, numOld);
+
+	usedRects[channel].push_back(used);
+}
+
+static bool IsContainedIn(const SRect &a, const SRect &b)
+{
+	return a.x >= b.x && a.y >= b.y && 
+	       a.x + a.w <= b.x + b.w && a.y + a.h <= b.y + b.h;
+}
+
+void CMaxRectsPacker::PruneFreeRects(int channel, unsigned int firstNew)
+{
+	vector<SRect> &rects = freeRects[channel];
+
+	// Remove the new rectangles that are fully contained in another rectangle. 
+	// The old rectangles can't be contained in the new ones, since the new 
+	// ones are parts of rectangles that were already pruned.
+	for( unsigned int n = firstNew; n < rects.size(); n++ )
+	{
+		bool contained = false;
+		for( unsigned int m = 0; m < rects.size(); m++ )
+		{
+			if( m == n ) continue;
+
+			if( IsContainedIn(rects[n], rects[m]) )
+			{
+				contained = true;
+				break;
+			}
+		}
+
+		if( contained )
+		{
+			rects.erase(rects.begin() + n);
+			n--;
+		}
+	}
+}
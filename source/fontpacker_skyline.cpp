@@ -0,0 +1,568 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <fstream>
+
+#include "fontpacker.h"
+#include "fontchar.h"
+#include "fontgen.h"
+
+using namespace std;
+
+#ifdef TRACE_GENERATE
+extern ofstream trace;
+#endif
+
+CSkylinePacker::CSkylinePacker(CFontPage *page) : CFontPacker(page)
+{
+	// In the beginning the skyline is a single segment at the top of the page
+	SSkylineSegment seg;
+	seg.x = 0;
+	seg.w = width;
+	seg.y = 0;
+	skyline[0].push_back(seg);
+
+	currX = 0;
+}
+
+CSkylinePacker::~CSkylinePacker()
+{
+}
+
+bool CSkylinePacker::IsOK()
+{
+	return true;
+}
+
+// Returns the index of the segment that covers the x position
+int CSkylinePacker::FindSegment(int x, int channel)
+{
+	vector<SSkylineSegment> &segs = skyline[channel];
+
+	// Binary search for the last segment that starts at or before x
+	int lo = 0, hi = (int)segs.size() - 1;
+	while( lo < hi )
+	{
+		int mid = (lo + hi + 1)/2;
+		if( segs[mid].x <= x )
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
+
+int CSkylinePacker::GetHeight(int x, int channel)
+{
+	return skyline[channel][FindSegment(x, channel)].y;
+}
+
+int CSkylinePacker::GetMaxHeight(int x, int w, int channel)
+{
+	vector<SSkylineSegment> &segs = skyline[channel];
+
+	int maxY = 0;
+	for( int n = FindSegment(x, channel); n < (int)segs.size() && segs[n].x < x + w; n++ )
+	{
+		if( segs[n].y > maxY )
+			maxY = segs[n].y;
+	}
+
+	return maxY;
+}
+
+// Adds the part to the end of the list, merging it with the last segment if it has the same height
+static void AppendSegment(vector<SSkylineSegment> &segs, int x, int w, int y)
+{
+	if( w <= 0 )
+		return;
+
+	if( segs.size() && segs.back().y == y )
+	{
+		segs.back().w += w;
+		return;
+	}
+
+	SSkylineSegment seg;
+	seg.x = x;
+	seg.w = w;
+	seg.y = y;
+	segs.push_back(seg);
+}
+
+// Raises the skyline to at least y between x0 and x1
+void CSkylinePacker::RaiseSkyline(int x0, int x1, int y, int channel)
+{
+	vector<SSkylineSegment> &segs = skyline[channel];
+
+	// Determine the segments that overlap the range, plus the 
+	// neighbours on each side so they can be merged if needed
+	int first = FindSegment(x0, channel);
+	int last = first;
+	while( last < (int)segs.size() && segs[last].x < x1 )
+		last++;
+	if( first > 0 ) first--;
+	if( last < (int)segs.size() ) last++;
+
+	// Split the segments at x0 and x1, and raise the part in between
+	vector<SSkylineSegment> result;
+	for( int n = first; n < last; n++ )
+	{
+		int start = segs[n].x;
+		int end   = segs[n].x + segs[n].w;
+		int y0    = segs[n].y;
+
+		int rangeStart = start > x0 ? start : x0;
+		int rangeEnd   = end < x1 ? end : x1;
+
+		if( rangeStart >= rangeEnd )
+		{
+			AppendSegment(result, start, end - start, y0);
+			continue;
+		}
+
+		AppendSegment(result, start, rangeStart - start, y0);
+		AppendSegment(result, rangeStart, rangeEnd - rangeStart, y0 > y ? y0 : y);
+		AppendSegment(result, rangeEnd, end - rangeEnd, y0);
+	}
+
+	segs.erase(segs.begin() + first, segs.begin() + last);
+	segs.insert(segs.begin() + first, result.begin(), result.end());
+}
+
+// Returns the first x position between from and to where a character with 
+// width w can be placed without the skyline being higher than maxY, or -1
+int CSkylinePacker::FindPosition(int from, int to, int w, int maxY, int channel)
+{
+	vector<SSkylineSegment> &segs = skyline[channel];
+
+	int x = from;
+	for( int n = FindSegment(from, channel); n < (int)segs.size(); n++ )
+	{
+		// A segment that is too high blocks all positions that overlap it
+		if( segs[n].y > maxY )
+		{
+			x = segs[n].x + segs[n].w;
+			if( x > to )
+				return -1;
+		}
+		else if( segs[n].x + segs[n].w >= x + w )
+			return x;
+	}
+
+	return -1;
+}
+
+void CSkylinePacker::AddChar(int cx, int cy, CFontChar *ch, int channel)
+{
+	PlaceChar(cx, cy, ch, channel);
+
+	// Update heights. The spacing to the left of the character wraps 
+	// around to the right side of the page if the character is at x = 0
+	CGlyphImage *img = ch->m_charImg;
+	int top = cy + img->height + spacingV + paddingUp + paddingDown;
+	int x0 = cx - spacingH;
+	int x1 = cx + img->width + paddingLeft + paddingRight + spacingH;
+	if( x0 < 0 )
+	{
+		RaiseSkyline(x0 + width, width, top, channel);
+		x0 = 0;
+	}
+	RaiseSkyline(x0, x1, top, channel);
+}
+
+int CSkylinePacker::AddChar(CFontChar *ch, int channel)
+{
+	CGlyphImage *img = ch->m_charImg;
+	int w = img->width + paddingLeft + paddingRight;
+	int maxX = width - spacingH - w;
+	int maxY = height - spacingV - (img->height + paddingUp + paddingDown);
+	if( maxX < 0 || maxY < 0 )
+		return -1;
+
+	// Find the first position, starting from currX, where the character 
+	// fits. If there is none, start from the left side again
+	int startX = currX <= maxX ? currX : 0;
+	int x = FindPosition(startX, maxX, w, maxY, channel);
+	if( x < 0 && startX > 0 )
+		x = FindPosition(0, startX - 1, w, maxY, channel);
+	if( x < 0 )
+		return -1;
+
+	int cy = GetMaxHeight(x, w, channel);
+
+	// Are we creating any holes? Each segment below the character 
+	// that is lower than the character leaves a hole of its own
+	vector<SSkylineSegment> &segs = skyline[channel];
+	for( int n = FindSegment(x, channel); n < (int)segs.size() && segs[n].x < x + w; n++ )
+	{
+		if( cy - spacingV > segs[n].y )
+		{
+			// The hole ends with the segment or the character, whichever is first
+			int end = segs[n].x + segs[n].w;
+			if( end > x + w ) end = x + w;
+
+			// If the next segment also leaves a hole, the spacing between 
+			// the characters that fill the two holes must be kept free
+			if( end < x + w && n + 1 < (int)segs.size() && cy - spacingV > segs[n+1].y )
+				end -= spacingH;
+
+			SHole hole;
+			hole.x    = segs[n].x > x ? segs[n].x : x;
+			hole.y    = segs[n].y;
+			hole.w    = end - hole.x;
+			hole.h    = cy - spacingV - hole.y;
+			hole.chnl = channel;
+			holes[channel].Add(hole);
+		}
+	}
+
+	AddChar(x, cy, ch, channel);
+
+	currX = x + w + spacingH;
+
+	return 0;
+}
+
+int CSkylinePacker::GetNextIdealImageWidth()
+{
+	return width - currX - paddingRight - paddingLeft - spacingH;
+}
+
+void CSkylinePacker::AddChars(CFontChar **chars, int maxChars)
+{
+#ifdef TRACE_GENERATE
+	trace << "Adding colored images\n";
+	trace.flush();
+#endif
+
+	// Add the colored images first
+	AddCharsToPage(chars, maxChars, true, 0);
+
+	// Check if we should stop
+	if( gen->stopWorking ) return;
+
+#ifdef TRACE_GENERATE
+	trace << "Duplicating the skyline to all channels\n";
+	trace.flush();
+#endif
+
+	// Duplicate the skyline and the holes for the other channels
+	for( int n = 1; n < 4; n++ )
+	{
+		skyline[n] = skyline[0];
+		holes[n] = holes[0];
+	}
+
+#ifdef TRACE_GENERATE
+	trace << "Adding monochrome images to channel 0\n";
+	trace.flush();
+#endif
+
+	// Then the black & white images
+	AddCharsToPage(chars, maxChars, false, 0);
+
+	// Check if we should stop
+	if( gen->stopWorking ) return;
+
+	if( numChannels == 4 )
+	{
+		for( int n = 1; n < 4; n++ )
+		{
+#ifdef TRACE_GENERATE
+	trace << "Adding monochrome images to channel " << n << "\n";
+	trace.flush();
+#endif
+
+			AddCharsToPage(chars, maxChars, false, n);
+
+			// Check if we should stop
+			if( gen->stopWorking ) return;
+		}
+	}
+}
+
+void CSkylinePacker::AddCharsToPage(CFontChar **chars, int maxChars, bool colored, int channel)
+{
+	// The lists of candidates are sized to the number of characters 
+	// given to the page, which is only the ones that are still left
+	vector<int> indexA(maxChars), indexB(maxChars);
+	int *index = maxChars ? &indexA[0] : 0, *index2 = maxChars ? &indexB[0] : 0;
+	int numChars = 0, numChars2 = 0;
+
+	// Add images to the list
+	for( int n = 0; n < maxChars; n++ )
+	{
+		if( chars[n] && chars[n]->m_isChar != colored )
+			index[numChars++] = n;
+	}
+
+#ifdef TRACE_GENERATE
+	trace << "Sorting list of " << numChars << " candidates\n";
+	trace.flush();
+#endif
+
+	// Sort the characters by height/width, largest first
+	SortList(chars, index, numChars);
+
+	// Add the images to the page
+	while( numChars > 0 )
+	{
+		#ifdef TRACE_GENERATE
+			trace << "There are " << numChars << " candidates left, and " << holes[channel].GetCount() << " holes to fill\n";
+			trace.flush();
+		#endif
+
+		// Fill holes
+		numChars = FillHoles(chars, index, numChars, channel);
+
+		// Check if we should stop
+		if( gen->stopWorking ) return;
+		if( numChars == 0 ) break;
+
+#ifdef TRACE_GENERATE
+		trace << "All holes have been filled\n";
+		trace.flush();
+#endif
+
+		numChars2 = 0;
+		bool allTooWide = true;
+		bool drawn = false;
+
+		// Determine if there is a large height difference anywhere, and if so start filling from that location
+		// This happens for example when importing images that are out of proportion to the rest of the glyphs
+		currX = DetermineStartX(chars, index, numChars, channel);
+
+#ifdef TRACE_GENERATE
+		trace << "currX is " << currX << " and heights is " << GetHeight(currX, channel) << "\n";
+		trace << "tallest char is " << chars[index[0]]->m_height << "x" << chars[index[0]]->m_width << " and shortest char is " << chars[index[numChars-1]]->m_height << "x" << chars[index[numChars-1]]->m_width << "\n";
+		trace << "GetNextIdealImageWidth() = " << GetNextIdealImageWidth() << "\n";
+		trace.flush();
+#endif
+
+		// Sanity check. This could become negative if previous code failed to catch out of memory
+		if( GetNextIdealImageWidth() < 0 )
+		{
+#ifdef TRACE_GENERATE
+			trace << "GetNextIdealImageWidth() < 0. Something is wrong\n";
+			trace.flush();
+#endif
+
+			gen->stopWorking = true;
+			gen->outOfMemory = true;
+			return;
+		}
+
+		// Add one row of chars to texture
+		for( int n = 0; n < numChars; n++ )
+		{
+			bool ok = false;
+			if( chars[index[n]]->m_charImg->width <= GetNextIdealImageWidth() )
+			{
+				allTooWide = false;
+				int r = AddChar(chars[index[n]], channel);
+				if( r >= 0 )
+				{
+#ifdef TRACE_GENERATE
+					trace << "Character [" << index[n] << "] was added\n";
+					trace.flush();
+#endif
+
+					chars[index[n]] = 0;
+					ok = true;
+					drawn = true;
+
+					// Check if we should stop
+					if( gen->stopWorking ) return;
+				}
+			}
+
+			if( !ok )
+			{
+#ifdef TRACE_GENERATE
+//				trace << "Character [" << index[n] << "] didn't fit on this row\n";
+//				trace.flush();
+#endif
+
+				// Move it to the next index list
+				index2[numChars2++] = index[n];
+			}
+		}
+
+		// Swap indices
+		int *tmp = index;
+		index = index2;
+		index2 = tmp;
+
+		numChars = numChars2;
+		numChars2 = 0;
+
+#ifdef TRACE_GENERATE
+		trace << "allTooWide = " << allTooWide << ", drawn = " << drawn << "\n";
+		trace.flush();
+#endif
+
+		if( !allTooWide && !drawn )
+		{
+			// Next page
+			break;
+		}
+	}
+}
+
+int CSkylinePacker::DetermineStartX(CFontChar **chars, int *index, int numChars, int channel)
+{
+	int startX = 0;
+
+	// Determine if there is a large height difference anywhere, and if so start filling from that location
+	// This happens for example when importing images that are out of proportion to the rest of the glyphs
+	int thinnestChar = width;
+	for( int n = 0; n < numChars; n++ )
+		if( thinnestChar > (chars[index[n]]->m_width + paddingLeft + paddingRight + spacingH) )
+			thinnestChar = chars[index[n]]->m_width + paddingLeft + paddingRight + spacingH;
+
+	// The height can only change where one segment ends and the next begins
+	vector<SSkylineSegment> &segs = skyline[channel];
+	for( unsigned int n = 1; n < segs.size() && segs[n].x - 1 < width - 1 - thinnestChar; n++ )
+	{
+		// Compare against the largest glyph that we'll add (first in list)
+		if( segs[n-1].y - segs[n].y >= (chars[index[0]]->m_height + paddingUp + paddingDown + spacingV) )
+		{
+			startX = segs[n].x;
+			break;
+		}
+	}
+
+	return startX;
+}
+
+// Places the characters in the holes where they fit best, starting with 
+// the largest characters. Returns the number of characters left in the list.
+int CSkylinePacker::FillHoles(CFontChar **chars, int *index, int numChars, int channel)
+{
+	if( holes[channel].GetCount() == 0 )
+		return numChars;
+
+	int numLeft = 0;
+	for( int n = 0; n < numChars; n++ )
+	{
+		CFontChar *ch = chars[index[n]];
+		int w = ch->m_charImg->width + paddingLeft + paddingRight;
+		int h = ch->m_charImg->height + paddingUp + paddingDown;
+
+		SHole hole;
+		if( gen->stopWorking || !holes[channel].TakeBestFit(w, h, hole) )
+		{
+			// Keep the character in the list
+			index[numLeft++] = index[n];
+			continue;
+		}
+
+		// There may still be room for more 
+		if( hole.w - spacingH > w )
+		{
+			// Create a new hole to the right of the newly inserted character, with the same height of the previous hole
+			SHole hole2;
+			hole2.x = hole.x + (w + spacingH);
+			hole2.y = hole.y;
+			hole2.w = hole.w - (w + spacingH);
+			hole2.h = hole.h;
+			hole2.chnl = hole.chnl;
+			holes[channel].Add(hole2);
+		}
+		if( hole.h - spacingV > h )
+		{
+			// Create a new hole below the newly inserted character, with the width of the character
+			SHole hole2;
+			hole2.x = hole.x;
+			hole2.y = hole.y + (h + spacingV);
+			hole2.w = w;
+			hole2.h = hole.h - (h + spacingV);
+			hole2.chnl = hole.chnl;
+			holes[channel].Add(hole2);
+		}
+
+		AddChar(hole.x, hole.y, ch, channel);
+		chars[index[n]] = 0;
+
+#ifdef TRACE_GENERATE
+		trace << "Character [" << index[n] << "] was used to fill hole\n";
+		trace.flush();
+#endif
+	}
+
+	return numLeft;
+}
+
+CHoleIndex::CHoleIndex()
+{
+	count = 0;
+}
+
+void CHoleIndex::Clear()
+{
+	buckets.clear();
+	count = 0;
+}
+
+void CHoleIndex::Add(const SHole &hole)
+{
+	if( hole.w <= 0 || hole.h <= 0 )
+		return;
+
+	buckets[hole.h].insert(widthMap_t::value_type(hole.w, hole));
+	count++;
+}
+
+int CHoleIndex::GetCount() const
+{
+	return count;
+}
+
+bool CHoleIndex::TakeBestFit(int w, int h, SHole &hole)
+{
+	// Look through the buckets with holes that are high enough, starting 
+	// with the lowest, for the narrowest hole that is wide enough
+	std::map<int, widthMap_t>::iterator b = buckets.lower_bound(h);
+	for( ; b != buckets.end(); b++ )
+	{
+		widthMap_t::iterator it = b->second.lower_bound(w);
+		if( it == b->second.end() )
+			continue;
+
+		hole = it->second;
+		b->second.erase(it);
+		if( b->second.empty() )
+			buckets.erase(b);
+		count--;
+
+		return true;
+	}
+
+	return false;
+}
@@ -25,10 +25,12 @@
    andreas@angelcode.com
 */
 
-#include <algorithm>
 #include <fstream>
+#include <chrono>
+#include <string.h>
 
 #include "fontpage.h"
+#include "fontpacker.h"
 #include "fontchar.h"
 #include "fontgen.h"
 
@@ -37,24 +39,26 @@ using namespace std;
 #define CLR_BORDER 0x007F00ul
 #define CLR_UNUSED 0xFF0000ul
 
-CFontPage::CFontPage(CFontGen *gen, int id, int width, int height, int spacingH, int spacingV)
+CFontPage::CFontPage(CFontGen *gen, int id, int width, int height, int spacingH, int spacingV, bool trial)
 {
 	this->gen = gen;
 	pageId = id;
+	isTrial = trial;
+	usedArea = 0;
 
-	// Allocate and clear the image with the unused color
-	pageImg = new (std::nothrow) cImage(width, height);
-	pageImg->Clear(CLR_UNUSED);
-
-	// Initialize the height array that shows free space
-	heights[0] = new (std::nothrow) int[width];
-	if( heights[0] )
-		memset(heights[0], 0, width*4);
-	heights[1] = 0;
-	heights[2] = 0;
-	heights[3] = 0;
+	this->width  = width;
+	this->height = height;
 
-	currX = 0;
+	// Allocate and clear the image with the unused color. A trial 
+	// page is only used to see how the characters would fit so it 
+	// doesn't need the image
+	pageImg = 0;
+	if( !trial )
+	{
+		pageImg = new (std::nothrow) cImage(width, height);
+		if( pageImg )
+			pageImg->Clear(CLR_UNUSED);
+	}
 
 	this->spacingH = spacingH;
 	this->spacingV = spacingV;
@@ -63,11 +67,15 @@ CFontPage::CFontPage(CFontGen *gen, int id, int width, int height, int spacingH,
 	paddingLeft   = 0;
 	paddingUp     = 0;
 	paddingDown   = 0;
+
+	memset(&stats, 0, sizeof(stats));
 }
 
 bool CFontPage::IsOK()
 {
-	if( pageImg == 0 || heights[0] == 0 ) return false;
+	if( isTrial ) return true;
+
+	if( pageImg == 0 ) return false;
 
 	if( pageImg->pixels == 0 ) return false;
 
@@ -78,10 +86,6 @@ CFontPage::~CFontPage()
 {
 	if( pageImg )
 		delete pageImg;
-
-	for( int n = 0; n < 4; n++ )
-		if( heights[n] )
-			delete[] heights[n];
 }
 
 void CFontPage::SetIntendedFormat(int bitDepth, bool fourChnlPacked, int a, int r, int g, int b)
@@ -97,6 +101,17 @@ void CFontPage::SetIntendedFormat(int bitDepth, bool fourChnlPacked, int a, int
 
 void CFontPage::AddChar(int cx, int cy, CFontChar *ch, int channel)
 {
+	// Keep track of how much of the page is used. The colored 
+	// images use all four channels when the channels are packed
+	int area = (ch->m_width + paddingLeft + paddingRight) * (ch->m_height + paddingUp + paddingDown);
+	if( bitDepth == 32 && fourChnlPacked && !ch->m_isChar )
+		area *= 4;
+	usedArea += area;
+
+	// A trial page doesn't change the character
+	if( isTrial )
+		return;
+
 	// Update the charInfo with the extra draw rect
 	ch->m_x = cx;
 	ch->m_y = cy;
@@ -110,92 +125,30 @@ void CFontPage::AddChar(int cx, int cy, CFontChar *ch, int channel)
 	else
 		ch->m_chnl = 0xF;
 
-	// Update heights
-	cImage *img = ch->m_charImg;
-	for( int x = -spacingH; x < img->width + paddingLeft + paddingRight + spacingH; x++ )
-	{
-		int tempX = x + cx;
-		if( tempX < 0 ) tempX += pageImg->width;
-		if( cy + img->height + spacingV + paddingUp + paddingDown > heights[channel][tempX] )
-			heights[channel][tempX] = cy + img->height + spacingV + paddingUp + paddingDown;
-	}
-
 	chars.push_back(ch);
 
 	// Increment counter in CFontGen
 	gen->counter++;
 }
 
-int CFontPage::AddChar(CFontChar *ch, int channel)
+void CFontPage::RemoveChars()
 {
-	int origX = currX;
-	cImage *img = ch->m_charImg;
-
-	// Iterate for each possible x position
-	int i = 0;
-	while( i++ < pageImg->width - img->width - paddingRight - paddingLeft - spacingH )
+	// Undo the padding that AddChar added to the charInfo
+	for( unsigned int n = 0; n < chars.size(); n++ )
 	{
-		// Is the character narrow enough to fit?
-		if( img->width + currX + paddingRight + paddingLeft > pageImg->width - spacingH )
-		{
-			// Start from the left side again
-			currX = 0;
-		}
-
-		// Will the character fit in this place?
-		int cy = 0;
-		for( int n = 0; n < img->width + paddingLeft + paddingRight; n++ )
-		{
-			if( heights[channel][n+currX] > cy ) 
-				cy = heights[channel][n+currX];
-		}
-
-		if( cy + img->height + paddingUp + paddingDown <= pageImg->height - spacingV )
-		{
-			// Are we creating any holes?
-			for( int x = 0; x < img->width + paddingLeft + paddingRight; x++ )
-			{
-				int tempX = x + currX;
-				if( cy - spacingV > heights[channel][tempX] )
-				{
-					SHole hole;
-					hole.x    = tempX;
-					hole.y    = heights[channel][tempX];
-					hole.w    = 1;
-					hole.h    = cy - spacingV - hole.y;
-					hole.chnl = channel;
-
-					// Determine the width of the hole
-					for( x++; x < img->width + paddingLeft + paddingRight; x++ )
-					{
-						int tempX = x + currX;
-						if( hole.y == heights[channel][tempX] )
-							hole.w++;
-						else
-							break;
-					}
-
-					// TODO: Should need to search for more holes.
-
-					holes.push_back(hole);
-					break;
-				}
-			}
-
-			AddChar(currX, cy, ch, channel);
-
-			currX += img->width + spacingH + paddingLeft + paddingRight;
-
-			return 0;
-		}
-		else
-		{
-			currX++;
-		}
+		CFontChar *ch = chars[n];
+		ch->m_width -= paddingLeft + paddingRight;
+		ch->m_height -= paddingUp + paddingDown;
+		ch->m_xoffset += paddingLeft;
+		ch->m_yoffset += paddingUp;
 	}
 
-	currX = origX;
-	return -1;
+	chars.clear();
+}
+
+int CFontPage::GetUsedArea()
+{
+	return usedArea;
 }
 
 cImage *CFontPage::GetPageImage()
@@ -211,11 +164,6 @@ void CFontPage::SetPadding(int left, int up, int right, int down)
 	paddingDown  = down;
 }
 
-int CFontPage::GetNextIdealImageWidth()
-{
-	return pageImg->width - currX - paddingRight - paddingLeft - spacingH;
-}
-
 void CFontPage::GeneratePreviewTexture(int channel)
 {
 	pageImg->Clear(CLR_UNUSED);
@@ -227,7 +175,7 @@ void CFontPage::GeneratePreviewTexture(int channel)
 		{
 			int cx = chars[n]->m_x + paddingLeft;
 			int cy = chars[n]->m_y + paddingUp;
-			cImage *img = chars[n]->m_charImg;
+			CGlyphImage *img = chars[n]->m_charImg;
 	
 			if( chars[n]->HasOutline() )
 			{
@@ -236,7 +184,7 @@ void CFontPage::GeneratePreviewTexture(int channel)
 				{
 					for( int x = 0; x < img->width; x++ )
 					{
-						DWORD p = img->pixels[y*img->width+x];
+						DWORD p = img->GetColor(x, y);
 						if( (p >> 24) < 0xFF )
 							p += 255 - (p>>24);
 						pageImg->pixels[(y+cy)*pageImg->width+(x+cx)] = p;
@@ -248,7 +196,7 @@ void CFontPage::GeneratePreviewTexture(int channel)
 				for( int y = 0; y < img->height; y++ )
 				{
 					for( int x = 0; x < img->width; x++ )
-						pageImg->pixels[(y+cy)*pageImg->width+(x+cx)] = img->pixels[y*img->width+x];
+						pageImg->pixels[(y+cy)*pageImg->width+(x+cx)] = img->GetColor(x, y);
 				}
 			}
 
@@ -315,15 +263,15 @@ void CFontPage::GenerateOutputTexture()
 	{
 		int cx = chars[n]->m_x + paddingLeft;
 		int cy = chars[n]->m_y + paddingUp;
-		cImage *img = chars[n]->m_charImg;
+		CGlyphImage *img = chars[n]->m_charImg;
 
-		if( !chars[n]->m_isChar )
+		if( !chars[n]->m_isChar || img->format == e_color32 )
 		{
-			// Colored images are copied as is
+			// Colored images and multi-channel distance fields are copied as is
 			for( int y = 0; y < img->height; y++ )
 			{
 				for( int x = 0; x < img->width; x++ )
-					pageImg->pixels[(y+cy)*pageImg->width+(x+cx)] = img->pixels[y*img->width+x];
+					pageImg->pixels[(y+cy)*pageImg->width+(x+cx)] = img->pixels32[y*img->width+x];
 			}
 		}
 		else
@@ -383,324 +331,93 @@ void CFontPage::GenerateOutputTexture()
 	}
 }
 
-// This global pointer will be used by the sorting algorithm
-CFontChar **g_chars = 0;
-
-// Define a structure and comparison operator for the sorting algorithm
-struct element { int index; };
-bool operator<(const element &a, const element &b) 
-{
-	// We want to sort the characters from larger to smaller
-	if( g_chars[a.index]->m_height > g_chars[b.index]->m_height ||
-	    (g_chars[a.index]->m_height == g_chars[b.index]->m_height &&
-	     g_chars[a.index]->m_width > g_chars[b.index]->m_width) )
-		return true;
-	return false;
-}
-
-void CFontPage::SortList(CFontChar **chars, int *index, int numChars)
-{
-	g_chars = chars;
-	std::sort((element*)index, (element*)(&index[numChars]));
-}
-
 #ifdef TRACE_GENERATE
 extern ofstream trace;
 #endif
 
 void CFontPage::AddChars(CFontChar **chars, int maxChars)
 {
-#ifdef TRACE_GENERATE
-	trace << "Adding colored images\n";
-	trace.flush();
-#endif
-
-	// Add the colored images first
-	AddCharsToPage(chars, maxChars, true, 0);
-
-	// Check if we should stop
-	if( gen->stopWorking ) return;
-
-#ifdef TRACE_GENERATE
-	trace << "Duplicating the height array to all channels\n";
-	trace.flush();
-#endif
-
-	// Duplicate the height array for the other channels
-	for( int n = 1; n < 4; n++ )
+	// The packer only lives while the characters are added to the page
+	CFontPacker *packer = CFontPacker::Create(gen->GetPacker(), this);
+	if( packer == 0 || !packer->IsOK() )
 	{
-		heights[n] = new (std::nothrow) int[pageImg->width];
-		if( heights[n] == 0 )
-		{
 #ifdef TRACE_GENERATE
-			trace << "Out of memory while allocating height buffer\n";
-			trace.flush();
-#endif
-			gen->stopWorking = true;
-			gen->outOfMemory = true;
-			return;
-		}
-		memcpy(heights[n], heights[0], pageImg->width*sizeof(int));
-	}
-
-	// Remove the current holes
-	holes.resize(0);
-
-#ifdef TRACE_GENERATE
-	trace << "Adding monochrome images to channel 0\n";
-	trace.flush();
+		trace << "Out of memory while creating the packer\n";
+		trace.flush();
 #endif
+		if( packer )
+			delete packer;
 
-	// Then the black & white images
-	AddCharsToPage(chars, maxChars, false, 0);
+		gen->stopWorking = true;
+		gen->outOfMemory = true;
+		return;
+	}
 
-	// Check if we should stop
-	if( gen->stopWorking ) return;
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	packer->AddChars(chars, maxChars);
+	chrono::high_resolution_clock::duration packTime = chrono::high_resolution_clock::now() - start;
 
-	if( bitDepth == 32 && fourChnlPacked )
-	{
-		for( int n = 1; n < 4; n++ )
-		{
-#ifdef TRACE_GENERATE
-	trace << "Adding monochrome images to channel " << n << "\n";
-	trace.flush();
-#endif
-
-			AddCharsToPage(chars, maxChars, false, n);
+	delete packer;
 
-			// Check if we should stop
-			if( gen->stopWorking ) return;
-		}
-	}
+	if( !isTrial )
+		UpdateStats(chrono::duration<double, milli>(packTime).count());
 }
 
-void CFontPage::AddCharsToPage(CFontChar **chars, int maxChars, bool colored, int channel)
+void CFontPage::UpdateStats(double packTime)
 {
-	static int indexA[maxUnicodeChar+1], indexB[maxUnicodeChar+1];
-	int *index = indexA, *index2 = indexB;
-	int numChars = 0, numChars2 = 0;
-
-	// Add images to the list
-	for( int n = 0; n < maxChars; n++ )
+	int numChannels = (bitDepth == 32 && fourChnlPacked) ? 4 : 1;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.width       = width;
+	stats.height      = height;
+	stats.numChannels = numChannels;
+	stats.numChars    = chars.size();
+	stats.packTime    = packTime;
+
+	// Each channel is measured separately. The skyline is the lowest edge 
+	// of the characters and their spacing in each column, everything above 
+	// it is still free while the free space below it is enclosed in holes.
+	std::vector<int> skyline(width);
+	for( int c = 0; c < numChannels; c++ )
 	{
-		if( chars[n] && chars[n]->m_isChar != colored )
-			index[numChars++] = n;
-	}
+		for( int x = 0; x < width; x++ )
+			skyline[x] = 0;
 
-#ifdef TRACE_GENERATE
-	trace << "Sorting list of " << numChars << " candidates\n";
-	trace.flush();
-#endif
-
-	// Sort the characters by height/width, largest first
-	SortList(chars, index, numChars);
-
-	// Add the images to the page
-	while( numChars > 0 )
-	{
-		#ifdef TRACE_GENERATE
-			trace << "There are " << numChars << " candidates left, and " << holes.size() << " holes to fill\n";
-			trace.flush();
-		#endif
-
-		// Fill holes
-		for( int h = 0; h < (signed)holes.size(); h++ )
+		int cellArea = 0;
+		for( unsigned int n = 0; n < chars.size(); n++ )
 		{
-			int bestMatch;
-			bestMatch = -1;
-
-			// Find the best matching character to fill the hole
-			for( int n = 0; n < numChars; n++ )
-			{
-				if( (holes[h].w == chars[index[n]]->m_charImg->width + paddingLeft + paddingRight) &&
-					(holes[h].h == chars[index[n]]->m_charImg->height + paddingUp + paddingDown) )
-				{
-					bestMatch = n;
-					break;
-				}
-				else if( (holes[h].w >= chars[index[n]]->m_charImg->width + paddingLeft + paddingRight) &&
-					     (holes[h].h >= chars[index[n]]->m_charImg->height + paddingUp + paddingDown) )
-				{
-					if( bestMatch != -1 )
-					{
-						if( (chars[index[n]]->m_charImg->width > chars[index[bestMatch]]->m_charImg->width) ||
-							(chars[index[n]]->m_charImg->height > chars[index[bestMatch]]->m_charImg->height) )
-							bestMatch = n;
-					}
-					else
-						bestMatch = n;
-				}
-			}
-
-			if( bestMatch != -1 )
-			{
-				int x = holes[h].x;
-				int y = holes[h].y;
-
-				// There may still be room for more 
-				if( holes[h].w - spacingH > chars[index[bestMatch]]->m_charImg->width + paddingLeft + paddingRight )
-				{
-					// Create a new hole to the right of the newly inserted character, with the same height of the previous hole
-					SHole hole2;
-					hole2.x = holes[h].x + (chars[index[bestMatch]]->m_charImg->width + paddingLeft + paddingRight + spacingH);
-					hole2.y = holes[h].y;
-					hole2.w = holes[h].w - (chars[index[bestMatch]]->m_charImg->width + paddingLeft + paddingRight + spacingH);
-					hole2.h = holes[h].h;
-					hole2.chnl = holes[h].chnl;
-					holes.push_back(hole2);
-				}
-				if( holes[h].h - spacingV > chars[index[bestMatch]]->m_charImg->height + paddingUp + paddingDown )
-				{
-					// Create a new hole below the newly inserted character, with the width of the character
-					SHole hole2;
-					hole2.x = holes[h].x;
-					hole2.y = holes[h].y + (chars[index[bestMatch]]->m_charImg->height + paddingUp + paddingDown + spacingV);
-					hole2.w = (chars[index[bestMatch]]->m_charImg->width + paddingLeft + paddingRight);
-					hole2.h = holes[h].h - (chars[index[bestMatch]]->m_charImg->height + paddingUp + paddingDown + spacingV);
-					hole2.chnl = holes[h].chnl;
-					holes.push_back(hole2);
-				}
-
-				AddChar(x, y, chars[index[bestMatch]], channel);
-				chars[index[bestMatch]] = 0;
-
-#ifdef TRACE_GENERATE
-				trace << "Character [" << index[bestMatch] << "] was used to fill hole\n";
-				trace.flush();
-#endif
-
-				// Check if we should stop
-				if( gen->stopWorking ) return;
-
-				// Compact the list 
-				numChars--;
-				for( int n = bestMatch; n < numChars; n++ )
-					index[n] = index[n+1];
-			}
-			
-			// Remove the hole
-			if( h < (signed)holes.size() - 1 )
-				holes[h] = holes[holes.size()-1];
-			holes.pop_back();
-			h--;
+			CFontChar *ch = chars[n];
+			if( !(ch->m_chnl & (1<<c)) )
+				continue;
+
+			// The spacing is to the right and below the character
+			int x1 = ch->m_x + ch->m_width + spacingH;
+			int y1 = ch->m_y + ch->m_height + spacingV;
+			if( x1 > width ) x1 = width;
+			if( y1 > height ) y1 = height;
+
+			for( int x = ch->m_x; x < x1; x++ )
+				if( skyline[x] < y1 )
+					skyline[x] = y1;
+
+			int area = ch->m_width * ch->m_height;
+			int cell = (x1 - ch->m_x) * (y1 - ch->m_y);
+			stats.channelArea[c] += area;
+			stats.usedArea       += area;
+			stats.spacingArea    += cell - area;
+			cellArea             += cell;
 		}
 
-#ifdef TRACE_GENERATE
-		trace << "All holes have been filled\n";
-		trace.flush();
-#endif
+		int below = 0;
+		for( int x = 0; x < width; x++ )
+			below += skyline[x];
 
-		numChars2 = 0;
-		bool allTooWide = true;
-		bool drawn = false;
-
-		// Determine if there is a large height difference anywhere, and if so start filling from that location
-		// This happens for example when importing images that are out of proportion to the rest of the glyphs
-		currX = DetermineStartX(chars, index, numChars, channel);
-
-#ifdef TRACE_GENERATE
-		trace << "currX is " << currX << " and heights is " << heights[channel][currX] << "\n";
-		trace << "tallest char is " << chars[index[0]]->m_height << "x" << chars[index[0]]->m_width << " and shortest char is " << chars[index[numChars-1]]->m_height << "x" << chars[index[numChars-1]]->m_width << "\n";
-		trace << "GetNextIdealImageWidth() = " << GetNextIdealImageWidth() << "\n";
-		trace.flush();
-#endif
-
-		// Sanity check. This could become negative if previous code failed to catch out of memory
-		if( GetNextIdealImageWidth() < 0 )
-		{
-#ifdef TRACE_GENERATE
-			trace << "GetNextIdealImageWidth() < 0. Something is wrong\n";
-			trace.flush();
-#endif
-
-			gen->stopWorking = true;
-			gen->outOfMemory = true;
-			return;
-		}
-
-		// Add one row of chars to texture
-		for( int n = 0; n < numChars; n++ )
-		{
-			bool ok = false;
-			if( chars[index[n]]->m_charImg->width <= GetNextIdealImageWidth() )
-			{
-				allTooWide = false;
-				int r = AddChar(chars[index[n]], channel);
-				if( r >= 0 )
-				{
-#ifdef TRACE_GENERATE
-					trace << "Character [" << index[n] << "] was added\n";
-					trace.flush();
-#endif
-
-					chars[index[n]] = 0;
-					ok = true;
-					drawn = true;
-
-					// Check if we should stop
-					if( gen->stopWorking ) return;
-				}
-			}
-
-			if( !ok )
-			{
-#ifdef TRACE_GENERATE
-//				trace << "Character [" << index[n] << "] didn't fit on this row\n";
-//				trace.flush();
-#endif
-
-				// Move it to the next index list
-				index2[numChars2++] = index[n];
-			}
-		}
-
-		if( index == indexA )
-		{
-			// Swap indices
-			index = indexB;
-			index2 = indexA;
-		}
-		else
-		{
-			index = indexA;
-			index2 = indexB;
-		}
-
-		numChars = numChars2;
-		numChars2 = 0;
-
-#ifdef TRACE_GENERATE
-		trace << "allTooWide = " << allTooWide << ", drawn = " << drawn << "\n";
-		trace.flush();
-#endif
-
-		if( !allTooWide && !drawn )
-		{
-			// Next page
-			break;
-		}
+		stats.holeArea    += below - cellArea;
+		stats.skylineArea += width*height - below;
 	}
 }
 
-int CFontPage::DetermineStartX(CFontChar **chars, int *index, int numChars, int channel)
+const SPageStats &CFontPage::GetStats() const
 {
-	int startX = 0;
-
-	// Determine if there is a large height difference anywhere, and if so start filling from that location
-	// This happens for example when importing images that are out of proportion to the rest of the glyphs
-	int thinnestChar = pageImg->width;
-	for( int n = 0; n < numChars; n++ )
-		if( thinnestChar > (chars[index[n]]->m_width + paddingLeft + paddingRight + spacingH) )
-			thinnestChar = chars[index[n]]->m_width + paddingLeft + paddingRight + spacingH;
-	for( int n = 0; n < pageImg->width - 1 - thinnestChar; n++ )
-	{
-		// Compare against the largest glyph that we'll add (first in list)
-		if( heights[channel][n] - heights[channel][n+1] >= (chars[index[0]]->m_height + paddingUp + paddingDown + spacingV) )
-		{
-			startX = n+1;
-			break;
-		}
-	}
-
-	return startX;
+	return stats;
 }
\ No newline at end of file
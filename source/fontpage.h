@@ -34,19 +34,28 @@
 class CFontChar;
 class CFontGen;
 
-struct SHole
+// Measures of how well the page was used. The areas are counted in 
+// pixels, and in four channel packed mode each channel counts separately. 
+// The used area, spacing, holes and free area above the skyline add up 
+// to the full page area.
+struct SPageStats
 {
-	int x;
-	int y;
-	int w;
-	int h;
-	int chnl;
+	int    width;
+	int    height;
+	int    numChannels;
+	int    numChars;
+	int    usedArea;           // Characters including padding
+	int    spacingArea;        // Spacing between the characters
+	int    holeArea;           // Free space enclosed below the skyline
+	int    skylineArea;        // Free space above the skyline
+	int    channelArea[4];     // Used area in each channel
+	double packTime;           // Milliseconds spent placing the characters
 };
 
 class CFontPage
 {
 public:
-	CFontPage(CFontGen *gen, int id, int width, int height, int spacingH, int spacingV);
+	CFontPage(CFontGen *gen, int id, int width, int height, int spacingH, int spacingV, bool trial = false);
 	~CFontPage();
 
 	bool    IsOK();
@@ -56,25 +65,35 @@ public:
 
 	void    AddChars(CFontChar **chars, int count);
 
+	// Takes the characters off the page again, restoring them 
+	// to how they were so they can be placed on another page
+	void    RemoveChars();
+
 	void    GeneratePreviewTexture(int channel);
 	void    GenerateOutputTexture();
 
 	cImage *GetPageImage();
 
+	// The area covered by the characters, including padding. In four channel 
+	// packed mode each channel counts separately.
+	int     GetUsedArea();
+
+	const SPageStats &GetStats() const;
+
 protected:
+	friend class CFontPacker;
+
 	void    AddChar(int x, int y, CFontChar *ch, int channel);
-	int     AddChar(CFontChar *ch, int channel);
-	void    SortList(CFontChar **ch, int *indices, int count);
-	void    AddCharsToPage(CFontChar **ch, int count, bool colored, int channel);
-	int     GetNextIdealImageWidth();
-	int     DetermineStartX(CFontChar **ch, int *indices, int count, int channel);
+	void    UpdateStats(double packTime);
 
 	CFontGen *gen;
 
 	int     pageId;
+	bool    isTrial;
+	int     width;
+	int     height;
+	int     usedArea;
 	cImage *pageImg;
-	int    *heights[4];
-	int     currX;
 	int     spacingH;
 	int     spacingV;
 
@@ -91,7 +110,8 @@ protected:
 	int  blueChnl;
 
 	std::vector<CFontChar*> chars;
-	std::vector<SHole> holes;
+
+	SPageStats stats;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,503 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#include <algorithm>
+#include <string.h>
+
+#include "glyphcache.h"
+#include "fontchar.h"
+#include "ac_string_util.h"
+
+#ifdef _WIN32
+#include "acwin_window.h"
+using namespace acWindow;
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+// Layout of the cache file. The values are 32 bit integers.
+//
+//  SFileHeader
+//  settings string, padded to a multiple of 4 bytes
+//  SIndexEntry for each glyph, sorted by id
+//  SGlyphRecord followed by the pixels for each glyph, at the offsets in the index,
+//  stored in the glyph image format and padded to a multiple of 4 bytes
+
+static const char         cacheMagic[4] = {'B','M','G','C'};
+static const unsigned int cacheVersion  = 2;
+
+struct SFileHeader
+{
+	char         magic[4];
+	unsigned int version;
+	unsigned int fontHashLow;
+	unsigned int fontHashHigh;
+	unsigned int settingsLength;
+	unsigned int numGlyphs;
+};
+
+struct SGlyphRecord
+{
+	int          width;
+	int          height;
+	int          xoffset;
+	int          yoffset;
+	int          advance;
+	unsigned int flags;
+	int          imgWidth;
+	int          imgHeight;
+	int          imgFormat;
+};
+
+enum EGlyphFlags
+{
+	e_colored  = 1,
+	e_isChar   = 2
+};
+
+// 64 bit FNV-1a hash
+static unsigned long long HashData(const void *data, unsigned int size)
+{
+	const BYTE *p = (const BYTE*)data;
+	unsigned long long hash = 14695981039346656037ULL;
+	for( unsigned int n = 0; n < size; n++ )
+	{
+		hash ^= p[n];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static unsigned int Align4(unsigned int size)
+{
+	return (size + 3) & ~3u;
+}
+
+static unsigned long long GetPixelDataSize(const SGlyphRecord *rec)
+{
+	unsigned long long size = (unsigned long long)rec->imgWidth * rec->imgHeight;
+	if( rec->imgFormat == e_glyphOutline16 ) size *= 2;
+	else if( rec->imgFormat == e_color32 ) size *= 4;
+	return (size + 3) & ~3ull;
+}
+
+CGlyphCacheFile::CGlyphCacheFile()
+{
+	fontHash  = 0;
+#ifdef _WIN32
+	file      = INVALID_HANDLE_VALUE;
+	mapping   = 0;
+#else
+	file      = -1;
+#endif
+	data      = 0;
+	dataSize  = 0;
+	index     = 0;
+	numGlyphs = 0;
+}
+
+CGlyphCacheFile::~CGlyphCacheFile()
+{
+	Close();
+}
+
+int CGlyphCacheFile::Open(const string &dir, const void *fontData, unsigned int fontDataSize, const string &settings)
+{
+	Close();
+
+	if( dir == "" || fontData == 0 || fontDataSize == 0 )
+		return -1;
+
+	// Make sure the directory exists
+#ifdef _WIN32
+	TCHAR buf[MAX_PATH];
+	ConvertUtf8ToTChar(dir, buf, MAX_PATH);
+	if( !CreateDirectory(buf, 0) && GetLastError() != ERROR_ALREADY_EXISTS )
+		return -1;
+#else
+	if( mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST )
+		return -1;
+#endif
+
+	this->settings = settings;
+	fontHash = HashData(fontData, fontDataSize);
+	unsigned long long settingsHash = HashData(settings.c_str(), settings.length());
+
+	path = dir;
+	if( path[path.length()-1] != '/' && path[path.length()-1] != '\\' )
+		path += "/";
+	path += acStringFormat("%016llx_%016llx.bmgc", fontHash, settingsHash);
+
+	// The file doesn't exist until the first glyphs are saved
+	Map();
+
+	return 0;
+}
+
+void CGlyphCacheFile::Close()
+{
+	Unmap();
+	path = "";
+	settings = "";
+	fontHash = 0;
+}
+
+bool CGlyphCacheFile::IsOpen() const
+{
+	return path != "";
+}
+
+int CGlyphCacheFile::GetNumGlyphs() const
+{
+	return numGlyphs;
+}
+
+int CGlyphCacheFile::Map()
+{
+	Unmap();
+
+#ifdef _WIN32
+	TCHAR buf[MAX_PATH];
+	ConvertUtf8ToTChar(path, buf, MAX_PATH);
+	file = CreateFile(buf, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if( file == INVALID_HANDLE_VALUE )
+		return -1;
+
+	dataSize = GetFileSize(file, 0);
+	if( dataSize == INVALID_FILE_SIZE || dataSize < sizeof(SFileHeader) )
+	{
+		Unmap();
+		return -1;
+	}
+
+	mapping = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+	if( mapping )
+		data = (const BYTE*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	file = open(path.c_str(), O_RDONLY);
+	if( file < 0 )
+		return -1;
+
+	struct stat st;
+	if( fstat(file, &st) != 0 || st.st_size < (off_t)sizeof(SFileHeader) || st.st_size > 0x7FFFFFFF )
+	{
+		Unmap();
+		return -1;
+	}
+	dataSize = (unsigned int)st.st_size;
+
+	void *view = mmap(0, dataSize, PROT_READ, MAP_SHARED, file, 0);
+	if( view != MAP_FAILED )
+		data = (const BYTE*)view;
+#endif
+	if( data == 0 )
+	{
+		Unmap();
+		return -1;
+	}
+
+	// Verify that the file is for the same font and settings, 
+	// in case of hash collisions or a damaged file
+	const SFileHeader *header = (const SFileHeader*)data;
+	unsigned int indexOffset = sizeof(SFileHeader) + Align4(header->settingsLength);
+	if( memcmp(header->magic, cacheMagic, 4) != 0 ||
+		header->version != cacheVersion ||
+		header->fontHashLow != (unsigned int)fontHash ||
+		header->fontHashHigh != (unsigned int)(fontHash >> 32) ||
+		header->settingsLength != settings.length() ||
+		indexOffset > dataSize ||
+		memcmp(data + sizeof(SFileHeader), settings.c_str(), settings.length()) != 0 ||
+		header->numGlyphs > (dataSize - indexOffset) / sizeof(SIndexEntry) )
+	{
+		Unmap();
+		return -1;
+	}
+
+	index     = (const SIndexEntry*)(data + indexOffset);
+	numGlyphs = header->numGlyphs;
+
+	return 0;
+}
+
+void CGlyphCacheFile::Unmap()
+{
+#ifdef _WIN32
+	if( data )
+		UnmapViewOfFile(data);
+	if( mapping )
+		CloseHandle(mapping);
+	if( file != INVALID_HANDLE_VALUE )
+		CloseHandle(file);
+
+	file      = INVALID_HANDLE_VALUE;
+	mapping   = 0;
+#else
+	if( data )
+		munmap((void*)data, dataSize);
+	if( file >= 0 )
+		close(file);
+
+	file      = -1;
+#endif
+	data      = 0;
+	dataSize  = 0;
+	index     = 0;
+	numGlyphs = 0;
+}
+
+const CGlyphCacheFile::SIndexEntry *CGlyphCacheFile::FindEntry(int id) const
+{
+	unsigned int lo = 0, hi = numGlyphs;
+	while( lo < hi )
+	{
+		unsigned int mid = (lo + hi) / 2;
+		if( index[mid].id < (unsigned int)id )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if( lo == numGlyphs || index[lo].id != (unsigned int)id )
+		return 0;
+
+	// Make sure the glyph is within the file. A damaged 
+	// record is treated as if the glyph wasn't cached
+	const SIndexEntry *entry = &index[lo];
+	if( (entry->offset & 3) || entry->offset > dataSize || dataSize - entry->offset < sizeof(SGlyphRecord) )
+		return 0;
+
+	// The glyphs are stored after they have been cropped, so 
+	// the size of the character is the size of the image
+	const SGlyphRecord *rec = (const SGlyphRecord*)(data + entry->offset);
+	if( rec->imgWidth < 0 || rec->imgHeight < 0 ||
+		rec->width != rec->imgWidth || rec->height != rec->imgHeight ||
+		rec->imgFormat < e_glyph8 || rec->imgFormat > e_color32 ||
+		GetPixelDataSize(rec) > dataSize - entry->offset - sizeof(SGlyphRecord) )
+		return 0;
+
+	return entry;
+}
+
+CFontChar *CGlyphCacheFile::Load(int id) const
+{
+	const SIndexEntry *entry = FindEntry(id);
+	if( entry == 0 )
+		return 0;
+
+	const SGlyphRecord *rec = (const SGlyphRecord*)(data + entry->offset);
+
+	CFontChar *ch = new CFontChar();
+	ch->m_id      = id;
+	ch->m_width   = rec->width;
+	ch->m_height  = rec->height;
+	ch->m_xoffset = rec->xoffset;
+	ch->m_yoffset = rec->yoffset;
+	ch->m_advance = rec->advance;
+	ch->m_colored = (rec->flags & e_colored) ? true : false;
+	ch->m_isChar  = (rec->flags & e_isChar) ? true : false;
+
+	ch->m_charImg = new CGlyphImage(rec->imgWidth, rec->imgHeight, rec->imgFormat);
+	if( ch->m_charImg->pixels8 == 0 )
+	{
+		delete ch;
+		return 0;
+	}
+
+	// FindEntry has verified that the pixels are within the file
+	memcpy(ch->m_charImg->pixels8, rec + 1, size_t(rec->imgWidth) * rec->imgHeight * ch->m_charImg->GetBytesPerPixel());
+
+	return ch;
+}
+
+// Internal
+// Used for sorting the glyphs when saving the file
+struct SSaveGlyph
+{
+	unsigned int       id;
+	const BYTE        *record;
+	const CFontChar   *ch;
+	unsigned int       size;
+
+	bool operator<(const SSaveGlyph &o) const { return id < o.id; }
+};
+
+#ifdef _WIN32
+static bool WriteData(HANDLE file, const void *data, unsigned int size)
+{
+	DWORD written = 0;
+	return WriteFile(file, data, size, &written, 0) && written == size;
+}
+#else
+static bool WriteData(FILE *file, const void *data, unsigned int size)
+{
+	return size == 0 || fwrite(data, size, 1, file) == 1;
+}
+#endif
+
+int CGlyphCacheFile::Save(const vector<CFontChar*> &glyphs)
+{
+	if( !IsOpen() )
+		return -1;
+
+	// Gather the glyphs already in the file and the new ones
+	vector<SSaveGlyph> list;
+	list.reserve(numGlyphs + glyphs.size());
+	for( unsigned int n = 0; n < numGlyphs; n++ )
+	{
+		if( FindEntry(index[n].id) == 0 )
+			continue;
+
+		SSaveGlyph g;
+		g.id     = index[n].id;
+		g.record = data + index[n].offset;
+		g.ch     = 0;
+		const SGlyphRecord *rec = (const SGlyphRecord*)g.record;
+		g.size   = sizeof(SGlyphRecord) + (unsigned int)GetPixelDataSize(rec);
+		list.push_back(g);
+	}
+	for( unsigned int n = 0; n < glyphs.size(); n++ )
+	{
+		const CFontChar *ch = glyphs[n];
+		if( ch == 0 || ch->m_charImg == 0 || FindEntry(ch->m_id) )
+			continue;
+
+		SSaveGlyph g;
+		g.id     = ch->m_id;
+		g.record = 0;
+		g.ch     = ch;
+		g.size   = sizeof(SGlyphRecord) + Align4(ch->m_charImg->width * ch->m_charImg->height * ch->m_charImg->GetBytesPerPixel());
+		list.push_back(g);
+	}
+	stable_sort(list.begin(), list.end());
+
+	// The same glyph may have been given twice, in which case the first is kept
+	unsigned int count = 0;
+	for( unsigned int n = 0; n < list.size(); n++ )
+		if( count == 0 || list[count-1].id != list[n].id )
+			list[count++] = list[n];
+	list.resize(count);
+
+	// Build the header and the index
+	SFileHeader header;
+	memcpy(header.magic, cacheMagic, 4);
+	header.version        = cacheVersion;
+	header.fontHashLow    = (unsigned int)fontHash;
+	header.fontHashHigh   = (unsigned int)(fontHash >> 32);
+	header.settingsLength = settings.length();
+	header.numGlyphs      = list.size();
+
+	vector<SIndexEntry> newIndex(list.size());
+	unsigned int offset = sizeof(SFileHeader) + Align4(settings.length()) + list.size() * sizeof(SIndexEntry);
+	for( unsigned int n = 0; n < list.size(); n++ )
+	{
+		newIndex[n].id     = list[n].id;
+		newIndex[n].offset = offset;
+		offset += list[n].size;
+	}
+
+	// Write to a temporary file first
+	string tmpPath = acStringFormat("%s.%u.tmp", path.c_str(), (unsigned int)GetCurrentProcessId());
+#ifdef _WIN32
+	TCHAR tmpBuf[MAX_PATH];
+	ConvertUtf8ToTChar(tmpPath, tmpBuf, MAX_PATH);
+	HANDLE out = CreateFile(tmpBuf, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if( out == INVALID_HANDLE_VALUE )
+		return -1;
+#else
+	FILE *out = fopen(tmpPath.c_str(), "wb");
+	if( out == 0 )
+		return -1;
+#endif
+
+	static const BYTE zeros[4] = {0};
+	bool ok = WriteData(out, &header, sizeof(header));
+	ok = ok && WriteData(out, settings.c_str(), settings.length());
+	ok = ok && WriteData(out, zeros, Align4(settings.length()) - settings.length());
+	if( newIndex.size() )
+		ok = ok && WriteData(out, &newIndex[0], newIndex.size() * sizeof(SIndexEntry));
+
+	for( unsigned int n = 0; n < list.size() && ok; n++ )
+	{
+		if( list[n].record )
+		{
+			ok = WriteData(out, list[n].record, list[n].size);
+			continue;
+		}
+
+		const CFontChar *ch = list[n].ch;
+		SGlyphRecord rec;
+		rec.width     = ch->m_width;
+		rec.height    = ch->m_height;
+		rec.xoffset   = ch->m_xoffset;
+		rec.yoffset   = ch->m_yoffset;
+		rec.advance   = ch->m_advance;
+		rec.flags     = (ch->m_colored ? e_colored : 0) | (ch->m_isChar ? e_isChar : 0);
+		rec.imgWidth  = ch->m_charImg->width;
+		rec.imgHeight = ch->m_charImg->height;
+		rec.imgFormat = ch->m_charImg->format;
+		ok = WriteData(out, &rec, sizeof(rec));
+
+		unsigned int size = rec.imgWidth * rec.imgHeight * ch->m_charImg->GetBytesPerPixel();
+		ok = ok && WriteData(out, ch->m_charImg->pixels8, size);
+		ok = ok && WriteData(out, zeros, Align4(size) - size);
+	}
+#ifdef _WIN32
+	CloseHandle(out);
+#else
+	if( fclose(out) != 0 )
+		ok = false;
+#endif
+
+	// The mapping must be closed before the file can be replaced
+	Unmap();
+
+#ifdef _WIN32
+	TCHAR buf[MAX_PATH];
+	ConvertUtf8ToTChar(path, buf, MAX_PATH);
+	if( !ok || !MoveFileEx(tmpBuf, buf, MOVEFILE_REPLACE_EXISTING) )
+	{
+		// Another process may be using the file. The cache 
+		// is only an optimization so this is not an error.
+		DeleteFile(tmpBuf);
+		Map();
+		return ok ? 0 : -1;
+	}
+#else
+	if( !ok || rename(tmpPath.c_str(), path.c_str()) != 0 )
+	{
+		remove(tmpPath.c_str());
+		Map();
+		return ok ? 0 : -1;
+	}
+#endif
+
+	return Map();
+}
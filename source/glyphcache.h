@@ -0,0 +1,98 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include "platform.h"
+#include <string>
+#include <vector>
+
+class CFontChar;
+
+// A persistent cache of drawn glyphs, so that fonts generated again with 
+// the same font and the same drawing settings, e.g. with different texture 
+// layouts, don't have to draw the glyphs again. 
+//
+// Each combination of font data and settings is stored in its own file in 
+// the cache directory, named after the hashes of both. The file is memory 
+// mapped when opened, and the glyphs are found with a binary search in 
+// the index at the start of the file.
+class CGlyphCacheFile
+{
+public:
+	CGlyphCacheFile();
+	~CGlyphCacheFile();
+
+	// Opens the cache file for the font data and settings in the directory. It 
+	// is not an error if the file doesn't exist yet, as it will be created on 
+	// save. Returns -1 if the directory can't be used.
+	int        Open(const std::string &dir, const void *fontData, unsigned int fontDataSize, const std::string &settings);
+	void       Close();
+	bool       IsOpen() const;
+
+	// Returns a new character with the cached glyph, or null if it isn't cached
+	CFontChar *Load(int id) const;
+	int        GetNumGlyphs() const;
+
+	// Writes the file again with the new glyphs added. The file is written to 
+	// a temporary file first and then renamed, so other processes reading the 
+	// cache at the same time never see a partially written file.
+	int        Save(const std::vector<CFontChar*> &glyphs);
+
+protected:
+	struct SIndexEntry
+	{
+		unsigned int id;
+		unsigned int offset;
+	};
+
+	const SIndexEntry *FindEntry(int id) const;
+	int                Map();
+	void               Unmap();
+
+	std::string        path;
+	std::string        settings;
+	unsigned long long fontHash;
+
+#ifdef _WIN32
+	HANDLE             file;
+	HANDLE             mapping;
+#else
+	int                file;
+#endif
+	const BYTE        *data;
+	unsigned int       dataSize;
+	const SIndexEntry *index;
+	unsigned int       numGlyphs;
+
+private:
+	CGlyphCacheFile(const CGlyphCacheFile &);
+	CGlyphCacheFile &operator=(const CGlyphCacheFile &);
+};
+
+#endif
@@ -31,7 +31,9 @@
 #include <iostream>
 
 #include "dynamic_funcs.h"
+#include "ac_string_util.h"
 #include "charwin.h"
+#include "fontbatch.h"
 
 using namespace std;
 
@@ -60,6 +62,7 @@ bool processCmdLine(const char *cmdLine, string &configFile)
 {
 	string outputFile;
 	string textFile;
+	string batchFile;
 
 	configFile = CCharWin::GetDefaultConfig(); // Use the last configuration from the GUI as default
 
@@ -84,6 +87,8 @@ bool processCmdLine(const char *cmdLine, string &configFile)
 				cmdLine = getArgValue(++cmdLine, configFile);
 			else if( *cmdLine == 't' )
 				cmdLine = getArgValue(++cmdLine, textFile);
+			else if( *cmdLine == 'b' )
+				cmdLine = getArgValue(++cmdLine, batchFile);
 			else
 			{
 				hasError = true;
@@ -106,17 +111,42 @@ bool processCmdLine(const char *cmdLine, string &configFile)
 	freopen("CONOUT$","w",stdout);
 	freopen("CONOUT$","w",stderr);
 
-	if( hasError || outputFile == "" )
+	if( hasError || (outputFile == "" && batchFile == "") )
 	{
 		cerr << "Incorrect arguments. See documentation for instructions." << endl;
 		return false;
 	}
 
+	// Generate all the fonts in the manifest within this process
+	if( batchFile != "" )
+	{
+		CFontBatch batch;
+		string error;
+		if( batch.LoadManifest(batchFile, error) < 0 )
+			cerr << error << endl;
+		else
+			batch.Run(false);
+
+		return false;
+	}
+
 	CFontGen *fontGen = new CFontGen();
 
 	cout << "Loading config." << endl;
 	fontGen->LoadConfiguration(configFile.c_str());
 
+	// A configuration with several font sizes generates one font per size
+	if( fontGen->GetFontSizes().size() > 1 )
+	{
+		delete fontGen;
+
+		CFontBatch batch;
+		batch.AddJob(configFile, outputFile, textFile);
+		batch.Run(false);
+
+		return false;
+	}
+
 	if( textFile != "" )
 	{
 		cout << "Selecting characters from file." << endl;
@@ -126,6 +156,8 @@ bool processCmdLine(const char *cmdLine, string &configFile)
 	cout << "Generating pages." << endl;
 	fontGen->GeneratePages(false);
 
+	CFontBatch::ReportPages(fontGen, false);
+
 	cout << "Saving font." << endl;
 	fontGen->SaveFont(outputFile.c_str());
 
@@ -0,0 +1,586 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+// The multi-channel signed distance field is built as described by Viktor 
+// Chlumsky in "Shape Decomposition for Multi-channel Distance Fields". The 
+// edges of the contours are given colors, so that the two edges meeting at 
+// a corner always have different colors. Each color channel then holds the 
+// distance to the nearest edge with that color, and the median of the three 
+// channels reconstructs the sharp corners when the field is magnified.
+
+#include <math.h>
+#include "msdf.h"
+
+using namespace std;
+
+enum EEdgeColor
+{
+	e_black   = 0,
+	e_blue    = 1,
+	e_green   = 2,
+	e_cyan    = 3,
+	e_red     = 4,
+	e_magenta = 5,
+	e_yellow  = 6,
+	e_white   = 7
+};
+
+enum EEdgeType
+{
+	e_line      = 1,
+	e_quadratic = 2
+};
+
+static const double PI = 3.14159265358979323846;
+
+struct SVec
+{
+	double x, y;
+};
+
+static inline SVec Vec(double x, double y)             { SVec v = {x, y}; return v; }
+static inline SVec Sub(const SVec &a, const SVec &b)   { return Vec(a.x - b.x, a.y - b.y); }
+static inline SVec Add(const SVec &a, const SVec &b)   { return Vec(a.x + b.x, a.y + b.y); }
+static inline SVec Mul(const SVec &a, double s)        { return Vec(a.x*s, a.y*s); }
+static inline SVec Mix(const SVec &a, const SVec &b, double t) { return Vec(a.x + (b.x - a.x)*t, a.y + (b.y - a.y)*t); }
+static inline double Dot(const SVec &a, const SVec &b)   { return a.x*b.x + a.y*b.y; }
+static inline double Cross(const SVec &a, const SVec &b) { return a.x*b.y - a.y*b.x; }
+static inline double Length(const SVec &a)               { return sqrt(a.x*a.x + a.y*a.y); }
+static inline SVec Normalize(const SVec &a)
+{
+	double len = Length(a);
+	if( len == 0 ) return Vec(0, 1);
+	return Vec(a.x/len, a.y/len);
+}
+static inline double NonZeroSign(double v) { return v > 0 ? 1 : -1; }
+
+// A distance to an edge. When two edges are equally near, the one 
+// that is more orthogonal to the point, i.e. has the lower dot, is nearer
+struct SDistance
+{
+	double dist;
+	double dot;
+};
+
+static inline SDistance Distance(double dist, double dot) { SDistance d = {dist, dot}; return d; }
+static inline bool IsNearer(const SDistance &a, const SDistance &b)
+{
+	return fabs(a.dist) < fabs(b.dist) || (fabs(a.dist) == fabs(b.dist) && a.dot < b.dot);
+}
+
+typedef CGlyphShape::SEdge SEdge;
+
+static inline SVec Point(const SEdge &e, int n) { return Vec(e.x[n], e.y[n]); }
+
+static SVec PointAt(const SEdge &e, double t)
+{
+	if( e.type == e_line )
+		return Mix(Point(e, 0), Point(e, 1), t);
+	return Mix(Mix(Point(e, 0), Point(e, 1), t), Mix(Point(e, 1), Point(e, 2), t), t);
+}
+
+static SVec DirectionAt(const SEdge &e, double t)
+{
+	if( e.type == e_line )
+		return Sub(Point(e, 1), Point(e, 0));
+
+	SVec dir = Mix(Sub(Point(e, 1), Point(e, 0)), Sub(Point(e, 2), Point(e, 1)), t);
+	if( dir.x == 0 && dir.y == 0 )
+		return Sub(Point(e, 2), Point(e, 0));
+	return dir;
+}
+
+static SVec EndPoint(const SEdge &e)
+{
+	return e.type == e_line ? Point(e, 1) : Point(e, 2);
+}
+
+static int SolveQuadratic(double x[2], double a, double b, double c)
+{
+	if( fabs(a) < 1e-14 )
+	{
+		if( fabs(b) < 1e-14 )
+			return 0;
+		x[0] = -c/b;
+		return 1;
+	}
+
+	double dscr = b*b - 4*a*c;
+	if( dscr > 0 )
+	{
+		dscr = sqrt(dscr);
+		x[0] = (-b + dscr)/(2*a);
+		x[1] = (-b - dscr)/(2*a);
+		return 2;
+	}
+	else if( dscr == 0 )
+	{
+		x[0] = -b/(2*a);
+		return 1;
+	}
+	return 0;
+}
+
+// Solves x^3 + a*x^2 + b*x + c = 0
+static int SolveCubicNormed(double x[3], double a, double b, double c)
+{
+	double a2 = a*a;
+	double q  = (a2 - 3*b)/9;
+	double r  = (a*(2*a2 - 9*b) + 27*c)/54;
+	double r2 = r*r;
+	double q3 = q*q*q;
+	if( r2 < q3 )
+	{
+		double t = r/sqrt(q3);
+		if( t < -1 ) t = -1;
+		if( t > 1 ) t = 1;
+		t = acos(t);
+		a /= 3;
+		q = -2*sqrt(q);
+		x[0] = q*cos(t/3) - a;
+		x[1] = q*cos((t + 2*PI)/3) - a;
+		x[2] = q*cos((t - 2*PI)/3) - a;
+		return 3;
+	}
+
+	double A = -pow(fabs(r) + sqrt(r2 - q3), 1/3.0);
+	if( r < 0 ) A = -A;
+	double B = A == 0 ? 0 : q/A;
+	a /= 3;
+	x[0] = (A + B) - a;
+	x[1] = -0.5*(A + B) - a;
+	x[2] = 0.5*sqrt(3.0)*(A - B);
+	if( fabs(x[2]) < 1e-14 )
+		return 2;
+	return 1;
+}
+
+static int SolveCubic(double x[3], double a, double b, double c, double d)
+{
+	if( a != 0 )
+	{
+		double bn = b/a;
+		if( fabs(bn) < 1e6 )
+			return SolveCubicNormed(x, bn, c/a, d/a);
+	}
+	return SolveQuadratic(x, b, c, d);
+}
+
+// Returns the signed distance from the point to the edge, and the parameter of the 
+// nearest point on the edge. The parameter is outside 0-1 when the nearest point 
+// is one of the end points and the point is beyond the end of the edge
+static SDistance SignedDistance(const SEdge &e, const SVec &p, double &param)
+{
+	if( e.type == e_line )
+	{
+		SVec aq = Sub(p, Point(e, 0));
+		SVec ab = Sub(Point(e, 1), Point(e, 0));
+		param = Dot(aq, ab)/Dot(ab, ab);
+		SVec eq = Sub(param > 0.5 ? Point(e, 1) : Point(e, 0), p);
+		double endDist = Length(eq);
+		if( param > 0 && param < 1 )
+		{
+			double orthoDist = Cross(aq, Normalize(ab));
+			if( fabs(orthoDist) < endDist )
+				return Distance(orthoDist, 0);
+		}
+		return Distance(NonZeroSign(Cross(aq, ab))*endDist, fabs(Dot(Normalize(ab), Normalize(eq))));
+	}
+
+	SVec qa = Sub(Point(e, 0), p);
+	SVec ab = Sub(Point(e, 1), Point(e, 0));
+	SVec br = Sub(Sub(Point(e, 2), Point(e, 1)), ab);
+	double a = Dot(br, br);
+	double b = 3*Dot(ab, br);
+	double c = 2*Dot(ab, ab) + Dot(qa, br);
+	double d = Dot(qa, ab);
+	double t[3];
+	int solutions = SolveCubic(t, a, b, c, d);
+
+	// Start with the end points
+	SVec epDir = DirectionAt(e, 0);
+	double minDist = NonZeroSign(Cross(epDir, qa))*Length(qa);
+	param = -Dot(qa, epDir)/Dot(epDir, epDir);
+	{
+		epDir = DirectionAt(e, 1);
+		SVec cq = Sub(Point(e, 2), p);
+		double dist = Length(cq);
+		if( dist < fabs(minDist) )
+		{
+			minDist = NonZeroSign(Cross(epDir, cq))*dist;
+			param = Dot(Sub(p, Point(e, 1)), epDir)/Dot(epDir, epDir);
+		}
+	}
+
+	for( int n = 0; n < solutions; n++ )
+	{
+		if( t[n] > 0 && t[n] < 1 )
+		{
+			SVec qe = Add(Add(qa, Mul(ab, 2*t[n])), Mul(br, t[n]*t[n]));
+			double dist = Length(qe);
+			if( dist <= fabs(minDist) )
+			{
+				minDist = NonZeroSign(Cross(Add(ab, Mul(br, t[n])), qe))*dist;
+				param = t[n];
+			}
+		}
+	}
+
+	if( param >= 0 && param <= 1 )
+		return Distance(minDist, 0);
+	if( param < 0.5 )
+		return Distance(minDist, fabs(Dot(Normalize(DirectionAt(e, 0)), Normalize(qa))));
+	return Distance(minDist, fabs(Dot(Normalize(DirectionAt(e, 1)), Normalize(Sub(Point(e, 2), p)))));
+}
+
+// Beyond the ends of the edge the distance is measured to the line extended 
+// from the end. This is what keeps the corners sharp in the distance field
+static double PseudoDistance(const SEdge &e, const SVec &p, const SDistance &dist, double param)
+{
+	if( param < 0 )
+	{
+		SVec dir = Normalize(DirectionAt(e, 0));
+		SVec aq  = Sub(p, Point(e, 0));
+		if( Dot(aq, dir) < 0 )
+		{
+			double pseudo = Cross(aq, dir);
+			if( fabs(pseudo) <= fabs(dist.dist) )
+				return pseudo;
+		}
+	}
+	else if( param > 1 )
+	{
+		SVec dir = Normalize(DirectionAt(e, 1));
+		SVec bq  = Sub(p, EndPoint(e));
+		if( Dot(bq, dir) > 0 )
+		{
+			double pseudo = Cross(bq, dir);
+			if( fabs(pseudo) <= fabs(dist.dist) )
+				return pseudo;
+		}
+	}
+	return dist.dist;
+}
+
+static void SplitInThirds(const SEdge &e, SEdge parts[3])
+{
+	for( int n = 0; n < 3; n++ )
+		parts[n] = e;
+
+	SVec p1 = PointAt(e, 1/3.0);
+	SVec p2 = PointAt(e, 2/3.0);
+	if( e.type == e_line )
+	{
+		parts[0].x[1] = p1.x; parts[0].y[1] = p1.y;
+		parts[1].x[0] = p1.x; parts[1].y[0] = p1.y;
+		parts[1].x[1] = p2.x; parts[1].y[1] = p2.y;
+		parts[2].x[0] = p2.x; parts[2].y[0] = p2.y;
+	}
+	else
+	{
+		SVec a = Point(e, 0), b = Point(e, 1), c = Point(e, 2);
+		SVec c0 = Mix(a, b, 1/3.0);
+		SVec c1 = Mix(Mix(a, b, 5/9.0), Mix(b, c, 4/9.0), 0.5);
+		SVec c2 = Mix(b, c, 2/3.0);
+		parts[0].x[1] = c0.x; parts[0].y[1] = c0.y; parts[0].x[2] = p1.x; parts[0].y[2] = p1.y;
+		parts[1].x[0] = p1.x; parts[1].y[0] = p1.y; parts[1].x[1] = c1.x; parts[1].y[1] = c1.y; parts[1].x[2] = p2.x; parts[1].y[2] = p2.y;
+		parts[2].x[0] = p2.x; parts[2].y[0] = p2.y; parts[2].x[1] = c2.x; parts[2].y[1] = c2.y;
+	}
+}
+
+// Changes to a different color that doesn't share the single banned channel
+static void SwitchColor(int &color, int banned)
+{
+	int combined = color & banned;
+	if( combined == e_red || combined == e_green || combined == e_blue )
+	{
+		color = combined ^ e_white;
+		return;
+	}
+	if( color == e_black || color == e_white )
+	{
+		color = e_cyan;
+		return;
+	}
+	int shifted = color << 1;
+	color = (shifted | (shifted >> 3)) & e_white;
+}
+
+void CGlyphShape::BeginContour(double x, double y)
+{
+	contours.push_back(vector<SEdge>());
+	lastX = x;
+	lastY = y;
+}
+
+void CGlyphShape::LineTo(double x, double y)
+{
+	// Edges without length have no direction
+	if( x == lastX && y == lastY )
+		return;
+
+	SEdge e;
+	e.type  = e_line;
+	e.color = e_white;
+	e.x[0] = lastX; e.y[0] = lastY;
+	e.x[1] = x;     e.y[1] = y;
+	e.x[2] = x;     e.y[2] = y;
+	contours.back().push_back(e);
+
+	lastX = x;
+	lastY = y;
+}
+
+void CGlyphShape::QuadTo(double cx, double cy, double x, double y)
+{
+	// A curve with the control point on an end point is a line
+	if( (cx == lastX && cy == lastY) || (cx == x && cy == y) )
+	{
+		LineTo(x, y);
+		return;
+	}
+
+	SEdge e;
+	e.type  = e_quadratic;
+	e.color = e_white;
+	e.x[0] = lastX; e.y[0] = lastY;
+	e.x[1] = cx;    e.y[1] = cy;
+	e.x[2] = x;     e.y[2] = y;
+	contours.back().push_back(e);
+
+	lastX = x;
+	lastY = y;
+}
+
+void CGlyphShape::Transform(double scaleX, double offsetX, double scaleY, double offsetY)
+{
+	for( unsigned int c = 0; c < contours.size(); c++ )
+	{
+		for( unsigned int n = 0; n < contours[c].size(); n++ )
+		{
+			SEdge &e = contours[c][n];
+			for( int i = 0; i < 3; i++ )
+			{
+				e.x[i] = e.x[i]*scaleX + offsetX;
+				e.y[i] = e.y[i]*scaleY + offsetY;
+			}
+		}
+	}
+}
+
+bool CGlyphShape::IsEmpty() const
+{
+	for( unsigned int c = 0; c < contours.size(); c++ )
+		if( contours[c].size() )
+			return false;
+	return true;
+}
+
+void CGlyphShape::ColorEdges()
+{
+	// Edges meeting at an angle sharper than this are corners
+	const double crossThreshold = sin(3.0);
+
+	int color = e_white;
+	for( unsigned int c = 0; c < contours.size(); c++ )
+	{
+		vector<SEdge> &edges = contours[c];
+		if( edges.size() == 0 )
+			continue;
+
+		// Find the corners
+		vector<int> corners;
+		SVec prevDir = Normalize(DirectionAt(edges.back(), 1));
+		for( unsigned int n = 0; n < edges.size(); n++ )
+		{
+			SVec dir = Normalize(DirectionAt(edges[n], 0));
+			if( Dot(prevDir, dir) <= 0 || fabs(Cross(prevDir, dir)) > crossThreshold )
+				corners.push_back(n);
+			prevDir = Normalize(DirectionAt(edges[n], 1));
+		}
+
+		int m = edges.size();
+		if( corners.size() == 0 )
+		{
+			// A smooth contour uses the same edges in all channels
+			for( int n = 0; n < m; n++ )
+				edges[n].color = e_white;
+		}
+		else if( corners.size() == 1 )
+		{
+			// A teardrop shape. The contour is divided in three parts 
+			// so the corner gets different colors on each side
+			int colors[3] = {e_white, e_white, e_white};
+			SwitchColor(colors[0], e_black);
+			colors[2] = colors[0];
+			SwitchColor(colors[2], e_black);
+
+			int corner = corners[0];
+			if( m >= 3 )
+			{
+				for( int n = 0; n < m; n++ )
+				{
+					int third = int(3 + 2.875*n/(m-1) - 1.4375 + 0.5) - 3;
+					edges[(corner + n) % m].color = colors[1 + third];
+				}
+			}
+			else
+			{
+				// Too few edges, so they are split in thirds
+				SEdge parts[6];
+				int numParts;
+				SplitInThirds(edges[0], parts + 3*corner);
+				if( m >= 2 )
+				{
+					SplitInThirds(edges[1], parts + 3 - 3*corner);
+					parts[0].color = parts[1].color = colors[0];
+					parts[2].color = parts[3].color = colors[1];
+					parts[4].color = parts[5].color = colors[2];
+					numParts = 6;
+				}
+				else
+				{
+					parts[0].color = colors[0];
+					parts[1].color = colors[1];
+					parts[2].color = colors[2];
+					numParts = 3;
+				}
+				edges.assign(parts, parts + numParts);
+			}
+		}
+		else
+		{
+			// Switch the color at each corner, and make sure 
+			// the last part differs from the first part
+			int numCorners = corners.size();
+			int spline = 0;
+			int start = corners[0];
+			SwitchColor(color, e_black);
+			int initialColor = color;
+			for( int n = 0; n < m; n++ )
+			{
+				int index = (start + n) % m;
+				if( spline + 1 < numCorners && corners[spline+1] == index )
+				{
+					spline++;
+					SwitchColor(color, spline == numCorners-1 ? initialColor : e_black);
+				}
+				edges[index].color = color;
+			}
+		}
+	}
+}
+
+static inline double Median(double a, double b, double c)
+{
+	return max(min(a, b), min(max(a, b), c));
+}
+
+static inline DWORD DistanceToByte(double dist, double spread)
+{
+	int val = int(floor(128 + dist*128/spread + 0.5));
+	if( val < 0 ) val = 0;
+	else if( val > 255 ) val = 255;
+	return DWORD(val);
+}
+
+void CGlyphShape::GenerateMSDF(DWORD *dst, int width, int height, double originX, double originY, double pixelSize, double spread) const
+{
+	// The distances are signed by which side of the edge the point is on. 
+	// The inside is on the left or the right of the edges depending on the 
+	// orientation of the contours, which is determined from the total area
+	double area = 0;
+	for( unsigned int c = 0; c < contours.size(); c++ )
+	{
+		const vector<SEdge> &edges = contours[c];
+		for( unsigned int n = 0; n < edges.size(); n++ )
+		{
+			const SEdge &e = edges[n];
+			int last = e.type == e_line ? 1 : 2;
+			for( int i = 0; i < last; i++ )
+				area += e.x[i]*e.y[i+1] - e.x[i+1]*e.y[i];
+		}
+	}
+	double orientation = area < 0 ? 1 : -1;
+
+	const double far = 1e30;
+	for( int y = 0; y < height; y++ )
+	{
+		for( int x = 0; x < width; x++ )
+		{
+			SVec p = Vec(originX + (x + 0.5)*pixelSize, originY + (y + 0.5)*pixelSize);
+
+			SDistance minAll = Distance(far, 1);
+			SDistance minR = minAll, minG = minAll, minB = minAll;
+			const SEdge *edgeR = 0, *edgeG = 0, *edgeB = 0;
+			double paramR = 0, paramG = 0, paramB = 0;
+
+			for( unsigned int c = 0; c < contours.size(); c++ )
+			{
+				const vector<SEdge> &edges = contours[c];
+				for( unsigned int n = 0; n < edges.size(); n++ )
+				{
+					const SEdge &e = edges[n];
+					double param;
+					SDistance dist = SignedDistance(e, p, param);
+					if( IsNearer(dist, minAll) )
+						minAll = dist;
+					if( (e.color & e_red) && IsNearer(dist, minR) )
+					{
+						minR = dist; edgeR = &e; paramR = param;
+					}
+					if( (e.color & e_green) && IsNearer(dist, minG) )
+					{
+						minG = dist; edgeG = &e; paramG = param;
+					}
+					if( (e.color & e_blue) && IsNearer(dist, minB) )
+					{
+						minB = dist; edgeB = &e; paramB = param;
+					}
+				}
+			}
+
+			double r = edgeR ? PseudoDistance(*edgeR, p, minR, paramR) : -far;
+			double g = edgeG ? PseudoDistance(*edgeG, p, minG, paramG) : -far;
+			double b = edgeB ? PseudoDistance(*edgeB, p, minB, paramB) : -far;
+			double a = minAll.dist;
+
+			r *= orientation/pixelSize;
+			g *= orientation/pixelSize;
+			b *= orientation/pixelSize;
+			a *= orientation/pixelSize;
+
+			// Where the channels disagree with the true distance on which side 
+			// of the edge the pixel is, the median would give an artifact
+			if( (Median(r, g, b) > 0) != (a > 0) )
+				r = g = b = a;
+
+			dst[y*width+x] = (DistanceToByte(a, spread) << 24) | (DistanceToByte(r, spread) << 16) | 
+			                 (DistanceToByte(g, spread) << 8) | DistanceToByte(b, spread);
+		}
+	}
+}
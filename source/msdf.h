@@ -0,0 +1,74 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef MSDF_H
+#define MSDF_H
+
+#include "platform.h"
+#include <vector>
+
+// The outline of a glyph as contours of lines and quadratic curves, 
+// used for generating the multi-channel signed distance field. The 
+// contours must be closed, i.e. end where they start.
+class CGlyphShape
+{
+public:
+	void BeginContour(double x, double y);
+	void LineTo(double x, double y);
+	void QuadTo(double cx, double cy, double x, double y);
+
+	// Moves the points to new coordinates: x' = x*scaleX + offsetX
+	void Transform(double scaleX, double offsetX, double scaleY, double offsetY);
+
+	bool IsEmpty() const;
+
+	// Assigns the colors to the edges so the corners get different 
+	// colors on each side. Must be done before generating the field
+	void ColorEdges();
+
+	// Generates the distance field for width x height pixels. The center of 
+	// pixel (x,y) is at (originX + (x+0.5)*pixelSize, originY + (y+0.5)*pixelSize) 
+	// in the shape coordinates. The distance from -spread to +spread pixels is 
+	// mapped to the values 0-255 in the red, green and blue channels, and the 
+	// true signed distance is stored in the alpha channel in the same way.
+	void GenerateMSDF(DWORD *dst, int width, int height, double originX, double originY, double pixelSize, double spread) const;
+
+	struct SEdge
+	{
+		int    type;  // 1 for lines, 2 for quadratic curves
+		int    color; // The channels that use the edge, 1 = blue, 2 = green, 4 = red
+		double x[3];
+		double y[3];
+	};
+
+protected:
+	double lastX;
+	double lastY;
+	std::vector< std::vector<SEdge> > contours;
+};
+
+#endif
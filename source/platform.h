@@ -0,0 +1,136 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// The generator core is written against the Windows API types. This header 
+// includes windows.h on Windows, and defines the types and the few CRT 
+// functions used by the core on other platforms, so the core can be built 
+// without the window system for the command line tool.
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+
+typedef uint8_t        BYTE;
+typedef uint16_t       WORD;
+typedef uint32_t       DWORD;
+typedef int32_t        LONG;
+typedef unsigned int   UINT;
+typedef int            BOOL;
+typedef char           TCHAR;
+typedef int            errno_t;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#define __cdecl
+
+struct POINT
+{
+	LONG x;
+	LONG y;
+};
+
+struct KERNINGPAIR
+{
+	WORD wFirst;
+	WORD wSecond;
+	int  iKernAmount;
+};
+
+struct ABC
+{
+	int  abcA;
+	UINT abcB;
+	int  abcC;
+};
+
+// Character sets, with the same values as in wingdi.h
+#define ANSI_CHARSET        0
+#define DEFAULT_CHARSET     1
+#define SYMBOL_CHARSET      2
+#define SHIFTJIS_CHARSET    128
+#define HANGUL_CHARSET      129
+#define GB2312_CHARSET      134
+#define CHINESEBIG5_CHARSET 136
+#define OEM_CHARSET         255
+#define JOHAB_CHARSET       130
+#define HEBREW_CHARSET      177
+#define ARABIC_CHARSET      178
+#define GREEK_CHARSET       161
+#define TURKISH_CHARSET     162
+#define VIETNAMESE_CHARSET  163
+#define THAI_CHARSET        222
+#define EASTEUROPE_CHARSET  238
+#define RUSSIAN_CHARSET     204
+#define MAC_CHARSET         77
+#define BALTIC_CHARSET      186
+
+inline int _stricmp(const char *a, const char *b)
+{
+	return strcasecmp(a, b);
+}
+
+inline int _strnicmp(const char *a, const char *b, size_t n)
+{
+	return strncasecmp(a, b, n);
+}
+
+#define _vsnprintf vsnprintf
+
+inline errno_t fopen_s(FILE **f, const char *name, const char *mode)
+{
+	*f = fopen(name, mode);
+	return *f ? 0 : errno;
+}
+
+inline void Sleep(DWORD ms)
+{
+	usleep(ms*1000);
+}
+
+inline DWORD GetCurrentProcessId()
+{
+	return (DWORD)getpid();
+}
+
+#endif
+
+#endif
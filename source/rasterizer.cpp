@@ -0,0 +1,145 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+// The algorithm is the same as used by font-rs and stb_truetype. Each edge adds 
+// the area it covers to the left of it in the cells it crosses, and the area 
+// to the right in the following cell. The running sum along the scanline then 
+// gives the coverage of each pixel, since the edges of a closed polygon cancel 
+// each other out.
+
+#include <math.h>
+#include "rasterizer.h"
+
+CGlyphRasterizer::CGlyphRasterizer()
+{
+	width  = 0;
+	height = 0;
+}
+
+void CGlyphRasterizer::Reset(int w, int h)
+{
+	width  = w;
+	height = h;
+
+	// The edges on the right border add to the cell after the last one
+	cells.assign(width*height + 4, 0.0f);
+}
+
+void CGlyphRasterizer::AddLine(float x0, float y0, float x1, float y1)
+{
+	if( y0 == y1 )
+		return;
+
+	// Clamp the edge to the image so it doesn't write outside the cells
+	if( x0 < 0 ) x0 = 0; else if( x0 > width ) x0 = float(width);
+	if( x1 < 0 ) x1 = 0; else if( x1 > width ) x1 = float(width);
+
+	// Edges going up subtract from the coverage
+	float dir = 1;
+	if( y0 > y1 )
+	{
+		float t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		dir = -1;
+	}
+
+	float dxdy = (x1 - x0)/(y1 - y0);
+	float x = x0;
+	if( y0 < 0 )
+	{
+		x -= y0*dxdy;
+		y0 = 0;
+	}
+
+	int yEnd = int(ceilf(y1));
+	if( yEnd > height ) yEnd = height;
+	for( int y = int(y0); y < yEnd; y++ )
+	{
+		float *row = &cells[y*width];
+
+		// The part of the edge that is in this scanline
+		float dy = (y + 1 < y1 ? y + 1 : y1) - (y > y0 ? y : y0);
+		float xNext = x + dxdy*dy;
+		float d = dy*dir;
+
+		float xa = x < xNext ? x : xNext;
+		float xb = x < xNext ? xNext : x;
+		float xaFloor = floorf(xa);
+		int   xai = int(xaFloor);
+		float xbCeil = ceilf(xb);
+		int   xbi = int(xbCeil);
+
+		if( xbi <= xai + 1 )
+		{
+			// The edge is within a single cell
+			float xm = 0.5f*(x + xNext) - xaFloor;
+			row[xai]   += d - d*xm;
+			row[xai+1] += d*xm;
+		}
+		else
+		{
+			// The edge crosses several cells. The area is split so that 
+			// the first and last cells get triangles, and the cells in 
+			// between get equal parts
+			float s = 1/(xb - xa);
+			float xaf = xa - xaFloor;
+			float a0 = 0.5f*s*(1 - xaf)*(1 - xaf);
+			float xbf = xb - xbCeil + 1;
+			float am = 0.5f*s*xbf*xbf;
+			row[xai] += d*a0;
+			if( xbi == xai + 2 )
+				row[xai+1] += d*(1 - a0 - am);
+			else
+			{
+				float a1 = s*(1.5f - xaf);
+				row[xai+1] += d*(a1 - a0);
+				for( int xi = xai + 2; xi < xbi - 1; xi++ )
+					row[xi] += d*s;
+				float a2 = a1 + (xbi - xai - 3)*s;
+				row[xbi-1] += d*(1 - a2 - am);
+			}
+			row[xbi] += d*am;
+		}
+
+		x = xNext;
+	}
+}
+
+void CGlyphRasterizer::GetCoverage(BYTE *dst) const
+{
+	// The sum runs over the whole buffer, as the cells of 
+	// each scanline together add up to zero
+	float acc = 0;
+	for( int n = 0; n < width*height; n++ )
+	{
+		acc += cells[n];
+		float c = fabsf(acc);
+		if( c > 1 ) c = 1;
+		dst[n] = BYTE(c*255 + 0.5f);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+   AngelCode Bitmap Font Generator
+   Copyright (c) 2004-2014 Andreas Jonsson
+  
+   This software is provided 'as-is', without any express or implied 
+   warranty. In no event will the authors be held liable for any 
+   damages arising from the use of this software.
+
+   Permission is granted to anyone to use this software for any 
+   purpose, including commercial applications, and to alter it and 
+   redistribute it freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you 
+      must not claim that you wrote the original software. If you use
+      this software in a product, an acknowledgment in the product 
+      documentation would be appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and 
+      must not be misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source 
+      distribution.
+  
+   Andreas Jonsson
+   andreas@angelcode.com
+*/
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include "platform.h"
+#include <vector>
+
+// Rasterizes polygons with exact coverage, by accumulating the signed area 
+// that each edge covers in each pixel cell and then summing the cells along 
+// the scanlines. The coverage is computed with the non-zero winding rule, as 
+// used by TrueType. It uses no GDI objects so it can be used by any thread.
+class CGlyphRasterizer
+{
+public:
+	CGlyphRasterizer();
+
+	// Clears the accumulation buffer for a new image
+	void Reset(int width, int height);
+
+	// Adds an edge of the polygons. The coordinates are in pixels with y 
+	// pointing down, and must be within the image. The polygons must be 
+	// closed, but the order in which the edges are added doesn't matter
+	void AddLine(float x0, float y0, float x1, float y1);
+
+	// Writes the coverage of each pixel as 0-255 in width x height pixels
+	void GetCoverage(BYTE *dst) const;
+
+protected:
+	int width;
+	int height;
+	std::vector<float> cells;
+};
+
+#endif
@@ -25,17 +25,21 @@
    andreas@angelcode.com
 */
 
-#include <windows.h>
+#include "platform.h"
 #include <stdio.h>
 #include <assert.h>
 #include <map>
 using std::map;
 
+#ifdef _WIN32
 #include "dynamic_funcs.h"
+#endif
 #include "ac_string_util.h"
 #include "acutil_unicode.h"
 
 #include "unicode.h"
+#include "fontbackend.h"
+#include "chartable.h"
 
 // These are the defined character sets from the Unicode 6.2 standard
 // http://www.unicode.org/charts/PDF/
@@ -460,6 +464,7 @@ int GetCharSet(const char *charSetName)
 	return set;
 }
 
+#ifdef _WIN32
 int GetUnicodeGlyphIndex(HDC dc, SCRIPT_CACHE *sc, UINT ch)
 {
 	SCRIPT_CACHE mySc = 0;
@@ -509,23 +514,6 @@ int GetUnicodeGlyphIndex(HDC dc, SCRIPT_CACHE *sc, UINT ch)
 	return glyphs[0];
 }
 
-int DoesUnicodeCharExist(HDC dc, SCRIPT_CACHE *sc, UINT ch)
-{
-	int idx = GetUnicodeGlyphIndex(dc, sc, ch);
-	
-	if( idx < 0 ) 
-		return 0;
-
-	SCRIPT_FONTPROPERTIES props;
-	props.cBytes = sizeof(props);
-	ScriptGetFontProperties(dc, sc, &props);	
-	
-	if( idx != props.wgDefault )
-		return 1;
-
-	return 0;
-}
-
 int GetUnicodeCharABCWidths(HDC dc, SCRIPT_CACHE *sc, UINT ch, ABC *abc)
 {
 	SCRIPT_CACHE mySc = 0;
@@ -548,6 +536,7 @@ int GetUnicodeCharABCWidths(HDC dc, SCRIPT_CACHE *sc, UINT ch, ABC *abc)
 	if( mySc ) ScriptFreeCache(&mySc);
 	return 0;
 }
+#endif
 
 //=================================================================================
 // The functions below are all for extracting kerning data from the GPOS table
@@ -628,6 +617,7 @@ vector<UINT> GetGlyphsFromClassDef(BYTE *classDef, UINT classId)
 	return glyphs;
 }
 
+#ifdef _WIN32
 float DetermineDesignUnitToFontUnitFactor(HDC dc)
 {
 	OUTLINETEXTMETRIC tm;
@@ -652,8 +642,35 @@ float DetermineDesignUnitToFontUnitFactor(HDC dc)
 
 	return 1;
 }
+#endif
 
-void AddKerningPairToList(HDC dc, UINT glyphId1, UINT glyphId2, int kerning, vector<KERNINGPAIR> &pairs, float scaleFactor, map<UINT,vector<UINT>> &glyphIdToChar)
+// Rounds the same way as AddKerningPairToList, so scaling pairs read in design 
+// units gives the same result as reading them with the scale factor directly
+static int ScaleKerning(int kerning, float scaleFactor)
+{
+	float kern = kerning*scaleFactor;
+	if( kern < 0 )
+		return int(kern-0.5f);
+
+	return int(kern+0.5f);
+}
+
+void ScaleKerningPairs(const vector<KERNINGPAIR> &designPairs, float scaleFactor, vector<KERNINGPAIR> &pairs)
+{
+	pairs.clear();
+	pairs.reserve(designPairs.size());
+	for( unsigned int n = 0; n < designPairs.size(); n++ )
+	{
+		KERNINGPAIR pair = designPairs[n];
+		pair.iKernAmount = ScaleKerning(pair.iKernAmount, scaleFactor);
+
+		// Skip 0 kernings
+		if( pair.iKernAmount != 0 )
+			pairs.push_back(pair);
+	}
+}
+
+void AddKerningPairToList(UINT glyphId1, UINT glyphId2, int kerning, vector<KERNINGPAIR> &pairs, float scaleFactor, map<UINT,vector<UINT>> &glyphIdToChar)
 {
 	assert(kerning != 0);
 
@@ -669,11 +686,7 @@ void AddKerningPairToList(HDC dc, UINT glyphId1, UINT glyphId2, int kerning, vec
 				return;
 
 			// Convert from design units to the selected font size
-			float kern = kerning*scaleFactor;
-			if( kern < 0 )
-				pair.iKernAmount = int(kern-0.5f);
-			else
-				pair.iKernAmount = int(kern+0.5f);
+			pair.iKernAmount = ScaleKerning(kerning, scaleFactor);
 
 			// Skip 0 kernings
 			if( pair.iKernAmount == 0 )
@@ -721,7 +734,7 @@ short GetXAdvance(BYTE *value, WORD valueType)
 	return GETSHORT(value+offset);
 }
 
-void ProcessPairAdjustmentFormat1(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
+void ProcessPairAdjustmentFormat1(BYTE *subTable, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
 {
 	// Defines kerning between two individual glyphs
 
@@ -763,7 +776,7 @@ void ProcessPairAdjustmentFormat1(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &p
 
 				if( xAdv1 != 0 )
 				{
-					AddKerningPairToList(dc, glyphId1, glyphId2, xAdv1, pairs, scaleFactor, glyphIdToChar);
+					AddKerningPairToList(glyphId1, glyphId2, xAdv1, pairs, scaleFactor, glyphIdToChar);
 				}
 			}
 		}
@@ -777,7 +790,7 @@ void ProcessPairAdjustmentFormat1(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &p
 	}
 }
 
-void ProcessPairAdjustmentFormat2(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
+void ProcessPairAdjustmentFormat2(BYTE *subTable, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
 {
 	// Defines kerning between two classes of glyphs
 
@@ -859,7 +872,7 @@ void ProcessPairAdjustmentFormat2(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &p
 					// Add a kerning pair for each combination of glyphs in each of the classes
 					for( UINT n = 0; n < glyph2.size(); n++ )
 					{
-						AddKerningPairToList(dc, glyph1[g], glyph2[n], xAdv1, pairs, scaleFactor, glyphIdToChar);
+						AddKerningPairToList(glyph1[g], glyph2[n], xAdv1, pairs, scaleFactor, glyphIdToChar);
 					}
 				}
 			}
@@ -867,7 +880,7 @@ void ProcessPairAdjustmentFormat2(HDC dc, BYTE *subTable, vector<KERNINGPAIR> &p
 	}
 }
 
-void ProcessKernFeature(HDC dc, BYTE *featureRecord, BYTE *featureList, BYTE *lookupList, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
+void ProcessKernFeature(BYTE *featureRecord, BYTE *featureList, BYTE *lookupList, vector<KERNINGPAIR> &pairs, map<UINT,vector<UINT>> &glyphIdToChar, float scaleFactor)
 {
 	WORD offset = GETUSHORT(featureRecord+4);
 
@@ -915,9 +928,9 @@ void ProcessKernFeature(HDC dc, BYTE *featureRecord, BYTE *featureList, BYTE *lo
 				{
 					WORD posFormat    = GETUSHORT(subTable);
 					if( posFormat == 1 )
-						ProcessPairAdjustmentFormat1(dc, subTable, pairs, glyphIdToChar, scaleFactor);
+						ProcessPairAdjustmentFormat1(subTable, pairs, glyphIdToChar, scaleFactor);
 					else if( posFormat == 2 )
-						ProcessPairAdjustmentFormat2(dc, subTable, pairs, glyphIdToChar, scaleFactor);
+						ProcessPairAdjustmentFormat2(subTable, pairs, glyphIdToChar, scaleFactor);
 					else
 						assert(false);
 				}
@@ -926,35 +939,21 @@ void ProcessKernFeature(HDC dc, BYTE *featureRecord, BYTE *featureList, BYTE *lo
 	}
 }
 
-void GetKerningPairsFromGPOS(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &chars)
+void GetKerningPairsFromGPOS(CFontBackend *font, vector<KERNINGPAIR> &pairs, vector<UINT> &chars, float scaleFactor)
 {
-	// Determine the factor for scaling down the values from the design units to the font size
-	float scaleFactor = DetermineDesignUnitToFontUnitFactor(dc);
-
-	// TODO: support non unicode as well
 	// Build a glyphId to char map. Multiple characters may use  
 	// the same glyph, e.g. space, 32, and hard space, 160.
-	SCRIPT_CACHE sc = 0;
 	map<UINT,vector<UINT>> glyphIdToChar;
 	for( UINT n = 0; n < chars.size(); n++ )
 	{
-		int glyphId = GetUnicodeGlyphIndex(dc, &sc, chars[n]);
+		int glyphId = font->GetGlyphIndex(chars[n]);
 		if( glyphId >= 0 )
 			glyphIdToChar[glyphId].push_back(chars[n]);
 	}
-	if( sc )
-		ScriptFreeCache(&sc);
 
 	// Load the GPOS table from the TrueType font file
 	vector<BYTE> buffer;
-	DWORD GPOS = TAG('G','P','O','S');
-	DWORD size = GetFontData(dc, GPOS, 0, 0, 0);
-	if( size != GDI_ERROR )
-	{
-		buffer.resize(size);
-		size = GetFontData(dc, GPOS, 0, &buffer[0], size);
-	}
-	if( size == GDI_ERROR || size == 0 )
+	if( font->GetFontTable(TAG('G','P','O','S'), buffer) < 0 )
 		return;
 
 	// Get the GPOS header info
@@ -1012,7 +1011,7 @@ void GetKerningPairsFromGPOS(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &c
 			DWORD tag = *(DWORD*)(featureRecord);
 			if( tag == TAG('k','e','r','n') )
 			{
-				ProcessKernFeature(dc, featureRecord, featureList, lookupList, pairs, glyphIdToChar, scaleFactor);
+				ProcessKernFeature(featureRecord, featureList, lookupList, pairs, glyphIdToChar, scaleFactor);
 			}
 		}
 	}
@@ -1027,33 +1026,21 @@ void GetKerningPairsFromGPOS(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &c
 //
 
 
-void GetKerningPairsFromKERN(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &chars)
+void GetKerningPairsFromKERN(CFontBackend *font, vector<KERNINGPAIR> &pairs, vector<UINT> &chars, float scaleFactor)
 {
-	// Determine the factor for scaling down the values from the design units to the font size
-	float scaleFactor = DetermineDesignUnitToFontUnitFactor(dc);
-
-	// TODO: support non unicode as well
 	// Build a glyphId to char map. Multiple characters may use  
 	// the same glyph, e.g. space, 32, and hard space, 160.
 	map<UINT,vector<UINT>> glyphIdToChar;
 	for( UINT n = 0; n < chars.size(); n++ )
 	{
-		SCRIPT_CACHE sc;
-		int glyphId = GetUnicodeGlyphIndex(dc, &sc, chars[n]);
+		int glyphId = font->GetGlyphIndex(chars[n]);
 		if( glyphId >= 0 )
 			glyphIdToChar[glyphId].push_back(chars[n]);
 	}
 
 	// Load the KERN table from the TrueType font file
 	vector<BYTE> buffer;
-	DWORD KERN = TAG('k','e','r','n');
-	DWORD size = GetFontData(dc, KERN, 0, 0, 0);
-	if( size != GDI_ERROR )
-	{
-		buffer.resize(size);
-		size = GetFontData(dc, KERN, 0, &buffer[0], size);
-	}
-	if( size == GDI_ERROR || size == 0 )
+	if( font->GetFontTable(TAG('k','e','r','n'), buffer) < 0 )
 		return;
 
 	// Get the KERN header info
@@ -1091,7 +1078,7 @@ void GetKerningPairsFromKERN(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &c
 						short value = GETSHORT(&buffer[pos+18+c*6]);
 
 						if( value )
-							AddKerningPairToList(dc, left, right, value, pairs, scaleFactor, glyphIdToChar);
+							AddKerningPairToList(left, right, value, pairs, scaleFactor, glyphIdToChar);
 					}
 				}
 				else if( format == 2 )
@@ -1115,4 +1102,121 @@ void GetKerningPairsFromKERN(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &c
 
 		pos += length;
 	}
-}
\ No newline at end of file
+}
+
+//=================================================================================
+// Reads the characters that the font has glyphs for from the cmap table
+//
+// Reference: http://www.microsoft.com/typography/otspec/cmap.htm
+//
+
+static void SetCMAPChar(CCharSet &chars, UINT ch, UINT glyphId)
+{
+	// Glyph 0 is the .notdef glyph, i.e. the character doesn't exist. The 
+	// surrogates are not characters, even if a broken font maps them.
+	if( glyphId != 0 && ch < (UINT)charTableSize && (ch < 0xD800 || ch > 0xDFFF) )
+		chars.Set(ch, true);
+}
+
+static int GetCharsFromCMAPFormat4(const vector<BYTE> &buffer, UINT pos, CCharSet &chars)
+{
+	if( pos + 14 > buffer.size() )
+		return -1;
+
+	UINT segCount = GETUSHORT(&buffer[pos+6])/2;
+	UINT endCodes = pos + 14;
+	UINT startCodes = endCodes + segCount*2 + 2;
+	UINT idDeltas = startCodes + segCount*2;
+	UINT idRangeOffsets = idDeltas + segCount*2;
+	if( idRangeOffsets + segCount*2 > buffer.size() )
+		return -1;
+
+	for( UINT seg = 0; seg < segCount; seg++ )
+	{
+		UINT endCode       = GETUSHORT(&buffer[endCodes + seg*2]);
+		UINT startCode     = GETUSHORT(&buffer[startCodes + seg*2]);
+		WORD idDelta       = GETUSHORT(&buffer[idDeltas + seg*2]);
+		UINT idRangeOffset = GETUSHORT(&buffer[idRangeOffsets + seg*2]);
+
+		for( UINT ch = startCode; ch <= endCode && ch != 0xFFFF; ch++ )
+		{
+			if( idRangeOffset == 0 )
+			{
+				SetCMAPChar(chars, ch, WORD(ch + idDelta));
+				continue;
+			}
+
+			// The offset is relative to the position of the idRangeOffset itself
+			UINT glyphPos = idRangeOffsets + seg*2 + idRangeOffset + (ch - startCode)*2;
+			if( glyphPos + 2 > buffer.size() )
+				break;
+
+			WORD glyphId = GETUSHORT(&buffer[glyphPos]);
+			if( glyphId != 0 )
+				SetCMAPChar(chars, ch, WORD(glyphId + idDelta));
+		}
+	}
+
+	return 0;
+}
+
+static int GetCharsFromCMAPFormat12(const vector<BYTE> &buffer, UINT pos, CCharSet &chars)
+{
+	if( pos + 16 > buffer.size() )
+		return -1;
+
+	UINT numGroups = GETUINT(&buffer[pos+12]);
+	if( numGroups > (buffer.size() - pos - 16)/12 )
+		return -1;
+
+	for( UINT group = 0; group < numGroups; group++ )
+	{
+		UINT startChar  = GETUINT(&buffer[pos + 16 + group*12]);
+		UINT endChar    = GETUINT(&buffer[pos + 20 + group*12]);
+		UINT startGlyph = GETUINT(&buffer[pos + 24 + group*12]);
+
+		if( endChar >= (UINT)charTableSize )
+			endChar = charTableSize - 1;
+		for( UINT ch = startChar; ch <= endChar; ch++ )
+			SetCMAPChar(chars, ch, startGlyph + (ch - startChar));
+	}
+
+	return 0;
+}
+
+int GetCharsFromCMAP(CFontBackend *font, CCharSet &chars)
+{
+	vector<BYTE> buffer;
+	if( font->GetFontTable(TAG('c','m','a','p'), buffer) < 0 || buffer.size() < 4 )
+		return -1;
+
+	// Find the Unicode subtables. A subtable with the full Unicode range 
+	// is preferred over one that only covers the basic multilingual plane.
+	UINT bmpTable = 0, fullTable = 0;
+	WORD numTables = GETUSHORT(&buffer[2]);
+	for( UINT n = 0; n < numTables && 12 + n*8 <= buffer.size(); n++ )
+	{
+		WORD platformId = GETUSHORT(&buffer[4 + n*8]);
+		WORD encodingId = GETUSHORT(&buffer[6 + n*8]);
+		UINT offset     = GETUINT(&buffer[8 + n*8]);
+		if( offset + 2 > buffer.size() )
+			continue;
+
+		WORD format = GETUSHORT(&buffer[offset]);
+		bool isUnicode = platformId == 0 || (platformId == 3 && (encodingId == 1 || encodingId == 10));
+		if( isUnicode && format == 12 && fullTable == 0 )
+			fullTable = offset;
+		else if( isUnicode && format == 4 && bmpTable == 0 )
+			bmpTable = offset;
+	}
+
+	// Fonts without a Unicode subtable, e.g. symbol fonts, 
+	// must be checked with the font system for each character
+	chars.SetAll(false);
+	if( fullTable )
+		return GetCharsFromCMAPFormat12(buffer, fullTable, chars);
+	if( bmpTable )
+		return GetCharsFromCMAPFormat4(buffer, bmpTable, chars);
+
+	return -1;
+}
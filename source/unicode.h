@@ -30,10 +30,16 @@
 
 #include <string>
 #include <vector>
+#include "platform.h"
+#ifdef _WIN32
 #include <Usp10.h>
+#endif
 using std::string;
 using std::vector;
 
+class CFontBackend;
+class CCharSet;
+
 // Interesting links
 //
 // http://msdn.microsoft.com/library/default.asp?url=/library/en-us/intl/unicode_63ub.asp
@@ -58,11 +64,22 @@ string GetCharSetName(int charSet);
 int GetCharSet(const char *charSetName);
 int GetSubsetFromChar(unsigned int chr);
 
-int DoesUnicodeCharExist(HDC dc, SCRIPT_CACHE *sc, UINT ch);
+#ifdef _WIN32
 int GetUnicodeCharABCWidths(HDC dc, SCRIPT_CACHE *sc, UINT ch, ABC *abc);
 int GetUnicodeGlyphIndex(HDC dc, SCRIPT_CACHE *sc, UINT ch);
 
-void GetKerningPairsFromGPOS(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &chars);
-void GetKerningPairsFromKERN(HDC dc, vector<KERNINGPAIR> &pairs, vector<UINT> &chars);
+float DetermineDesignUnitToFontUnitFactor(HDC dc);
+#endif
+
+// Reads the kerning pairs from the font tables, for the given characters. The 
+// scale factor converts the design units, so with 1 the pairs can be scaled 
+// to other sizes later with ScaleKerningPairs
+void GetKerningPairsFromGPOS(CFontBackend *font, vector<KERNINGPAIR> &pairs, vector<UINT> &chars, float scaleFactor);
+void GetKerningPairsFromKERN(CFontBackend *font, vector<KERNINGPAIR> &pairs, vector<UINT> &chars, float scaleFactor);
+void ScaleKerningPairs(const vector<KERNINGPAIR> &designPairs, float scaleFactor, vector<KERNINGPAIR> &pairs);
+
+// Reads the characters that the font has glyphs for from the Unicode subtable of the 
+// cmap table. Returns -1 if the font doesn't have a Unicode subtable in format 4 or 12.
+int GetCharsFromCMAP(CFontBackend *font, CCharSet &chars);
 
 #endif
\ No newline at end of file